@@ -0,0 +1,342 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/simulator.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv6-static-routing-helper.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/arp-cache.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/ndisc-cache.h"
+#include "ns3/uinteger.h"
+#include "icmp-topology.h"
+
+#include <chrono>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("IcmpTopology");
+
+IcmpTopology::IcmpTopology (Shape shape, uint32_t nodes)
+  : m_shape (shape),
+    m_routing (ALL_PAIRS),
+    m_channel ("ns3::SimpleChannel"),
+    m_setupSeconds (0),
+    m_routingSeconds (0),
+    m_arpQueueSize (0),
+    m_ndiscQueueSize (0),
+    m_queueSizeChanged (false)
+{
+  NS_LOG_FUNCTION (this << shape << nodes);
+  NS_ASSERT_MSG (nodes >= 2, "A topology needs at least 2 nodes");
+  m_nodes.Create (nodes);
+}
+
+void
+IcmpTopology::SetRouting (Routing routing)
+{
+  NS_LOG_FUNCTION (this << routing);
+  NS_ASSERT_MSG (m_links.empty (), "Routing must be set before Build");
+  m_routing = routing;
+}
+
+void
+IcmpTopology::SetChannel (ObjectFactory const &factory)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_links.empty (), "The channel must be set before Build");
+  m_channel = factory;
+}
+
+void
+IcmpTopology::Build (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode (true);
+  uint32_t links = m_nodes.GetN () - 1;
+  m_links.resize (links);
+  for (uint32_t j = 0; j < links; j++)
+    {
+      NodeContainer ends;
+      ends.Add (m_nodes.Get (m_shape == CHAIN ? j : 0));
+      ends.Add (m_nodes.Get (j + 1));
+      m_links[j] = simpleHelper.Install (ends, m_channel.Create<SimpleChannel> ());
+    }
+
+  InternetStackHelper internet;
+  internet.Install (m_nodes);
+
+  Ipv4AddressHelper ipv4;
+  Ipv6AddressHelper ipv6;
+  m_ipv4.resize (links);
+  m_ipv6.resize (links);
+  for (uint32_t j = 0; j < links; j++)
+    {
+      ipv4.SetBase (Ipv4Address (0x0a000000 | (j << 8)), Ipv4Mask ("255.255.255.0"));
+      m_ipv4[j] = ipv4.Assign (m_links[j]);
+      ipv6.SetBase (GetIpv6Host (j, 0), Ipv6Prefix (64));
+      m_ipv6[j] = ipv6.Assign (m_links[j]);
+    }
+
+  // the caches all start from the attribute defaults, so one of each gives them
+  Ptr<Ipv4L3Protocol> firstIpv4 = m_nodes.Get (0)->GetObject<Ipv4L3Protocol> ();
+  UintegerValue queueSize;
+  firstIpv4->GetInterface (m_ipv4[0].Get (0).second)->GetArpCache ()->GetAttribute ("PendingQueueSize", queueSize);
+  m_arpQueueSize = queueSize.Get ();
+  Ptr<Ipv6L3Protocol> firstIpv6 = m_nodes.Get (0)->GetObject<Ipv6L3Protocol> ();
+  firstIpv6->GetInterface (m_ipv6[0].GetInterfaceIndex (0))->GetNdiscCache ()->GetAttribute ("UnresolvedQueueSize", queueSize);
+  m_ndiscQueueSize = queueSize.Get ();
+
+  std::chrono::steady_clock::time_point routingStart = std::chrono::steady_clock::now ();
+  if (m_routing == ALL_PAIRS)
+    {
+      Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+    }
+
+  Ipv4StaticRoutingHelper ipv4RoutingHelper;
+  Ipv6StaticRoutingHelper routingHelper;
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4> ipv4Node = m_nodes.Get (i)->GetObject<Ipv4> ();
+      Ptr<Ipv4StaticRouting> ipv4Routing = ipv4RoutingHelper.GetStaticRouting (ipv4Node);
+      Ptr<Ipv6> node = m_nodes.Get (i)->GetObject<Ipv6> ();
+      Ptr<Ipv6StaticRouting> routing = routingHelper.GetStaticRouting (node);
+      if (m_shape == STAR)
+        {
+          if (i == 0)
+            {
+              for (uint32_t j = 0; j < links; j++)
+                {
+                  node->SetForwarding (m_ipv6[j].GetInterfaceIndex (0), true);
+                }
+            }
+          else
+            {
+              routing->SetDefaultRoute (m_ipv6[i - 1].GetAddress (0, 1), m_ipv6[i - 1].GetInterfaceIndex (1));
+              if (m_routing == FROM_FIRST)
+                {
+                  ipv4Routing->SetDefaultRoute (m_ipv4[i - 1].GetAddress (0), m_ipv4[i - 1].Get (1).second);
+                }
+            }
+          continue;
+        }
+      // chain: the links left of node i - 1 through the left neighbor, the rest to the right
+      if (i > 0 && i < links)
+        {
+          node->SetForwarding (m_ipv6[i - 1].GetInterfaceIndex (1), true);
+          node->SetForwarding (m_ipv6[i].GetInterfaceIndex (0), true);
+        }
+      if (i < links)
+        {
+          routing->SetDefaultRoute (m_ipv6[i].GetAddress (1, 1), m_ipv6[i].GetInterfaceIndex (0));
+          for (uint32_t j = 0; j + 1 < i && (j == 0 || m_routing == ALL_PAIRS); j++)
+            {
+              routing->AddNetworkRouteTo (GetIpv6Host (j, 0), Ipv6Prefix (64),
+                                          m_ipv6[i - 1].GetAddress (0, 1), m_ipv6[i - 1].GetInterfaceIndex (1));
+            }
+        }
+      else
+        {
+          routing->SetDefaultRoute (m_ipv6[i - 1].GetAddress (0, 1), m_ipv6[i - 1].GetInterfaceIndex (1));
+        }
+      if (m_routing == FROM_FIRST)
+        {
+          if (i < links)
+            {
+              ipv4Routing->SetDefaultRoute (m_ipv4[i].GetAddress (1), m_ipv4[i].Get (0).second);
+              if (i > 1)
+                {
+                  ipv4Routing->AddNetworkRouteTo (Ipv4Address (0x0a000000), Ipv4Mask ("255.255.255.0"),
+                                                  m_ipv4[i - 1].GetAddress (0), m_ipv4[i - 1].Get (1).second);
+                }
+            }
+          else
+            {
+              ipv4Routing->SetDefaultRoute (m_ipv4[i - 1].GetAddress (0), m_ipv4[i - 1].Get (1).second);
+            }
+        }
+    }
+
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ();
+  m_routingSeconds = std::chrono::duration<double> (end - routingStart).count ();
+  m_setupSeconds = std::chrono::duration<double> (end - start).count ();
+}
+
+void
+IcmpTopology::Reset (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!Simulator::IsFinished ())
+    {
+      Simulator::Run ();
+    }
+  for (uint32_t k = 0; k < m_sockets.size (); k++)
+    {
+      m_sockets[k]->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+      m_sockets[k]->Close ();
+    }
+  m_sockets.clear ();
+
+  if (m_queueSizeChanged)
+    {
+      ApplyPendingQueueSize (m_arpQueueSize, m_ndiscQueueSize);
+      m_queueSizeChanged = false;
+    }
+
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = m_nodes.Get (i)->GetObject<Ipv4L3Protocol> ();
+      for (uint32_t k = 0; k < ipv4->GetNInterfaces (); k++)
+        {
+          Ptr<ArpCache> arp = ipv4->GetInterface (k)->GetArpCache ();
+          if (arp != 0)
+            {
+              arp->Flush ();
+            }
+        }
+      Ptr<Ipv6L3Protocol> ipv6 = m_nodes.Get (i)->GetObject<Ipv6L3Protocol> ();
+      for (uint32_t k = 0; k < ipv6->GetNInterfaces (); k++)
+        {
+          Ptr<NdiscCache> ndisc = ipv6->GetInterface (k)->GetNdiscCache ();
+          if (ndisc != 0)
+            {
+              ndisc->Flush ();
+            }
+        }
+    }
+}
+
+void
+IcmpTopology::SetPendingQueueSize (uint32_t packets)
+{
+  NS_LOG_FUNCTION (this << packets);
+  NS_ASSERT_MSG (!m_links.empty (), "The caches exist once Build ran");
+  ApplyPendingQueueSize (packets, packets);
+  m_queueSizeChanged = true;
+}
+
+void
+IcmpTopology::ApplyPendingQueueSize (uint32_t arpSize, uint32_t ndiscSize)
+{
+  NS_LOG_FUNCTION (this << arpSize << ndiscSize);
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = m_nodes.Get (i)->GetObject<Ipv4L3Protocol> ();
+      for (uint32_t k = 0; k < ipv4->GetNInterfaces (); k++)
+        {
+          Ptr<ArpCache> arp = ipv4->GetInterface (k)->GetArpCache ();
+          if (arp != 0)
+            {
+              arp->SetAttribute ("PendingQueueSize", UintegerValue (arpSize));
+            }
+        }
+      Ptr<Ipv6L3Protocol> ipv6 = m_nodes.Get (i)->GetObject<Ipv6L3Protocol> ();
+      for (uint32_t k = 0; k < ipv6->GetNInterfaces (); k++)
+        {
+          Ptr<NdiscCache> ndisc = ipv6->GetInterface (k)->GetNdiscCache ();
+          if (ndisc != 0)
+            {
+              ndisc->SetAttribute ("UnresolvedQueueSize", UintegerValue (ndiscSize));
+            }
+        }
+    }
+}
+
+Ptr<Socket>
+IcmpTopology::CreateSocket (uint32_t node, TypeId factory)
+{
+  NS_LOG_FUNCTION (this << node << factory);
+  Ptr<Socket> socket = Socket::CreateSocket (m_nodes.Get (node), factory);
+  m_sockets.push_back (socket);
+  return socket;
+}
+
+uint32_t
+IcmpTopology::GetNNodes (void) const
+{
+  return m_nodes.GetN ();
+}
+
+uint32_t
+IcmpTopology::GetNLinks (void) const
+{
+  return m_links.size ();
+}
+
+Ptr<Node>
+IcmpTopology::GetNode (uint32_t i) const
+{
+  return m_nodes.Get (i);
+}
+
+NetDeviceContainer
+IcmpTopology::GetLink (uint32_t link) const
+{
+  return m_links[link];
+}
+
+Ipv4Address
+IcmpTopology::GetIpv4Address (uint32_t link, uint32_t side) const
+{
+  return m_ipv4[link].GetAddress (side);
+}
+
+Ipv6Address
+IcmpTopology::GetIpv6Address (uint32_t link, uint32_t side) const
+{
+  return m_ipv6[link].GetAddress (side, 1);
+}
+
+Ipv6Address
+IcmpTopology::GetIpv6Host (uint32_t link, uint32_t host) const
+{
+  NS_ASSERT_MSG (link < 0xffff && host < 0x10000, "Link or host out of the address plan");
+  uint8_t address[16] = { 0x20, 0x01 };
+  address[2] = (link + 1) >> 8;
+  address[3] = link + 1;
+  address[14] = host >> 8;
+  address[15] = host;
+  return Ipv6Address (address);
+}
+
+double
+IcmpTopology::GetSetupSeconds (void) const
+{
+  return m_setupSeconds;
+}
+
+double
+IcmpTopology::GetRoutingSeconds (void) const
+{
+  return m_routingSeconds;
+}
+
+} // namespace ns3
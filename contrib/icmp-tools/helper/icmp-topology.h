@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ICMP_TOPOLOGY_H
+#define ICMP_TOPOLOGY_H
+
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/ipv6-interface-container.h"
+#include "ns3/socket.h"
+#include "ns3/type-id.h"
+#include "ns3/object-factory.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Dual-stack topology shared by ICMP probe scenarios.
+ *
+ * Build creates the nodes, one point-to-point SimpleChannel per link (or
+ * the channel set with SetChannel), the internet stack, the IPv4 and IPv6
+ * addresses and the routes, once. Probe scenarios then open sockets with
+ * CreateSocket, run the simulator, and call Reset before the next
+ * scenario: Reset closes the scenario sockets, flushes the ARP and
+ * neighbor caches and restores their pending queue size, so each scenario
+ * starts from the same state as on a freshly built topology. The topology
+ * lives until Simulator::Destroy.
+ *
+ * Link j joins nodes j and j + 1 in a chain, node 0 and node j + 1 in a
+ * star. It is numbered 10.x.y.0/24, with x.y = j, and 2001:j+1::/64. On
+ * IPv4, side 0 of the link (the lower node, or the hub) gets host 1 and
+ * side 1 gets host 2; IPv6 addresses are derived from the MAC addresses.
+ * IPv4 routes come from global routing, IPv6 routes are static:
+ * in a chain each node has a default route to the right and a route to
+ * every link further left; in a star the leaves have a default route to
+ * the hub.
+ *
+ * Both make O(N^2) routes in a chain of N nodes. With FROM_FIRST routing
+ * the routes are static on both families and only connect node 0 with
+ * every other node: in a chain each node keeps the default route to the
+ * right and a single route back to link 0, so chains of thousands of
+ * nodes build in linear time and memory.
+ */
+class IcmpTopology
+{
+public:
+  /**
+   * \enum Shape
+   * \brief How the nodes are linked.
+   */
+  enum Shape
+    {
+      CHAIN, //!< node i linked to node i + 1
+      STAR   //!< node 0 linked to every other node
+    };
+
+  /**
+   * \enum Routing
+   * \brief Which nodes Build connects with routes.
+   */
+  enum Routing
+    {
+      ALL_PAIRS, //!< every node reaches every other node
+      FROM_FIRST //!< node 0 and every other node reach each other
+    };
+
+  /**
+   * \brief Constructor.
+   * \param shape how the nodes are linked
+   * \param nodes number of nodes, at least 2
+   */
+  IcmpTopology (Shape shape, uint32_t nodes);
+
+  /**
+   * \param routing which nodes Build connects, ALL_PAIRS by default
+   */
+  void SetRouting (Routing routing);
+  /**
+   * \brief Set the channel type and attributes of every link.
+   *
+   * The factory must make a SimpleChannel or a subclass of it, such as a
+   * LossyChannel; links are plain SimpleChannels by default. Call before
+   * Build.
+   *
+   * \param factory the factory Build creates the link channels with
+   */
+  void SetChannel (ObjectFactory const &factory);
+  /**
+   * \brief Create the nodes, links, addresses and routes.
+   */
+  void Build (void);
+  /**
+   * \brief Prepare the topology for the next scenario.
+   *
+   * Runs any event the last scenario left, closes the sockets created by
+   * CreateSocket and flushes the ARP and IPv6 neighbor caches. A pending
+   * queue size set with SetPendingQueueSize goes back to the one the
+   * caches had after Build.
+   */
+  void Reset (void);
+
+  /**
+   * \brief Set how many packets may wait on an unresolved neighbor.
+   *
+   * Applies to every ARP and IPv6 neighbor cache until the next Reset: a
+   * burst larger than the ns-3 default of 3 packets towards an unresolved
+   * next hop otherwise loses its tail. Call after Build.
+   *
+   * \param packets the packets each cache entry queues during resolution
+   */
+  void SetPendingQueueSize (uint32_t packets);
+
+  /**
+   * \brief Create a socket the next Reset closes.
+   * \param node the node index
+   * \param factory the socket factory, e.g. ns3::Ipv4RawSocketFactory
+   * \returns the socket
+   */
+  Ptr<Socket> CreateSocket (uint32_t node, TypeId factory);
+
+  /**
+   * \returns the number of nodes
+   */
+  uint32_t GetNNodes (void) const;
+  /**
+   * \returns the number of links
+   */
+  uint32_t GetNLinks (void) const;
+  /**
+   * \param i the node index
+   * \returns the node
+   */
+  Ptr<Node> GetNode (uint32_t i) const;
+  /**
+   * \param link the link index
+   * \returns the two devices of the link, side 0 first, e.g. to set their DataRate
+   */
+  NetDeviceContainer GetLink (uint32_t link) const;
+  /**
+   * \param link the link index
+   * \param side 0 for the lower node or the hub, 1 for the other one
+   * \returns the IPv4 address of that side of the link
+   */
+  Ipv4Address GetIpv4Address (uint32_t link, uint32_t side) const;
+  /**
+   * \param link the link index
+   * \param side 0 for the lower node or the hub, 1 for the other one
+   * \returns the global IPv6 address of that side of the link
+   */
+  Ipv6Address GetIpv6Address (uint32_t link, uint32_t side) const;
+  /**
+   * \param link the link index
+   * \param host the host part, below 2^16: no MAC-derived address is that small
+   * \returns an address of the IPv6 prefix of the link
+   */
+  Ipv6Address GetIpv6Host (uint32_t link, uint32_t host) const;
+  /**
+   * \returns the wall time Build took, in seconds
+   */
+  double GetSetupSeconds (void) const;
+  /**
+   * \returns the part of the Build wall time spent on routes, in seconds
+   */
+  double GetRoutingSeconds (void) const;
+
+private:
+  /**
+   * \brief Set the pending queue size of every ARP and IPv6 neighbor cache.
+   * \param arpSize the ARP PendingQueueSize
+   * \param ndiscSize the NdiscCache UnresolvedQueueSize
+   */
+  void ApplyPendingQueueSize (uint32_t arpSize, uint32_t ndiscSize);
+
+  Shape m_shape; //!< how the nodes are linked
+  Routing m_routing; //!< which nodes are connected by routes
+  ObjectFactory m_channel; //!< makes the link channels
+  NodeContainer m_nodes; //!< the nodes
+  std::vector<NetDeviceContainer> m_links; //!< the devices of each link, side 0 first
+  std::vector<Ipv4InterfaceContainer> m_ipv4; //!< the IPv4 interfaces of each link
+  std::vector<Ipv6InterfaceContainer> m_ipv6; //!< the IPv6 interfaces of each link
+  std::vector<Ptr<Socket> > m_sockets; //!< sockets of the current scenario
+  double m_setupSeconds; //!< wall time of Build
+  double m_routingSeconds; //!< wall time of the routes in Build
+  uint32_t m_arpQueueSize; //!< ARP PendingQueueSize after Build
+  uint32_t m_ndiscQueueSize; //!< NdiscCache UnresolvedQueueSize after Build
+  bool m_queueSizeChanged; //!< whether SetPendingQueueSize ran since Build or Reset
+};
+
+} // namespace ns3
+
+#endif /* ICMP_TOPOLOGY_H */
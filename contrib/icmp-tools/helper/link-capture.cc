@@ -0,0 +1,390 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+#include "ns3/mac48-address.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "link-capture.h"
+
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LinkCapture");
+
+namespace {
+
+/// Bytes first mapped per file.
+const uint64_t INITIAL_MAPPING = 1 << 20;
+/// Bytes of the Ethernet header made for each record.
+const uint32_t ETHERNET_SIZE = 14;
+/// Ethernet link type, in pcap and pcapng.
+const uint16_t LINKTYPE_ETHERNET = 1;
+
+/// pcap file header magic with nanosecond timestamps.
+const uint32_t PCAP_MAGIC_NS = 0xa1b23c4d;
+/// pcapng Section Header Block.
+const uint32_t PCAPNG_SHB = 0x0a0d0d0a;
+/// pcapng Interface Description Block.
+const uint32_t PCAPNG_IDB = 0x00000001;
+/// pcapng Enhanced Packet Block.
+const uint32_t PCAPNG_EPB = 0x00000006;
+/// pcapng byte-order magic.
+const uint32_t PCAPNG_BYTE_ORDER = 0x1a2b3c4d;
+
+/**
+ * \param bytes a length
+ * \returns the length padded to 32 bits, as pcapng wants
+ */
+uint32_t
+Pad4 (uint32_t bytes)
+{
+  return (bytes + 3) & ~3u;
+}
+
+/**
+ * \brief Write a 16-bit value in host order and move past it.
+ * \param p the cursor
+ * \param value the value
+ */
+void
+Put16 (uint8_t *&p, uint16_t value)
+{
+  std::memcpy (p, &value, 2);
+  p += 2;
+}
+
+/**
+ * \brief Write a 32-bit value in host order and move past it.
+ * \param p the cursor
+ * \param value the value
+ */
+void
+Put32 (uint8_t *&p, uint32_t value)
+{
+  std::memcpy (p, &value, 4);
+  p += 4;
+}
+
+/**
+ * \returns a monotonic timestamp in nanoseconds
+ */
+uint64_t
+NowNs (void)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+           (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+} // anonymous namespace
+
+MappedFile::MappedFile (std::string const &path)
+  : m_path (path),
+    m_data (0),
+    m_size (0),
+    m_capacity (0)
+{
+  NS_LOG_FUNCTION (this << path);
+  int fd = open (path.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  NS_ABORT_MSG_IF (fd < 0, "Cannot create " << path);
+  close (fd);
+  Map (INITIAL_MAPPING);
+}
+
+MappedFile::~MappedFile ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+void
+MappedFile::Map (uint64_t capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+  int fd = open (m_path.c_str (), O_RDWR);
+  NS_ABORT_MSG_IF (fd < 0, "Cannot reopen " << m_path);
+  NS_ABORT_MSG_IF (ftruncate (fd, capacity) != 0, "Cannot extend " << m_path << " to " << capacity << " bytes");
+  void *data = m_data == 0 ? mmap (0, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                           : mremap (m_data, m_capacity, capacity, MREMAP_MAYMOVE);
+  close (fd);
+  NS_ABORT_MSG_IF (data == MAP_FAILED, "Cannot map " << capacity << " bytes of " << m_path);
+  m_data = static_cast<uint8_t *> (data);
+  m_capacity = capacity;
+}
+
+uint8_t *
+MappedFile::Reserve (uint32_t bytes)
+{
+  NS_ASSERT_MSG (m_data != 0, "Appending to the closed file " << m_path);
+  if (m_size + bytes > m_capacity)
+    {
+      uint64_t capacity = m_capacity;
+      while (m_size + bytes > capacity)
+        {
+          capacity *= 2;
+        }
+      Map (capacity);
+    }
+  return m_data + m_size;
+}
+
+void
+MappedFile::Commit (uint32_t bytes)
+{
+  m_size += bytes;
+}
+
+void
+MappedFile::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      return;
+    }
+  munmap (m_data, m_capacity);
+  m_data = 0;
+  NS_ABORT_MSG_IF (truncate (m_path.c_str (), m_size) != 0, "Cannot truncate " << m_path);
+}
+
+uint64_t
+MappedFile::GetSize (void) const
+{
+  return m_size;
+}
+
+LinkCapture::LinkCapture (Format format, uint32_t snapLength)
+  : m_format (format),
+    m_snapLength (snapLength),
+    m_closed (false),
+    m_packets (0),
+    m_nanoseconds (0)
+{
+  NS_LOG_FUNCTION (this << format << snapLength);
+  NS_ABORT_MSG_UNLESS (snapLength >= ETHERNET_SIZE, "A snap length of " << snapLength
+                       << " bytes does not hold the Ethernet header");
+}
+
+LinkCapture::~LinkCapture ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+  for (std::map<std::string, File>::iterator it = m_files.begin (); it != m_files.end (); it++)
+    {
+      delete it->second.file;
+    }
+}
+
+LinkCapture::File *
+LinkCapture::Open (std::string const &path)
+{
+  NS_LOG_FUNCTION (this << path);
+  File &file = m_files[path];
+  file.file = new MappedFile (path);
+  file.interfaces = 0;
+  if (m_format == PCAP)
+    {
+      uint8_t *p = file.file->Reserve (24);
+      Put32 (p, PCAP_MAGIC_NS);
+      Put16 (p, 2);
+      Put16 (p, 4);
+      Put32 (p, 0); // thiszone
+      Put32 (p, 0); // sigfigs
+      Put32 (p, m_snapLength);
+      Put32 (p, LINKTYPE_ETHERNET);
+      file.file->Commit (24);
+    }
+  else
+    {
+      uint8_t *p = file.file->Reserve (28);
+      Put32 (p, PCAPNG_SHB);
+      Put32 (p, 28);
+      Put32 (p, PCAPNG_BYTE_ORDER);
+      Put16 (p, 1);
+      Put16 (p, 0);
+      // unknown section length
+      Put32 (p, 0xffffffff);
+      Put32 (p, 0xffffffff);
+      Put32 (p, 28);
+      file.file->Commit (28);
+    }
+  return &file;
+}
+
+uint32_t
+LinkCapture::AddInterface (File *file, std::string const &name)
+{
+  NS_LOG_FUNCTION (this << file << name);
+  if (m_format == PCAP)
+    {
+      return 0;
+    }
+  // fixed part, if_name, if_tsresol, opt_endofopt, trailing length
+  uint32_t size = 16 + 4 + Pad4 (name.size ()) + 8 + 4 + 4;
+  uint8_t *p = file->file->Reserve (size);
+  std::memset (p, 0, size);
+  Put32 (p, PCAPNG_IDB);
+  Put32 (p, size);
+  Put16 (p, LINKTYPE_ETHERNET);
+  Put16 (p, 0);
+  Put32 (p, m_snapLength);
+  Put16 (p, 2); // if_name
+  Put16 (p, name.size ());
+  std::memcpy (p, name.data (), name.size ());
+  p += Pad4 (name.size ());
+  Put16 (p, 9); // if_tsresol
+  Put16 (p, 1);
+  *p = 9; // nanoseconds
+  p += 4;
+  Put32 (p, 0); // opt_endofopt
+  Put32 (p, size);
+  file->file->Commit (size);
+  return file->interfaces++;
+}
+
+void
+LinkCapture::AddLink (NetDeviceContainer const &link, std::string const &file, std::string const &name)
+{
+  NS_LOG_FUNCTION (this << file << name);
+  NS_ABORT_MSG_IF (m_closed, "Adding the link " << name << " to a closed capture");
+  std::map<std::string, File>::iterator it = m_files.find (file);
+  File *f = it != m_files.end () ? &it->second : Open (file);
+  Tap tap = { this, f, AddInterface (f, name) };
+  for (uint32_t side = 0; side < link.GetN (); side++)
+    {
+      Ptr<NetDevice> device = link.Get (side);
+      m_taps.push_back (tap);
+      device->GetNode ()->RegisterProtocolHandler (MakeCallback (&Tap::Receive, &m_taps.back ()), 0, device, true);
+    }
+}
+
+void
+LinkCapture::Tap::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                           Address const &from, Address const &to, NetDevice::PacketType type)
+{
+  if (!capture->m_closed)
+    {
+      capture->Write (*this, packet, protocol, from, to);
+    }
+}
+
+void
+LinkCapture::Write (Tap const &tap, Ptr<const Packet> packet, uint16_t protocol, Address const &from, Address const &to)
+{
+  uint64_t start = NowNs ();
+  uint32_t length = ETHERNET_SIZE + packet->GetSize ();
+  uint32_t captured = length < m_snapLength ? length : m_snapLength;
+  uint64_t now = Simulator::Now ().GetNanoSeconds ();
+
+  uint32_t recordHeader = m_format == PCAP ? 16 : 28;
+  uint32_t size = m_format == PCAP ? recordHeader + captured : recordHeader + Pad4 (captured) + 4;
+  uint8_t *p = tap.file->file->Reserve (size);
+  if (m_format == PCAP)
+    {
+      Put32 (p, now / 1000000000);
+      Put32 (p, now % 1000000000);
+      Put32 (p, captured);
+      Put32 (p, length);
+    }
+  else
+    {
+      Put32 (p, PCAPNG_EPB);
+      Put32 (p, size);
+      Put32 (p, tap.interface);
+      Put32 (p, now >> 32);
+      Put32 (p, now);
+      Put32 (p, captured);
+      Put32 (p, length);
+    }
+
+  uint8_t ethernet[ETHERNET_SIZE];
+  Mac48Address::ConvertFrom (to).CopyTo (ethernet);
+  Mac48Address::ConvertFrom (from).CopyTo (ethernet + 6);
+  ethernet[12] = protocol >> 8;
+  ethernet[13] = protocol;
+  std::memcpy (p, ethernet, captured < ETHERNET_SIZE ? captured : ETHERNET_SIZE);
+  if (captured > ETHERNET_SIZE)
+    {
+      // straight from the packet buffers into the mapping
+      packet->CopyData (p + ETHERNET_SIZE, captured - ETHERNET_SIZE);
+    }
+
+  if (m_format == PCAPNG)
+    {
+      p += captured;
+      std::memset (p, 0, Pad4 (captured) - captured);
+      p += Pad4 (captured) - captured;
+      Put32 (p, size);
+    }
+  tap.file->file->Commit (size);
+  m_packets++;
+  m_nanoseconds += NowNs () - start;
+}
+
+void
+LinkCapture::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_closed)
+    {
+      return;
+    }
+  uint64_t start = NowNs ();
+  for (std::map<std::string, File>::iterator it = m_files.begin (); it != m_files.end (); it++)
+    {
+      it->second.file->Close ();
+    }
+  m_closed = true;
+  m_nanoseconds += NowNs () - start;
+}
+
+uint64_t
+LinkCapture::GetPackets (void) const
+{
+  return m_packets;
+}
+
+uint64_t
+LinkCapture::GetBytes (void) const
+{
+  uint64_t bytes = 0;
+  for (std::map<std::string, File>::const_iterator it = m_files.begin (); it != m_files.end (); it++)
+    {
+      bytes += it->second.file->GetSize ();
+    }
+  return bytes;
+}
+
+uint32_t
+LinkCapture::GetFiles (void) const
+{
+  return m_files.size ();
+}
+
+double
+LinkCapture::GetSeconds (void) const
+{
+  return m_nanoseconds / 1e9;
+}
+
+} // namespace ns3
@@ -0,0 +1,226 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINK_CAPTURE_H
+#define LINK_CAPTURE_H
+
+#include "ns3/address.h"
+#include "ns3/net-device.h"
+#include "ns3/net-device-container.h"
+#include "ns3/packet.h"
+
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \brief A file written through a shared memory mapping that grows as needed.
+ *
+ * Appending is a copy into the mapping: no system call per record, the
+ * kernel writes the pages back on its own. When the mapping is full the
+ * file is extended and remapped at twice the size. The file descriptor is
+ * closed between growths, so thousands of files can be open at once.
+ * Close unmaps the file and truncates it to the bytes appended.
+ */
+class MappedFile
+{
+public:
+  /**
+   * \brief Create or truncate a file and map it.
+   * \param path the file
+   */
+  MappedFile (std::string const &path);
+  /**
+   * \brief Destructor, closes the file.
+   */
+  ~MappedFile ();
+
+  /**
+   * \brief Make room for bytes at the end of the file.
+   * \param bytes the bytes about to be appended
+   * \returns where to write them, valid until the next Reserve
+   */
+  uint8_t * Reserve (uint32_t bytes);
+  /**
+   * \brief Append bytes written where Reserve pointed.
+   * \param bytes the bytes written, at most the bytes reserved
+   */
+  void Commit (uint32_t bytes);
+  /**
+   * \brief Unmap the file and truncate it to its contents.
+   */
+  void Close (void);
+  /**
+   * \returns the bytes appended
+   */
+  uint64_t GetSize (void) const;
+
+private:
+  /**
+   * \brief Extend the file and its mapping.
+   * \param capacity the new size, in bytes
+   */
+  void Map (uint64_t capacity);
+
+  std::string m_path;  //!< the file
+  uint8_t *m_data;     //!< the mapping, 0 once closed
+  uint64_t m_size;     //!< bytes appended
+  uint64_t m_capacity; //!< bytes mapped
+};
+
+/**
+ * \brief Capture of the packets crossing SimpleNetDevice links, in pcap or pcapng.
+ *
+ * AddLink hooks the two devices SimpleNetDeviceHelper::Install made for
+ * a link with a promiscuous protocol handler on their nodes, so each
+ * packet is captured once, when the device at the other end receives it.
+ * SimpleNetDevice has no frame header on the wire; every record gets an
+ * Ethernet header made from the source and destination MAC addresses and
+ * the protocol number, so that IPv4, IPv6 and ARP all decode.
+ *
+ * Links go to their own file or share one, by file name. A pcapng file
+ * describes each link as an interface of its own, named after it; a
+ * merged pcap file cannot tell the links apart. Timestamps are in
+ * nanoseconds. Records are appended to a MappedFile, and packets longer
+ * than the snap length are truncated.
+ *
+ * The time spent capturing is measured, so that it can be reported
+ * against the wall time of the simulation. The capture must outlive the
+ * simulation, since the nodes keep calling its handlers.
+ */
+class LinkCapture
+{
+public:
+  /**
+   * \enum Format
+   * \brief The capture file format.
+   */
+  enum Format
+    {
+      PCAP,  //!< libpcap, nanosecond timestamps
+      PCAPNG //!< pcapng, one interface per link
+    };
+
+  /**
+   * \brief Constructor.
+   * \param format the file format
+   * \param snapLength bytes captured per packet, Ethernet header included
+   */
+  LinkCapture (Format format, uint32_t snapLength = 65535);
+  /**
+   * \brief Destructor, closes the files.
+   */
+  ~LinkCapture ();
+
+  /**
+   * \brief Capture the packets of a link.
+   * \param link the two devices of the link
+   * \param file the capture file, created on its first link
+   * \param name the link name, the interface name in pcapng
+   */
+  void AddLink (NetDeviceContainer const &link, std::string const &file, std::string const &name);
+  /**
+   * \brief Close every file; packets received afterwards are not captured.
+   */
+  void Close (void);
+
+  /**
+   * \returns the number of packets captured
+   */
+  uint64_t GetPackets (void) const;
+  /**
+   * \returns the bytes written to the capture files
+   */
+  uint64_t GetBytes (void) const;
+  /**
+   * \returns the number of capture files
+   */
+  uint32_t GetFiles (void) const;
+  /**
+   * \returns the wall time spent capturing and closing the files, in seconds
+   */
+  double GetSeconds (void) const;
+
+private:
+  /**
+   * \brief A capture file.
+   */
+  struct File
+  {
+    MappedFile *file;    //!< the mapped file
+    uint32_t interfaces; //!< pcapng interfaces described so far
+  };
+
+  /**
+   * \brief A hooked device.
+   */
+  struct Tap
+  {
+    LinkCapture *capture; //!< the capture
+    File *file;           //!< the file of its link
+    uint32_t interface;   //!< pcapng interface of its link
+
+    /**
+     * \brief Promiscuous protocol handler.
+     * \param device the receiving device
+     * \param packet the packet
+     * \param protocol the protocol number, the EtherType
+     * \param from the sender address
+     * \param to the destination address
+     * \param type the packet type
+     */
+    void Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                  Address const &from, Address const &to, NetDevice::PacketType type);
+  };
+
+  /**
+   * \brief Open a capture file and write its header.
+   * \param path the file
+   * \returns the file
+   */
+  File * Open (std::string const &path);
+  /**
+   * \brief Describe a link in a pcapng file.
+   * \param file the file
+   * \param name the link name
+   * \returns the interface of the link
+   */
+  uint32_t AddInterface (File *file, std::string const &name);
+  /**
+   * \brief Append a record.
+   * \param tap the device the packet was received on
+   * \param packet the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \param to the destination address
+   */
+  void Write (Tap const &tap, Ptr<const Packet> packet, uint16_t protocol, Address const &from, Address const &to);
+
+  Format m_format;                     //!< file format
+  uint32_t m_snapLength;               //!< bytes captured per packet
+  std::map<std::string, File> m_files; //!< files, by path
+  std::deque<Tap> m_taps;              //!< hooked devices, never moved
+  bool m_closed;                       //!< true once closed
+  uint64_t m_packets;                  //!< packets captured
+  uint64_t m_nanoseconds;              //!< wall time spent capturing
+};
+
+} // namespace ns3
+
+#endif /* LINK_CAPTURE_H */
@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef HEADER_FORMAT_H
+#define HEADER_FORMAT_H
+
+#include "ns3/assert.h"
+#include "ns3/ipv4-address.h"
+
+#include <cstring>
+#include <ostream>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief Format a header Print line in a stack buffer.
+ *
+ * The header Print methods append their text here and hand it to the
+ * stream with a single write, instead of one formatted insertion per
+ * field. Nothing is allocated.
+ */
+class HeaderFormatter
+{
+public:
+  /// Capacity of the buffer, enough for any fixed IPv4 or IPv6 header line.
+  static const uint32_t SIZE = 512;
+
+  HeaderFormatter ()
+    : m_size (0)
+  {
+  }
+
+  /**
+   * \param text a nul-terminated string
+   * \returns this formatter
+   */
+  HeaderFormatter &
+  Append (char const *text)
+  {
+    uint32_t n = std::strlen (text);
+    NS_ASSERT_MSG (m_size + n <= SIZE, "HeaderFormatter overflow");
+    std::memcpy (m_text + m_size, text, n);
+    m_size += n;
+    return *this;
+  }
+
+  /**
+   * \param value the number to append in decimal
+   * \returns this formatter
+   */
+  HeaderFormatter &
+  AppendDecimal (uint32_t value)
+  {
+    char digits[10];
+    uint32_t n = 0;
+    do
+      {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+      }
+    while (value != 0);
+    NS_ASSERT_MSG (m_size + n <= SIZE, "HeaderFormatter overflow");
+    while (n != 0)
+      {
+        m_text[m_size++] = digits[--n];
+      }
+    return *this;
+  }
+
+  /**
+   * \param value the number to append in lowercase hexadecimal, without prefix
+   * \returns this formatter
+   */
+  HeaderFormatter &
+  AppendHex (uint32_t value)
+  {
+    char digits[8];
+    uint32_t n = 0;
+    do
+      {
+        digits[n++] = "0123456789abcdef"[value & 0xf];
+        value >>= 4;
+      }
+    while (value != 0);
+    NS_ASSERT_MSG (m_size + n <= SIZE, "HeaderFormatter overflow");
+    while (n != 0)
+      {
+        m_text[m_size++] = digits[--n];
+      }
+    return *this;
+  }
+
+  /**
+   * \param address the address to append in dotted decimal
+   * \returns this formatter
+   */
+  HeaderFormatter &
+  AppendIpv4 (Ipv4Address address)
+  {
+    uint32_t a = address.Get ();
+    return AppendDecimal (a >> 24).Append (".").AppendDecimal ((a >> 16) & 0xff).Append (".")
+           .AppendDecimal ((a >> 8) & 0xff).Append (".").AppendDecimal (a & 0xff);
+  }
+
+  /**
+   * \brief Write the text to a stream.
+   * \param os the stream
+   */
+  void
+  WriteTo (std::ostream &os) const
+  {
+    os.write (m_text, m_size);
+  }
+
+private:
+  char m_text[SIZE]; //!< the text
+  uint32_t m_size; //!< number of characters
+};
+
+} // namespace ns3
+
+#endif /* HEADER_FORMAT_H */
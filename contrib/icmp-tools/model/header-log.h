@@ -0,0 +1,62 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef HEADER_LOG_H
+#define HEADER_LOG_H
+
+#include "ns3/log.h"
+
+/**
+ * \file
+ * \ingroup logging
+ *
+ * Function-entry logging for the header codecs.
+ *
+ * The codec getters and setters are a handful of instructions, so even
+ * the disabled NS_LOG_FUNCTION check of a logging build dominates them.
+ * Building with the hot-path profile removes that check from the codecs
+ * only, and leaves NS_LOG_FUNCTION alone everywhere else:
+ *
+ * \code
+ *   CXXFLAGS="-DNS3_HEADER_HOT_PATH" ./waf configure --build-profile=debug
+ * \endcode
+ *
+ * The flag only matters in a build with logging. The optimized and release
+ * profiles already compile NS_LOG out, codecs included. A debug build
+ * without the flag logs function entries as before.
+ */
+
+#ifdef NS3_HEADER_HOT_PATH
+
+/**
+ * \ingroup logging
+ * Compiled out in the hot-path profile.
+ * \param parameters ignored
+ */
+#define NS_HEADER_LOG_FUNCTION(parameters)
+
+#else /* NS3_HEADER_HOT_PATH */
+
+/**
+ * \ingroup logging
+ * NS_LOG_FUNCTION, unless built with NS3_HEADER_HOT_PATH.
+ * \param parameters the parameters to output
+ */
+#define NS_HEADER_LOG_FUNCTION(parameters) NS_LOG_FUNCTION (parameters)
+
+#endif /* NS3_HEADER_HOT_PATH */
+
+#endif /* HEADER_LOG_H */
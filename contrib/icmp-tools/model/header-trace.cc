@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "header-trace.h"
+#include "header-log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("HeaderTrace");
+
+HeaderTraceWriter::HeaderTraceWriter (std::ostream &os)
+  : m_os (os),
+    m_buffer (BUFFER_SIZE),
+    m_size (0),
+    m_records (0)
+{
+  NS_HEADER_LOG_FUNCTION (this << &os);
+  m_scratch.AddAtStart (60);
+}
+
+HeaderTraceWriter::~HeaderTraceWriter ()
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  Flush ();
+}
+
+void
+HeaderTraceWriter::Write (Ipv4CodecHeader const &header)
+{
+  NS_HEADER_LOG_FUNCTION (this << &header);
+  Append (4, header);
+}
+
+void
+HeaderTraceWriter::Write (Ipv6CodecHeader const &header)
+{
+  NS_HEADER_LOG_FUNCTION (this << &header);
+  Append (6, header);
+}
+
+void
+HeaderTraceWriter::Append (uint8_t type, Header const &header)
+{
+  uint32_t size = header.GetSerializedSize ();
+  if (m_size + 1 + size > BUFFER_SIZE)
+    {
+      Flush ();
+    }
+  header.Serialize (m_scratch.Begin ());
+  m_buffer[m_size] = type;
+  m_scratch.Begin ().Read (&m_buffer[m_size + 1], size);
+  m_size += 1 + size;
+  m_records++;
+}
+
+void
+HeaderTraceWriter::Flush (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  m_os.write (reinterpret_cast<char const *> (m_buffer.data ()), m_size);
+  m_size = 0;
+}
+
+uint64_t
+HeaderTraceWriter::GetRecordCount (void) const
+{
+  return m_records;
+}
+
+HeaderTraceReader::HeaderTraceReader (std::istream &is)
+  : m_is (is),
+    m_version (0),
+    m_size (0)
+{
+  NS_HEADER_LOG_FUNCTION (this << &is);
+}
+
+bool
+HeaderTraceReader::Next (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  char type;
+  if (!m_is.get (type))
+    {
+      return false;
+    }
+  m_version = type;
+  if (m_version == 4)
+    {
+      if (!m_is.read (reinterpret_cast<char *> (m_data), 1))
+        {
+          return false;
+        }
+      m_size = (m_data[0] & 0x0f) * 4;
+      if (m_size < 20)
+        {
+          NS_LOG_WARN ("IPv4 record with an IHL of " << m_size / 4);
+          return false;
+        }
+      return static_cast<bool> (m_is.read (reinterpret_cast<char *> (m_data + 1), m_size - 1));
+    }
+  if (m_version == 6)
+    {
+      m_size = 40;
+      return static_cast<bool> (m_is.read (reinterpret_cast<char *> (m_data), m_size));
+    }
+  NS_LOG_WARN ("Unknown record type " << static_cast<uint32_t> (m_version));
+  return false;
+}
+
+uint8_t
+HeaderTraceReader::GetVersion (void) const
+{
+  return m_version;
+}
+
+uint8_t const *
+HeaderTraceReader::GetData (void) const
+{
+  return m_data;
+}
+
+uint32_t
+HeaderTraceReader::GetSize (void) const
+{
+  return m_size;
+}
+
+void
+HeaderTraceReader::Print (std::ostream &os) const
+{
+  NS_HEADER_LOG_FUNCTION (this << &os);
+  Buffer buffer;
+  buffer.AddAtStart (m_size);
+  buffer.Begin ().Write (m_data, m_size);
+  if (m_version == 4)
+    {
+      Ipv4CodecHeader header;
+      header.Deserialize (buffer.Begin ());
+      header.Print (os);
+    }
+  else
+    {
+      Ipv6CodecHeader header;
+      header.Deserialize (buffer.Begin ());
+      header.Print (os);
+    }
+}
+
+} // namespace ns3
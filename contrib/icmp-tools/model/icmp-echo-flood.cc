@@ -0,0 +1,367 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/inet-socket-address.h"
+#include "icmp-echo-flood.h"
+#include "ipv4-header-view.h"
+#include "ip-checksum.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("IcmpEchoFlood");
+
+namespace {
+
+/// ICMPv4 echo request and reply types.
+const uint8_t ICMPV4_ECHO = 8;
+const uint8_t ICMPV4_ECHO_REPLY = 0;
+
+} // unnamed namespace
+
+IcmpEchoFlood::IcmpEchoFlood (Ptr<Socket> socket, Ipv4Address destination)
+  : m_socket (socket),
+    m_destination (destination),
+    m_identifier (0),
+    m_dataSize (56),
+    m_window (1),
+    m_rate (0),
+    m_timeout (Seconds (1)),
+    m_checksum (0),
+    m_count (0),
+    m_oldest (0),
+    m_outstanding (0),
+    m_received (0),
+    m_reordered (0),
+    m_duplicates (0),
+    m_timeouts (0),
+    m_newest (-1),
+    m_sumRtt (0)
+{
+  NS_LOG_FUNCTION (this << socket << destination);
+}
+
+void
+IcmpEchoFlood::SetIdentifier (uint16_t identifier)
+{
+  m_identifier = identifier;
+}
+
+void
+IcmpEchoFlood::SetDataSize (uint32_t size)
+{
+  m_dataSize = size;
+}
+
+void
+IcmpEchoFlood::SetOutstanding (uint32_t window)
+{
+  NS_ASSERT_MSG (window > 0 && window < 0x10000, "Window of " << window << " requests");
+  m_window = window;
+  m_rate = 0;
+}
+
+void
+IcmpEchoFlood::SetRate (double pps)
+{
+  NS_ASSERT_MSG (pps > 0, "Rate of " << pps << " requests per second");
+  m_rate = pps;
+}
+
+void
+IcmpEchoFlood::SetTimeout (Time timeout)
+{
+  m_timeout = timeout;
+}
+
+void
+IcmpEchoFlood::Start (uint32_t count)
+{
+  NS_LOG_FUNCTION (this << count);
+  NS_ASSERT_MSG (m_sentAt.empty (), "The flood was already started");
+
+  m_template.assign (8 + m_dataSize, 0);
+  m_template[0] = ICMPV4_ECHO;
+  m_template[4] = m_identifier >> 8;
+  m_template[5] = m_identifier & 0xff;
+  for (uint32_t k = 0; k < m_dataSize; k++)
+    {
+      m_template[8 + k] = k & 0xff;
+    }
+  m_checksum = IpChecksum::Calculate (&m_template[0], m_template.size ());
+  m_template[2] = m_checksum & 0xff;
+  m_template[3] = m_checksum >> 8;
+  m_request = m_template;
+
+  m_count = count;
+  m_sentAt.reserve (count);
+  m_state.reserve (count);
+  m_socket->SetRecvCallback (MakeCallback (&IcmpEchoFlood::Receive, this));
+
+  if (count == 0)
+    {
+      return;
+    }
+  uint32_t context = m_socket->GetNode ()->GetId ();
+  if (m_rate > 0)
+    {
+      Simulator::ScheduleWithContext (context, Time (0), &IcmpEchoFlood::Tick, this);
+    }
+  else
+    {
+      Simulator::ScheduleWithContext (context, Time (0), &IcmpEchoFlood::Expire, this);
+    }
+}
+
+void
+IcmpEchoFlood::Send (void)
+{
+  uint32_t k = m_sentAt.size ();
+  uint16_t sequence = k;
+  NS_LOG_FUNCTION (this << k);
+
+  // patch the sequence number and fold it into the template checksum: the
+  // template carries 0 there, so the old word drops out of the update
+  m_request[6] = sequence >> 8;
+  m_request[7] = sequence & 0xff;
+  uint32_t sum = static_cast<uint16_t> (~m_checksum) + static_cast<uint32_t> (m_request[6] | (m_request[7] << 8));
+  sum = (sum & 0xffff) + (sum >> 16);
+  uint16_t checksum = ~sum;
+  m_request[2] = checksum & 0xff;
+  m_request[3] = checksum >> 8;
+
+  if (k == 0)
+    {
+      m_first = Simulator::Now ();
+    }
+  m_sentAt.push_back (Simulator::Now ().GetTimeStep ());
+  m_state.push_back (PENDING);
+  m_outstanding++;
+
+  Ptr<Packet> p = Create<Packet> (&m_request[0], m_request.size ());
+  if (m_socket->SendTo (p, 0, InetSocketAddress (m_destination, 0)) < 0)
+    {
+      NS_LOG_WARN ("Failed to send echo " << k);
+    }
+}
+
+void
+IcmpEchoFlood::Fill (void)
+{
+  while (m_outstanding < m_window && m_sentAt.size () < m_count)
+    {
+      Send ();
+    }
+}
+
+void
+IcmpEchoFlood::Tick (void)
+{
+  Send ();
+  uint32_t k = m_sentAt.size ();
+  if (k < m_count)
+    {
+      // due times are computed from the first send so rounding does not drift
+      Time due = m_first + Seconds (k / m_rate);
+      m_timer = Simulator::Schedule (due - Simulator::Now (), &IcmpEchoFlood::Tick, this);
+    }
+}
+
+void
+IcmpEchoFlood::Expire (void)
+{
+  NS_LOG_FUNCTION (this);
+  // a single timer follows the oldest pending request; replies never touch it
+  Fill ();
+  while (true)
+    {
+      while (m_oldest < m_sentAt.size () && m_state[m_oldest] != PENDING)
+        {
+          m_oldest++;
+        }
+      if (m_oldest == m_sentAt.size ())
+        {
+          return;
+        }
+      Time deadline = TimeStep (m_sentAt[m_oldest]) + m_timeout;
+      if (deadline > Simulator::Now ())
+        {
+          m_timer = Simulator::Schedule (deadline - Simulator::Now (), &IcmpEchoFlood::Expire, this);
+          return;
+        }
+      NS_LOG_LOGIC ("Echo " << m_oldest << " timed out");
+      m_state[m_oldest] = EXPIRED;
+      m_outstanding--;
+      m_timeouts++;
+      Fill ();
+    }
+}
+
+void
+IcmpEchoFlood::Receive (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()))
+    {
+      // raw sockets deliver the IPv4 header in front of the ICMP message
+      uint8_t bytes[Ipv4HeaderView::MAX_SIZE + 8];
+      uint32_t size = p->CopyData (bytes, sizeof (bytes));
+      Ipv4HeaderView ipv4 (bytes, size);
+      if (!ipv4.IsValid () || ipv4.GetProtocol () != 1 || size < ipv4.GetHeaderSize () + 8)
+        {
+          continue;
+        }
+      uint8_t const *icmp = bytes + ipv4.GetHeaderSize ();
+      if (icmp[0] != ICMPV4_ECHO_REPLY || ((icmp[4] << 8) | icmp[5]) != m_identifier)
+        {
+          continue;
+        }
+      Match ((icmp[6] << 8) | icmp[7]);
+    }
+}
+
+void
+IcmpEchoFlood::Match (uint16_t sequence)
+{
+  if (m_sentAt.empty ())
+    {
+      return;
+    }
+  // widen the sequence number to the closest request at or before the last one sent
+  uint32_t last = m_sentAt.size () - 1;
+  uint16_t behind = last - sequence;
+  if (behind > last)
+    {
+      NS_LOG_LOGIC ("Reply " << sequence << " to no request");
+      return;
+    }
+  uint32_t k = last - behind;
+  if (m_state[k] == ANSWERED)
+    {
+      m_duplicates++;
+      return;
+    }
+  if (m_state[k] == PENDING)
+    {
+      m_outstanding--;
+    }
+  m_state[k] = ANSWERED;
+  m_received++;
+  if (static_cast<int64_t> (k) < m_newest)
+    {
+      m_reordered++;
+    }
+  else
+    {
+      m_newest = k;
+    }
+
+  m_last = Simulator::Now ();
+  Time rtt = m_last - TimeStep (m_sentAt[k]);
+  if (m_received == 1 || rtt < m_minRtt)
+    {
+      m_minRtt = rtt;
+    }
+  if (rtt > m_maxRtt)
+    {
+      m_maxRtt = rtt;
+    }
+  m_sumRtt += rtt.GetTimeStep ();
+  m_rttHistogram.Record (rtt);
+
+  if (m_rate == 0)
+    {
+      Fill ();
+      if (m_outstanding == 0)
+        {
+          // everything sent and answered: the simulation may end now
+          m_timer.Cancel ();
+        }
+    }
+}
+
+uint64_t
+IcmpEchoFlood::GetSent (void) const
+{
+  return m_sentAt.size ();
+}
+
+uint64_t
+IcmpEchoFlood::GetReceived (void) const
+{
+  return m_received;
+}
+
+uint64_t
+IcmpEchoFlood::GetLost (void) const
+{
+  return m_sentAt.size () - m_received;
+}
+
+uint64_t
+IcmpEchoFlood::GetReordered (void) const
+{
+  return m_reordered;
+}
+
+uint64_t
+IcmpEchoFlood::GetDuplicates (void) const
+{
+  return m_duplicates;
+}
+
+uint64_t
+IcmpEchoFlood::GetTimeouts (void) const
+{
+  return m_timeouts;
+}
+
+Time
+IcmpEchoFlood::GetDuration (void) const
+{
+  return m_received ? m_last - m_first : Time (0);
+}
+
+Time
+IcmpEchoFlood::GetMinRtt (void) const
+{
+  return m_minRtt;
+}
+
+Time
+IcmpEchoFlood::GetMeanRtt (void) const
+{
+  return m_received ? TimeStep (m_sumRtt / static_cast<int64_t> (m_received)) : Time (0);
+}
+
+Time
+IcmpEchoFlood::GetMaxRtt (void) const
+{
+  return m_maxRtt;
+}
+
+LatencyHistogram const &
+IcmpEchoFlood::GetRttHistogram (void) const
+{
+  return m_rttHistogram;
+}
+
+} // namespace ns3
@@ -0,0 +1,206 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ICMP_ECHO_FLOOD_H
+#define ICMP_ECHO_FLOOD_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/socket.h"
+#include "latency-histogram.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief ICMPv4 echo flood over a raw socket, like ping -f.
+ *
+ * In window mode (the default) the flood keeps a fixed number of echo
+ * requests outstanding: every reply releases the next request, and a
+ * request left unanswered for the timeout is given up so a lost packet
+ * cannot stall the flood. In rate mode the requests leave at a fixed
+ * interval whatever the replies.
+ *
+ * The request bytes are built once: each send copies the template,
+ * patches the sequence number and updates the checksum incrementally
+ * (\RFC{1624}). Replies are matched on identifier and sequence number; the
+ * 16-bit sequence number is widened against the last one sent, which is
+ * exact as long as fewer than 2^16 requests are in flight. A reply older
+ * than the newest one already received counts as reordered, a second
+ * reply to the same request as a duplicate; a request never answered by
+ * the end of the simulation is lost.
+ */
+class IcmpEchoFlood
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param socket a raw ICMP socket (ns3::Ipv4RawSocketFactory, protocol 1)
+   * \param destination the echo destination
+   */
+  IcmpEchoFlood (Ptr<Socket> socket, Ipv4Address destination);
+
+  /**
+   * \param identifier the echo identifier, 0 by default
+   */
+  void SetIdentifier (uint16_t identifier);
+  /**
+   * \param size echo data bytes, 56 by default
+   */
+  void SetDataSize (uint32_t size);
+  /**
+   * \brief Keep a number of requests outstanding, the default mode.
+   * \param window the number of outstanding requests, 1 by default
+   */
+  void SetOutstanding (uint32_t window);
+  /**
+   * \brief Send at a fixed rate instead of keeping a window.
+   * \param pps requests per simulated second
+   */
+  void SetRate (double pps);
+  /**
+   * \param timeout the time a window slot waits for its reply, 1 s by default
+   */
+  void SetTimeout (Time timeout);
+
+  /**
+   * \brief Schedule the flood, to run with the simulator.
+   * \param count the number of requests to send
+   */
+  void Start (uint32_t count);
+
+  /**
+   * \returns the number of requests sent
+   */
+  uint64_t GetSent (void) const;
+  /**
+   * \returns the number of requests answered, duplicates excluded
+   */
+  uint64_t GetReceived (void) const;
+  /**
+   * \returns the number of requests sent but not answered
+   */
+  uint64_t GetLost (void) const;
+  /**
+   * \returns the number of replies older than a reply received before them
+   */
+  uint64_t GetReordered (void) const;
+  /**
+   * \returns the number of extra replies to an answered request
+   */
+  uint64_t GetDuplicates (void) const;
+  /**
+   * \returns the number of window slots given up on timeout
+   */
+  uint64_t GetTimeouts (void) const;
+  /**
+   * \returns the simulated time from the first request to the last reply
+   */
+  Time GetDuration (void) const;
+  /**
+   * \returns the smallest round-trip time
+   */
+  Time GetMinRtt (void) const;
+  /**
+   * \returns the mean round-trip time
+   */
+  Time GetMeanRtt (void) const;
+  /**
+   * \returns the largest round-trip time
+   */
+  Time GetMaxRtt (void) const;
+  /**
+   * \returns the distribution of the round-trip times
+   */
+  LatencyHistogram const & GetRttHistogram (void) const;
+
+private:
+  /**
+   * \brief Request state, per sequence.
+   */
+  enum State
+    {
+      PENDING,  //!< sent, no reply yet
+      EXPIRED,  //!< sent, window slot given up
+      ANSWERED  //!< reply received
+    };
+
+  /**
+   * \brief Send the next request.
+   */
+  void Send (void);
+  /**
+   * \brief Send requests until the window is full or the count reached.
+   */
+  void Fill (void);
+  /**
+   * \brief Send a request and schedule the next one, in rate mode.
+   */
+  void Tick (void);
+  /**
+   * \brief Fill the window and give up the requests whose timeout passed,
+   * then wait for the oldest pending one, in window mode.
+   */
+  void Expire (void);
+  /**
+   * \brief Socket receive callback.
+   * \param socket the socket
+   */
+  void Receive (Ptr<Socket> socket);
+  /**
+   * \brief Account for one reply.
+   * \param sequence the 16-bit sequence number of the reply
+   */
+  void Match (uint16_t sequence);
+
+  Ptr<Socket> m_socket;          //!< the raw ICMP socket
+  Ipv4Address m_destination;     //!< echo destination
+  uint16_t m_identifier;         //!< echo identifier
+  uint32_t m_dataSize;           //!< echo data bytes
+  uint32_t m_window;             //!< outstanding requests, window mode
+  double m_rate;                 //!< requests per second, 0 in window mode
+  Time m_timeout;                //!< window slot timeout
+
+  std::vector<uint8_t> m_template; //!< request bytes with sequence number 0
+  uint16_t m_checksum;           //!< template checksum, in Buffer::Iterator::WriteU16 order
+  std::vector<uint8_t> m_request; //!< bytes of the request being sent
+
+  uint32_t m_count;              //!< requests to send
+  std::vector<int64_t> m_sentAt; //!< send time per sequence, in time steps
+  std::vector<uint8_t> m_state;  //!< State per sequence
+  uint32_t m_oldest;             //!< lowest sequence possibly pending
+  uint32_t m_outstanding;        //!< pending requests holding a window slot
+  EventId m_timer;               //!< window timeout or next rate send
+
+  uint64_t m_received;           //!< answered requests
+  uint64_t m_reordered;          //!< replies older than the newest one
+  uint64_t m_duplicates;         //!< extra replies
+  uint64_t m_timeouts;           //!< window slots given up
+  int64_t m_newest;              //!< highest sequence answered, -1 if none
+  Time m_first;                  //!< first send
+  Time m_last;                   //!< last reply
+  Time m_minRtt;                 //!< smallest round-trip time
+  Time m_maxRtt;                 //!< largest round-trip time
+  int64_t m_sumRtt;              //!< sum of round-trip times, in time steps
+  LatencyHistogram m_rttHistogram; //!< round-trip times
+};
+
+} // namespace ns3
+
+#endif /* ICMP_ECHO_FLOOD_H */
@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ICMP_EVENT_LOG_H
+#define ICMP_EVENT_LOG_H
+
+#include "ns3/packet.h"
+
+#include <stdint.h>
+#include <atomic>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Binary log of the ICMP packets a program sends and receives.
+ *
+ * The log is a ring of fixed-size events allocated once by the
+ * constructor. Record claims the next slot with a single atomic
+ * increment and copies the first HEAD_SIZE bytes of the packet into it:
+ * no lock, no allocation and no formatting on the hot path. When the
+ * ring is full the newest events overwrite the oldest ones, and the
+ * number of events lost that way is kept.
+ *
+ * Flush writes the ring as one block, in one write, to a file
+ * descriptor: a block header naming the run, then the events from the
+ * oldest. Blocks of several processes can go to the same file opened
+ * with O_APPEND. Events are written in native byte order and layout;
+ * decode them on the architecture that wrote them.
+ *
+ * ReadBlock and Print are the decoder side: they turn the blocks back
+ * into the text the programs print when not logging, decoding the IP and
+ * ICMP headers from the bytes kept in each event.
+ */
+class IcmpEventLog
+{
+public:
+  /// Packet bytes kept per event, enough for any IPv4 header or an IPv6 one and the ICMP header behind it.
+  static const uint32_t HEAD_SIZE = 76;
+
+  /**
+   * \enum Kind
+   * \brief Which way the packet went.
+   */
+  enum Kind
+    {
+      SENT = 0,    //!< sent on a socket, starting with the ICMP header
+      RECEIVED = 1 //!< received on a raw socket, starting with the IP header
+    };
+
+  /**
+   * \brief One logged packet, 96 bytes.
+   */
+  struct Event
+  {
+    int64_t time;            //!< simulation time, in time steps
+    uint32_t node;           //!< node that sent or received the packet
+    uint32_t size;           //!< packet size
+    uint8_t kind;            //!< a Kind
+    uint8_t family;          //!< 4 or 6
+    uint8_t headSize;        //!< bytes of head used
+    uint8_t reserved;        //!< padding, 0
+    uint8_t head[HEAD_SIZE]; //!< first bytes of the packet
+  };
+
+  /**
+   * \brief One flushed ring, as read back by ReadBlock.
+   */
+  struct Block
+  {
+    std::string name;          //!< what was running, a test case name
+    uint32_t run;              //!< RNG run number
+    uint64_t recorded;         //!< events recorded, lost ones included
+    std::vector<Event> events; //!< events kept, oldest first
+  };
+
+  /**
+   * \brief Constructor, allocates the ring.
+   * \param capacity events kept, rounded up to a power of two
+   */
+  IcmpEventLog (uint32_t capacity);
+
+  /**
+   * \brief Log a packet at the current simulation time.
+   * \param kind which way the packet went
+   * \param family 4 or 6
+   * \param node the node that sent or received it
+   * \param p the packet
+   */
+  void Record (Kind kind, uint8_t family, uint32_t node, Ptr<const Packet> p);
+  /**
+   * \brief Write the ring as one block and empty it.
+   * \param fd the file descriptor, opened with O_APPEND when shared
+   * \param name what was running
+   * \param run the RNG run number
+   * \returns false if the block could not be written whole
+   */
+  bool Flush (int fd, std::string const &name, uint32_t run);
+  /**
+   * \brief Forget every event.
+   */
+  void Clear (void);
+  /**
+   * \returns the number of events recorded since the last Clear
+   */
+  uint64_t GetRecorded (void) const;
+  /**
+   * \returns the number of events kept, at most the capacity
+   */
+  uint32_t GetStored (void) const;
+
+  /**
+   * \brief Read the next block written by Flush.
+   * \param is the input stream, opened in binary mode
+   * \param block receives the block
+   * \returns false at the end of the stream or on a malformed block
+   */
+  static bool ReadBlock (std::istream &is, Block &block);
+  /**
+   * \brief Print an event as the ICMP test cases print their packets.
+   * \param event the event
+   * \param os the output stream
+   */
+  static void Print (Event const &event, std::ostream &os);
+
+private:
+  std::vector<Event> m_events;      //!< the ring
+  uint64_t m_mask;                  //!< capacity - 1
+  std::atomic<uint64_t> m_recorded; //!< events recorded; modulo the capacity, the next slot
+};
+
+} // namespace ns3
+
+#endif /* ICMP_EVENT_LOG_H */
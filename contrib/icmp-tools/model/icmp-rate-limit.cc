@@ -0,0 +1,187 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/icmpv4.h"
+#include "ns3/icmpv4-l4-protocol.h"
+#include "ns3/icmpv6-header.h"
+#include "ns3/icmpv6-l4-protocol.h"
+#include "icmp-rate-limit.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("IcmpRateLimit");
+
+namespace {
+
+/// ICMPv4 Source Quench, not in Icmpv4Header::Type.
+const uint8_t ICMPV4_SOURCE_QUENCH = 4;
+/// ICMPv4 Parameter Problem, not in Icmpv4Header::Type.
+const uint8_t ICMPV4_PARAMETER_PROBLEM = 12;
+/// Buckets a node keeps before the idle ones are forgotten, and the step to the next sweep.
+const uint32_t SWEEP_EVERY = 4096;
+
+} // anonymous namespace
+
+IcmpRateLimit::IcmpRateLimit (Time interval, uint32_t burst)
+  : m_interval (interval.GetTimeStep ()),
+    m_full (interval.GetTimeStep () * burst),
+    m_allowed (0),
+    m_suppressed (0)
+{
+  NS_LOG_FUNCTION (this << interval << burst);
+  NS_ABORT_MSG_UNLESS (burst > 0, "A token bucket holds at least one token");
+}
+
+void
+IcmpRateLimit::Install (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node->GetId ());
+  Ptr<Icmpv4L4Protocol> icmpv4 = node->GetObject<Icmpv4L4Protocol> ();
+  Ptr<Icmpv6L4Protocol> icmpv6 = node->GetObject<Icmpv6L4Protocol> ();
+  NS_ABORT_MSG_IF (icmpv4 == 0 && icmpv6 == 0, "Node " << node->GetId () << " has no ICMP to limit");
+  m_hooks.push_back (Hook ());
+  Hook &hook = m_hooks.back ();
+  hook.limit = this;
+  if (icmpv4 != 0)
+    {
+      hook.downV4 = icmpv4->GetDownTarget ();
+      icmpv4->SetDownTarget (MakeCallback (&Hook::SendV4, &hook));
+    }
+  if (icmpv6 != 0)
+    {
+      hook.downV6 = icmpv6->GetDownTarget6 ();
+      icmpv6->SetDownTarget6 (MakeCallback (&Hook::SendV6, &hook));
+    }
+}
+
+void
+IcmpRateLimit::Install (NodeContainer const &nodes)
+{
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Install (nodes.Get (i));
+    }
+}
+
+bool
+IcmpRateLimit::IsLimitedV4 (uint8_t type, uint8_t code)
+{
+  if (type == Icmpv4Header::ICMPV4_DEST_UNREACH)
+    {
+      return code != Icmpv4DestinationUnreachable::ICMPV4_FRAG_NEEDED;
+    }
+  return type == ICMPV4_SOURCE_QUENCH || type == Icmpv4Header::ICMPV4_TIME_EXCEEDED
+    || type == ICMPV4_PARAMETER_PROBLEM;
+}
+
+bool
+IcmpRateLimit::IsLimitedV6 (uint8_t type)
+{
+  // types below 128 are errors
+  return type < Icmpv6Header::ICMPV6_ECHO_REQUEST && type != Icmpv6Header::ICMPV6_ERROR_PACKET_TOO_BIG;
+}
+
+template <typename A>
+bool
+IcmpRateLimit::Allow (std::map<A, Bucket> &buckets, A const &destination)
+{
+  if (m_interval == 0)
+    {
+      m_allowed++;
+      return true;
+    }
+  int64_t now = Simulator::Now ().GetTimeStep ();
+  typename std::map<A, Bucket>::iterator it = buckets.find (destination);
+  if (it == buckets.end ())
+    {
+      if (!buckets.empty () && buckets.size () % SWEEP_EVERY == 0)
+        {
+          // a bucket full again is no different from a new one
+          for (typename std::map<A, Bucket>::iterator k = buckets.begin (); k != buckets.end (); )
+            {
+              if (k->second.credit + (now - k->second.last) >= m_full)
+                {
+                  buckets.erase (k++);
+                }
+              else
+                {
+                  k++;
+                }
+            }
+        }
+      Bucket bucket = { m_full, now };
+      it = buckets.insert (std::make_pair (destination, bucket)).first;
+    }
+
+  Bucket &bucket = it->second;
+  bucket.credit = std::min (m_full, bucket.credit + (now - bucket.last));
+  bucket.last = now;
+  if (bucket.credit < m_interval)
+    {
+      m_suppressed++;
+      return false;
+    }
+  bucket.credit -= m_interval;
+  m_allowed++;
+  return true;
+}
+
+void
+IcmpRateLimit::Hook::SendV4 (Ptr<Packet> p, Ipv4Address source, Ipv4Address destination, uint8_t protocol,
+                             Ptr<Ipv4Route> route)
+{
+  uint8_t icmp[2] = { 0, 0 };
+  p->CopyData (icmp, sizeof (icmp));
+  if (IsLimitedV4 (icmp[0], icmp[1]) && !limit->Allow (bucketsV4, destination))
+    {
+      NS_LOG_LOGIC ("rate limited ICMP type " << +icmp[0] << " to " << destination);
+      return;
+    }
+  downV4 (p, source, destination, protocol, route);
+}
+
+void
+IcmpRateLimit::Hook::SendV6 (Ptr<Packet> p, Ipv6Address source, Ipv6Address destination, uint8_t protocol,
+                             Ptr<Ipv6Route> route)
+{
+  uint8_t type = 0;
+  p->CopyData (&type, 1);
+  if (IsLimitedV6 (type) && !limit->Allow (bucketsV6, destination))
+    {
+      NS_LOG_LOGIC ("rate limited ICMPv6 type " << +type << " to " << destination);
+      return;
+    }
+  downV6 (p, source, destination, protocol, route);
+}
+
+uint64_t
+IcmpRateLimit::GetAllowed (void) const
+{
+  return m_allowed;
+}
+
+uint64_t
+IcmpRateLimit::GetSuppressed (void) const
+{
+  return m_suppressed;
+}
+
+} // namespace ns3
@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ICMP_RATE_LIMIT_H
+#define ICMP_RATE_LIMIT_H
+
+#include "ns3/ip-l4-protocol.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv6-route.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+
+#include <stdint.h>
+#include <deque>
+#include <map>
+
+namespace ns3 {
+
+/**
+ * \brief Token-bucket limit on the ICMP errors a node sends, per destination, like Linux icmp_ratelimit.
+ *
+ * Install puts the limit between the ICMPv4 and ICMPv6 protocols of a
+ * node and its IP stack, by wrapping their down targets: every message
+ * they send goes through it. Each node keeps one bucket per destination
+ * of its errors. A bucket earns a token every interval, up to burst
+ * tokens, and starts full; an error that finds no token in its bucket is
+ * dropped. The messages limited are those Linux limits by default:
+ * ICMPv4 Destination Unreachable, Source Quench, Time Exceeded and
+ * Parameter Problem, and every ICMPv6 error. Fragmentation Needed and
+ * Packet Too Big always pass, since path MTU discovery depends on them,
+ * as do echoes and neighbor discovery. The global per-host limit Linux
+ * adds on top (icmp_msgs_per_sec) is left out.
+ *
+ * A bucket that has been idle long enough to be full again is the same
+ * as no bucket: they are forgotten as the table grows, so a flood of
+ * distinct sources costs memory in proportion to the errors of the last
+ * burst intervals only. An interval of 0 lets every error through.
+ *
+ * The limit must outlive the simulation, since the nodes keep calling
+ * it.
+ */
+class IcmpRateLimit
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param interval the time a bucket takes to earn a token, 1 s by default as in Linux
+   * \param burst the tokens a bucket holds, 6 by default as in Linux
+   */
+  IcmpRateLimit (Time interval = MilliSeconds (1000), uint32_t burst = 6);
+
+  /**
+   * \brief Limit the ICMP errors of a node with an internet stack.
+   * \param node the node
+   */
+  void Install (Ptr<Node> node);
+  /**
+   * \brief Limit the ICMP errors of several nodes, each with its own buckets.
+   * \param nodes the nodes
+   */
+  void Install (NodeContainer const &nodes);
+
+  /**
+   * \returns the number of errors let through
+   */
+  uint64_t GetAllowed (void) const;
+  /**
+   * \returns the number of errors dropped
+   */
+  uint64_t GetSuppressed (void) const;
+
+  /**
+   * \param type an ICMPv4 type
+   * \param code its code
+   * \returns true if messages of this type and code are limited
+   */
+  static bool IsLimitedV4 (uint8_t type, uint8_t code);
+  /**
+   * \param type an ICMPv6 type
+   * \returns true if messages of this type are limited
+   */
+  static bool IsLimitedV6 (uint8_t type);
+
+private:
+  /**
+   * \brief Token bucket of one destination, in time steps of credit.
+   */
+  struct Bucket
+  {
+    int64_t credit; //!< time earned, an interval per token
+    int64_t last;   //!< when the credit was last brought up to date
+  };
+
+  /**
+   * \brief The limit of one node, between its ICMP protocols and its IP stack.
+   */
+  struct Hook
+  {
+    IcmpRateLimit *limit;                      //!< the limit
+    IpL4Protocol::DownTargetCallback downV4;   //!< IPv4 send of the node
+    IpL4Protocol::DownTargetCallback6 downV6;  //!< IPv6 send of the node
+    std::map<Ipv4Address, Bucket> bucketsV4;   //!< buckets by IPv4 destination
+    std::map<Ipv6Address, Bucket> bucketsV6;   //!< buckets by IPv6 destination
+
+    /**
+     * \brief Down target of the ICMPv4 protocol.
+     * \param p the ICMP message
+     * \param source the source address
+     * \param destination the destination address
+     * \param protocol the protocol number
+     * \param route the route
+     */
+    void SendV4 (Ptr<Packet> p, Ipv4Address source, Ipv4Address destination, uint8_t protocol,
+                 Ptr<Ipv4Route> route);
+    /**
+     * \brief Down target of the ICMPv6 protocol.
+     * \param p the ICMPv6 message
+     * \param source the source address
+     * \param destination the destination address
+     * \param protocol the protocol number
+     * \param route the route
+     */
+    void SendV6 (Ptr<Packet> p, Ipv6Address source, Ipv6Address destination, uint8_t protocol,
+                 Ptr<Ipv6Route> route);
+  };
+
+  /**
+   * \brief Take a token from the bucket of a destination.
+   * \param buckets the buckets of the node, by destination
+   * \param destination the error destination
+   * \returns true if the error may go
+   */
+  template <typename A>
+  bool Allow (std::map<A, Bucket> &buckets, A const &destination);
+
+  int64_t m_interval;          //!< time steps per token
+  int64_t m_full;              //!< credit of a full bucket
+  std::deque<Hook> m_hooks;    //!< hooked nodes, never moved
+  uint64_t m_allowed;          //!< errors let through
+  uint64_t m_suppressed;       //!< errors dropped
+};
+
+} // namespace ns3
+
+#endif /* ICMP_RATE_LIMIT_H */
@@ -0,0 +1,419 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/icmpv4.h"
+#include "ns3/icmpv6-header.h"
+#include "icmp-traceroute.h"
+#include "ipv4-header-view.h"
+#include "ipv6-header-view.h"
+#include "ipv6-extension-chain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("IcmpTraceroute");
+
+namespace {
+
+/// ICMPv4 types the trace sends or matches.
+enum Icmpv4Type
+{
+  V4_ECHO_REPLY = 0,
+  V4_UNREACHABLE = 3,
+  V4_ECHO = 8,
+  V4_TIME_EXCEEDED = 11
+};
+
+/// ICMPv6 types the trace sends or matches.
+enum Icmpv6Type
+{
+  V6_UNREACHABLE = 1,
+  V6_TIME_EXCEEDED = 3,
+  V6_ECHO = 128,
+  V6_ECHO_REPLY = 129
+};
+
+/// ICMPv4 and ICMPv6 protocol numbers.
+const uint8_t PROTOCOL_ICMPV4 = 1;
+const uint8_t PROTOCOL_ICMPV6 = 58;
+
+/// Leading answer bytes read: outer headers, error header, quoted headers and echo header.
+const uint32_t ANSWER_BYTES = 2 * Ipv6ExtensionChain::WINDOW + 16;
+
+/**
+ * \param p the first byte of a 16-bit big-endian field
+ * \returns the field value
+ */
+uint16_t
+Read16 (uint8_t const *p)
+{
+  return (p[0] << 8) | p[1];
+}
+
+} // unnamed namespace
+
+IcmpTraceroute::Hop::Hop ()
+  : kind (NONE),
+    replies (0),
+    sumRtt (0),
+    sumSquaresRtt (0)
+{
+}
+
+Time
+IcmpTraceroute::Hop::GetMeanRtt (void) const
+{
+  return replies ? Seconds (sumRtt / replies) : Time (0);
+}
+
+Time
+IcmpTraceroute::Hop::GetStddevRtt (void) const
+{
+  if (replies == 0)
+    {
+      return Time (0);
+    }
+  double mean = sumRtt / replies;
+  double variance = sumSquaresRtt / replies - mean * mean;
+  return Seconds (variance > 0 ? std::sqrt (variance) : 0);
+}
+
+IcmpTraceroute::IcmpTraceroute (Ptr<Socket> socket, Ipv4Address destination)
+  : m_socket (socket),
+    m_ipv6 (false),
+    m_ipv4Destination (destination),
+    m_identifier (0),
+    m_maxTtl (30),
+    m_probes (3),
+    m_duplicates (0)
+{
+  NS_LOG_FUNCTION (this << socket << destination);
+}
+
+IcmpTraceroute::IcmpTraceroute (Ptr<Socket> socket, Ipv6Address destination)
+  : m_socket (socket),
+    m_ipv6 (true),
+    m_ipv6Destination (destination),
+    m_identifier (0),
+    m_maxTtl (30),
+    m_probes (3),
+    m_duplicates (0)
+{
+  NS_LOG_FUNCTION (this << socket << destination);
+}
+
+void
+IcmpTraceroute::SetIdentifier (uint16_t identifier)
+{
+  m_identifier = identifier;
+}
+
+void
+IcmpTraceroute::SetMaxTtl (uint32_t maxTtl)
+{
+  NS_ASSERT_MSG (maxTtl >= 1 && maxTtl <= 255, "TTL " << maxTtl);
+  m_maxTtl = maxTtl;
+}
+
+void
+IcmpTraceroute::SetProbes (uint32_t probes)
+{
+  NS_ASSERT_MSG (probes >= 1 && probes <= 256, probes << " probes per TTL");
+  m_probes = probes;
+}
+
+void
+IcmpTraceroute::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_hops.empty (), "The trace was already started");
+  m_hops.resize (m_maxTtl);
+  m_sentAt.reserve (m_maxTtl * m_probes);
+  m_answered.assign (m_maxTtl * m_probes, false);
+  m_socket->SetRecvCallback (MakeCallback (&IcmpTraceroute::Receive, this));
+  Simulator::ScheduleWithContext (m_socket->GetNode ()->GetId (), Time (0), &IcmpTraceroute::Burst, this);
+}
+
+void
+IcmpTraceroute::Burst (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t ttl = 1; ttl <= m_maxTtl; ttl++)
+    {
+      if (m_ipv6)
+        {
+          m_socket->SetIpv6HopLimit (ttl);
+        }
+      else
+        {
+          m_socket->SetIpTtl (ttl);
+        }
+      for (uint32_t k = 0; k < m_probes; k++)
+        {
+          // the sequence number is the probe index, TTL-major
+          uint16_t sequence = m_sentAt.size ();
+          Ptr<Packet> p = Create<Packet> ();
+          int sent;
+          if (m_ipv6)
+            {
+              Icmpv6Echo echo (true);
+              echo.SetId (m_identifier);
+              echo.SetSeq (sequence);
+              p->AddHeader (echo);
+              m_sentAt.push_back (Simulator::Now ().GetTimeStep ());
+              sent = m_socket->SendTo (p, 0, Inet6SocketAddress (m_ipv6Destination, 0));
+            }
+          else
+            {
+              Icmpv4Echo echo;
+              echo.SetIdentifier (m_identifier);
+              echo.SetSequenceNumber (sequence);
+              p->AddHeader (echo);
+              Icmpv4Header header;
+              header.SetType (Icmpv4Header::ICMPV4_ECHO);
+              header.SetCode (0);
+              p->AddHeader (header);
+              m_sentAt.push_back (Simulator::Now ().GetTimeStep ());
+              sent = m_socket->SendTo (p, 0, InetSocketAddress (m_ipv4Destination, 0));
+            }
+          if (sent < 0)
+            {
+              NS_LOG_WARN ("Failed to send probe " << k << " with TTL " << ttl);
+            }
+        }
+    }
+}
+
+void
+IcmpTraceroute::Receive (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()))
+    {
+      // raw sockets deliver the IP header in front of the ICMP message
+      uint8_t bytes[ANSWER_BYTES];
+      uint32_t size = p->CopyData (bytes, sizeof (bytes));
+      if (m_ipv6)
+        {
+          ReceiveV6 (bytes, size);
+        }
+      else
+        {
+          ReceiveV4 (bytes, size);
+        }
+    }
+}
+
+void
+IcmpTraceroute::ReceiveV4 (uint8_t const *bytes, uint32_t size)
+{
+  Ipv4HeaderView outer (bytes, size);
+  if (!outer.IsValid () || outer.GetProtocol () != PROTOCOL_ICMPV4 || size < outer.GetHeaderSize () + 8)
+    {
+      return;
+    }
+  uint8_t const *icmp = bytes + outer.GetHeaderSize ();
+  uint32_t left = size - outer.GetHeaderSize ();
+  Kind kind;
+  switch (icmp[0])
+    {
+    case V4_ECHO_REPLY:
+      Match (icmp, ECHO_REPLY, outer.GetSource (), Ipv6Address ());
+      return;
+    case V4_TIME_EXCEEDED:
+      kind = TIME_EXCEEDED;
+      break;
+    case V4_UNREACHABLE:
+      kind = UNREACHABLE;
+      break;
+    default:
+      return;
+    }
+
+  // the error quotes the probe's IPv4 header and the first 8 bytes after it
+  Ipv4HeaderView inner (icmp + 8, left - 8);
+  if (!inner.IsValid () || inner.GetProtocol () != PROTOCOL_ICMPV4
+      || inner.GetDestination () != m_ipv4Destination || left < 8 + inner.GetHeaderSize () + 8)
+    {
+      return;
+    }
+  uint8_t const *echo = icmp + 8 + inner.GetHeaderSize ();
+  if (echo[0] == V4_ECHO)
+    {
+      Match (echo, kind, outer.GetSource (), Ipv6Address ());
+    }
+}
+
+void
+IcmpTraceroute::ReceiveV6 (uint8_t const *bytes, uint32_t size)
+{
+  Ipv6ExtensionChain outer;
+  if (outer.Walk (bytes, size) != Ipv6ExtensionChain::CHAIN_OK || outer.GetProtocol () != PROTOCOL_ICMPV6
+      || size < outer.GetUpperLayerOffset () + 8)
+    {
+      return;
+    }
+  Ipv6Address source = Ipv6HeaderView (bytes, size).GetSourceAddress ();
+  uint8_t const *icmp = bytes + outer.GetUpperLayerOffset ();
+  uint32_t left = size - outer.GetUpperLayerOffset ();
+  Kind kind;
+  switch (icmp[0])
+    {
+    case V6_ECHO_REPLY:
+      Match (icmp, ECHO_REPLY, Ipv4Address (), source);
+      return;
+    case V6_TIME_EXCEEDED:
+      kind = TIME_EXCEEDED;
+      break;
+    case V6_UNREACHABLE:
+      kind = UNREACHABLE;
+      break;
+    default:
+      return;
+    }
+
+  // the error quotes as much of the probe as fits, extension headers included
+  Ipv6ExtensionChain inner;
+  if (inner.Walk (icmp + 8, left - 8) != Ipv6ExtensionChain::CHAIN_OK || inner.GetProtocol () != PROTOCOL_ICMPV6
+      || Ipv6HeaderView (icmp + 8, left - 8).GetDestinationAddress () != m_ipv6Destination
+      || left < 8 + inner.GetUpperLayerOffset () + 8)
+    {
+      return;
+    }
+  uint8_t const *echo = icmp + 8 + inner.GetUpperLayerOffset ();
+  if (echo[0] == V6_ECHO)
+    {
+      Match (echo, kind, Ipv4Address (), source);
+    }
+}
+
+void
+IcmpTraceroute::Match (uint8_t const *echo, Kind kind, Ipv4Address ipv4, Ipv6Address ipv6)
+{
+  uint16_t sequence = Read16 (echo + 6);
+  if (Read16 (echo + 4) != m_identifier || sequence >= m_sentAt.size ())
+    {
+      return;
+    }
+  if (m_answered[sequence])
+    {
+      m_duplicates++;
+      return;
+    }
+  m_answered[sequence] = true;
+
+  Hop &hop = m_hops[sequence / m_probes];
+  Time rtt = Simulator::Now () - TimeStep (m_sentAt[sequence]);
+  NS_LOG_LOGIC ("Probe " << sequence << " answered after " << rtt.As (Time::US));
+  if (hop.replies == 0)
+    {
+      hop.kind = kind;
+      hop.ipv4 = ipv4;
+      hop.ipv6 = ipv6;
+      hop.minRtt = rtt;
+      hop.maxRtt = rtt;
+    }
+  hop.replies++;
+  hop.minRtt = std::min (hop.minRtt, rtt);
+  hop.maxRtt = std::max (hop.maxRtt, rtt);
+  double seconds = rtt.GetSeconds ();
+  hop.sumRtt += seconds;
+  hop.sumSquaresRtt += seconds * seconds;
+}
+
+uint32_t
+IcmpTraceroute::GetPathLength (void) const
+{
+  for (uint32_t k = 0; k < m_hops.size (); k++)
+    {
+      if (m_hops[k].kind == ECHO_REPLY || m_hops[k].kind == UNREACHABLE)
+        {
+          return k + 1;
+        }
+    }
+  return 0;
+}
+
+IcmpTraceroute::Hop const &
+IcmpTraceroute::GetHop (uint32_t ttl) const
+{
+  NS_ASSERT_MSG (ttl >= 1 && ttl <= m_hops.size (), "TTL " << ttl << " was not probed");
+  return m_hops[ttl - 1];
+}
+
+uint32_t
+IcmpTraceroute::GetDuplicates (void) const
+{
+  return m_duplicates;
+}
+
+void
+IcmpTraceroute::Print (std::ostream &os) const
+{
+  uint32_t length = GetPathLength ();
+  uint32_t last = length ? length : m_hops.size ();
+  std::ios_base::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  os << "traceroute to ";
+  if (m_ipv6)
+    {
+      os << m_ipv6Destination;
+    }
+  else
+    {
+      os << m_ipv4Destination;
+    }
+  os << ", " << m_maxTtl << " hops max, " << m_probes << " probes per hop" << std::endl;
+  for (uint32_t ttl = 1; ttl <= last; ttl++)
+    {
+      Hop const &hop = m_hops[ttl - 1];
+      os << std::setw (3) << ttl << "  ";
+      if (hop.replies == 0)
+        {
+          os << "*" << std::endl;
+          continue;
+        }
+      if (m_ipv6)
+        {
+          os << hop.ipv6;
+        }
+      else
+        {
+          os << hop.ipv4;
+        }
+      os << "  " << hop.replies << "/" << m_probes << "  rtt min/avg/max/mdev "
+         << std::fixed << std::setprecision (3) << hop.minRtt.GetSeconds () * 1e3
+         << "/" << hop.GetMeanRtt ().GetSeconds () * 1e3
+         << "/" << hop.maxRtt.GetSeconds () * 1e3
+         << "/" << hop.GetStddevRtt ().GetSeconds () * 1e3 << " ms"
+         << (hop.kind == UNREACHABLE ? "  !U" : "") << std::endl;
+      os.flags (flags);
+      os.precision (precision);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,189 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ICMP_TRACEROUTE_H
+#define ICMP_TRACEROUTE_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/nstime.h"
+#include "ns3/socket.h"
+
+#include <stdint.h>
+#include <ostream>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Traceroute over an IPv4 or IPv6 raw ICMP socket, all hops at once.
+ *
+ * Start sends every probe in a single burst: for each TTL (hop limit)
+ * from 1 to the maximum, a number of echo requests whose sequence number
+ * encodes the TTL and the probe. The path is then known one round trip
+ * later rather than after one round trip per hop.
+ *
+ * Echo replies carry the sequence number themselves. Time Exceeded and
+ * Destination Unreachable errors are matched by parsing the header they
+ * quote: the inner IP header must be addressed to the destination and
+ * carry one of our echo requests, whose identifier and sequence number
+ * identify the probe. Each hop keeps the first address that answered it
+ * and the RTT statistics of its answered probes.
+ *
+ * The burst leaves all at once: the first router's ARP or neighbor cache
+ * entry must hold every probe while the address is resolved (see
+ * IcmpTopology::SetPendingQueueSize), or the probes past the queue size
+ * are lost.
+ */
+class IcmpTraceroute
+{
+public:
+  /**
+   * \enum Kind
+   * \brief What answered the probes of a hop.
+   */
+  enum Kind
+    {
+      NONE,          //!< no answer
+      TIME_EXCEEDED, //!< a router on the path
+      UNREACHABLE,   //!< a node that cannot deliver to the destination
+      ECHO_REPLY     //!< the destination
+    };
+
+  /**
+   * \brief The answers to the probes of one TTL.
+   */
+  struct Hop
+  {
+    Kind kind;            //!< what answered first
+    Ipv4Address ipv4;     //!< first responder, IPv4 trace
+    Ipv6Address ipv6;     //!< first responder, IPv6 trace
+    uint32_t replies;     //!< answered probes
+    Time minRtt;          //!< smallest RTT
+    Time maxRtt;          //!< largest RTT
+    double sumRtt;        //!< sum of the RTTs, in seconds
+    double sumSquaresRtt; //!< sum of the squared RTTs, in square seconds
+
+    Hop ();
+    /**
+     * \returns the mean RTT, 0 without replies
+     */
+    Time GetMeanRtt (void) const;
+    /**
+     * \returns the standard deviation of the RTTs, 0 without replies
+     */
+    Time GetStddevRtt (void) const;
+  };
+
+  /**
+   * \brief Trace the path to an IPv4 destination.
+   * \param socket a raw ICMP socket (ns3::Ipv4RawSocketFactory, protocol 1)
+   * \param destination the destination
+   */
+  IcmpTraceroute (Ptr<Socket> socket, Ipv4Address destination);
+  /**
+   * \brief Trace the path to an IPv6 destination.
+   * \param socket a raw ICMPv6 socket (ns3::Ipv6RawSocketFactory, protocol 58)
+   * \param destination the destination
+   */
+  IcmpTraceroute (Ptr<Socket> socket, Ipv6Address destination);
+
+  /**
+   * \param identifier the echo identifier, distinct per concurrent trace
+   */
+  void SetIdentifier (uint16_t identifier);
+  /**
+   * \param maxTtl the largest TTL probed, 30 by default, at most 255
+   */
+  void SetMaxTtl (uint32_t maxTtl);
+  /**
+   * \param probes the probes per TTL, 3 by default
+   */
+  void SetProbes (uint32_t probes);
+
+  /**
+   * \brief Schedule the burst, to run with the simulator.
+   */
+  void Start (void);
+
+  /**
+   * \returns the TTL at which the destination, or a node unable to reach
+   * it, answered; 0 if none did
+   */
+  uint32_t GetPathLength (void) const;
+  /**
+   * \param ttl a TTL, from 1 to the maximum
+   * \returns the answers to the probes with that TTL
+   */
+  Hop const & GetHop (uint32_t ttl) const;
+  /**
+   * \returns the number of answers to an already answered probe
+   */
+  uint32_t GetDuplicates (void) const;
+
+  /**
+   * \brief Print the trace, one line per hop, like traceroute.
+   * \param os the output stream
+   */
+  void Print (std::ostream &os) const;
+
+private:
+  /**
+   * \brief Send every probe.
+   */
+  void Burst (void);
+  /**
+   * \brief Socket receive callback.
+   * \param socket the socket
+   */
+  void Receive (Ptr<Socket> socket);
+  /**
+   * \brief Match an IPv4 answer to its probe.
+   * \param bytes the packet, from its IPv4 header
+   * \param size number of bytes available
+   */
+  void ReceiveV4 (uint8_t const *bytes, uint32_t size);
+  /**
+   * \brief Match an IPv6 answer to its probe.
+   * \param bytes the packet, from its IPv6 header
+   * \param size number of bytes available
+   */
+  void ReceiveV6 (uint8_t const *bytes, uint32_t size);
+  /**
+   * \brief Account for the answer to a probe.
+   * \param echo the echo request header the answer is about
+   * \param kind the kind of answer
+   * \param ipv4 the responder, IPv4 trace
+   * \param ipv6 the responder, IPv6 trace
+   */
+  void Match (uint8_t const *echo, Kind kind, Ipv4Address ipv4, Ipv6Address ipv6);
+
+  Ptr<Socket> m_socket;             //!< the raw socket
+  bool m_ipv6;                      //!< true for an IPv6 trace
+  Ipv4Address m_ipv4Destination;    //!< destination, IPv4 trace
+  Ipv6Address m_ipv6Destination;    //!< destination, IPv6 trace
+  uint16_t m_identifier;            //!< echo identifier
+  uint32_t m_maxTtl;                //!< largest TTL probed
+  uint32_t m_probes;                //!< probes per TTL
+  std::vector<int64_t> m_sentAt;    //!< send time per probe, in time steps
+  std::vector<uint8_t> m_answered;  //!< true per answered probe
+  std::vector<Hop> m_hops;          //!< answers per TTL, from TTL 1
+  uint32_t m_duplicates;            //!< extra answers
+};
+
+} // namespace ns3
+
+#endif /* ICMP_TRACEROUTE_H */
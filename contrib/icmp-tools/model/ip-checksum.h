@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IP_CHECKSUM_H
+#define IP_CHECKSUM_H
+
+#include <stdint.h>
+#include "ns3/buffer.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4
+ *
+ * \brief Internet checksum (\RFC{1071}) over contiguous memory.
+ *
+ * A drop-in replacement for Buffer::Iterator::CalculateIpChecksum, which
+ * walks the buffer one 16-bit word at a time through the iterator. The
+ * ones' complement sum is computed by a vectorized kernel (AVX2 or SSE2,
+ * picked at runtime from the CPU features) with a portable 64-bit scalar
+ * fallback.
+ *
+ * The returned value has the same byte order as the one returned by
+ * Buffer::Iterator::CalculateIpChecksum: it is meant to be written with
+ * Buffer::Iterator::WriteU16, and initialChecksum is taken in that same
+ * order.
+ */
+class IpChecksum
+{
+public:
+  /**
+   * \enum Kernel
+   * \brief Implementations of the ones' complement sum.
+   */
+  enum Kernel
+    {
+      AUTO,   //!< Best kernel supported by this CPU
+      SCALAR, //!< Portable 64-bit accumulator
+      SSE2,   //!< 16 bytes per step (x86 only)
+      AVX2    //!< 32 bytes per step (x86 only)
+    };
+
+  /**
+   * \brief Compute the checksum of a memory area.
+   * \param data the first byte to sum
+   * \param size number of bytes to sum
+   * \param initialChecksum value added to the sum, e.g. a pseudo-header sum
+   * \param kernel the implementation to use
+   * \returns the checksum
+   */
+  static uint16_t Calculate (uint8_t const *data, uint32_t size,
+                             uint32_t initialChecksum = 0, Kernel kernel = AUTO);
+  /**
+   * \brief Compute the checksum of a buffer area.
+   *
+   * The bytes are copied out of the buffer in large chunks and summed with
+   * the fastest kernel, so this is cheaper than
+   * Buffer::Iterator::CalculateIpChecksum for anything but a handful of bytes.
+   *
+   * \param start the first byte to sum
+   * \param size number of bytes to sum
+   * \param initialChecksum value added to the sum, e.g. a pseudo-header sum
+   * \returns the checksum
+   */
+  static uint16_t Calculate (Buffer::Iterator start, uint32_t size,
+                             uint32_t initialChecksum = 0);
+  /**
+   * \param kernel a checksum kernel
+   * \returns true if the kernel can run on this CPU
+   */
+  static bool IsSupported (Kernel kernel);
+  /**
+   * \param kernel a checksum kernel
+   * \returns the name of the kernel, AUTO being resolved to the kernel it picks
+   */
+  static const char * GetKernelName (Kernel kernel);
+
+private:
+  /**
+   * \brief Add size bytes to a partial ones' complement sum.
+   *
+   * Words are loaded in host byte order; the result must go through Fold.
+   *
+   * \param data the first byte to sum
+   * \param size number of bytes to sum
+   * \param sum the partial sum so far
+   * \param kernel the implementation to use, never AUTO
+   * \returns the new partial sum
+   */
+  static uint64_t PartialSum (uint8_t const *data, uint32_t size, uint64_t sum, Kernel kernel);
+  /**
+   * \brief Fold a partial sum into the final checksum.
+   * \param sum the partial sum
+   * \returns the checksum, in Buffer::Iterator::WriteU16 order
+   */
+  static uint16_t Fold (uint64_t sum);
+  /**
+   * \returns the kernel AUTO stands for on this CPU
+   */
+  static Kernel GetBestKernel (void);
+};
+
+} // namespace ns3
+
+#endif /* IP_CHECKSUM_H */
@@ -0,0 +1,370 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ip-flow-key.h"
+#include "ipv4-header-view.h"
+#include "ipv6-header-view.h"
+#include "ipv6-extension-chain.h"
+
+#include <cstring>
+
+#if (defined (__x86_64__) || defined (__i386__)) && defined (__GNUC__)
+#define IP_FLOW_KEY_X86 1
+#include <immintrin.h>
+#endif
+
+namespace ns3 {
+
+namespace {
+
+/// Number of 32-bit words hashed.
+const uint32_t HASHED_WORDS = IpFlowKey::HASHED_SIZE / 4;
+/// MurmurHash3 block constants.
+const uint32_t C1 = 0xcc9e2d51;
+const uint32_t C2 = 0x1b873593; //!< see C1
+
+/**
+ * \param data the first byte of a big-endian 16-bit field
+ * \returns the field value
+ */
+inline uint16_t
+ReadU16 (uint8_t const *data)
+{
+  return (data[0] << 8) | data[1];
+}
+
+/**
+ * \param x a word
+ * \param r rotation count
+ * \returns x rotated left by r bits
+ */
+inline uint32_t
+Rotl (uint32_t x, uint32_t r)
+{
+  return (x << r) | (x >> (32 - r));
+}
+
+/**
+ * \brief Read the upper-layer flow fields.
+ * \param protocol the upper-layer protocol
+ * \param l4 the first byte of the upper-layer header
+ * \param size number of bytes available at l4
+ * \param key receives the ports, or the echo identifier and sequence
+ */
+void
+ExtractPorts (uint8_t protocol, uint8_t const *l4, uint32_t size, IpFlowKey &key)
+{
+  switch (protocol)
+    {
+    case 6:   // TCP
+    case 17:  // UDP
+    case 33:  // DCCP
+    case 132: // SCTP
+    case 136: // UDP-Lite
+      if (size >= 4)
+        {
+          key.sourcePort = ReadU16 (l4);
+          key.destinationPort = ReadU16 (l4 + 2);
+        }
+      break;
+    case 1:  // ICMP
+    case 58: // ICMPv6
+      {
+        // echo reply and echo request, or echo request and echo reply
+        bool echo = size >= 8
+          && (protocol == 1 ? (l4[0] == 0 || l4[0] == 8) : (l4[0] == 128 || l4[0] == 129));
+        if (echo)
+          {
+            key.sourcePort = ReadU16 (l4 + 4);
+            key.sequence = ReadU16 (l4 + 6);
+          }
+        break;
+      }
+    default:
+      break;
+    }
+}
+
+#ifdef IP_FLOW_KEY_X86
+/**
+ * \param a four words
+ * \param b four words
+ * \returns the four low 32-bit halves of a * b
+ */
+__attribute__ ((target ("sse2")))
+inline __m128i
+Mul32 (__m128i a, __m128i b)
+{
+  // SSE2 only multiplies the even lanes, into 64 bits
+  __m128i even = _mm_mul_epu32 (a, b);
+  __m128i odd = _mm_mul_epu32 (_mm_srli_epi64 (a, 32), _mm_srli_epi64 (b, 32));
+  return _mm_unpacklo_epi32 (_mm_shuffle_epi32 (even, _MM_SHUFFLE (0, 0, 2, 0)),
+                             _mm_shuffle_epi32 (odd, _MM_SHUFFLE (0, 0, 2, 0)));
+}
+
+/**
+ * \brief Mix one word of four keys into four hashes.
+ * \param h the four hashes
+ * \param k word j of each of the four keys
+ * \returns the four updated hashes
+ */
+__attribute__ ((target ("sse2")))
+inline __m128i
+MixWord (__m128i h, __m128i k)
+{
+  k = Mul32 (k, _mm_set1_epi32 (C1));
+  k = _mm_or_si128 (_mm_slli_epi32 (k, 15), _mm_srli_epi32 (k, 17));
+  k = Mul32 (k, _mm_set1_epi32 (C2));
+  h = _mm_xor_si128 (h, k);
+  h = _mm_or_si128 (_mm_slli_epi32 (h, 13), _mm_srli_epi32 (h, 19));
+  // h * 5 + 0xe6546b64
+  return _mm_add_epi32 (_mm_add_epi32 (h, _mm_slli_epi32 (h, 2)),
+                        _mm_set1_epi32 (static_cast<int> (0xe6546b64)));
+}
+
+/**
+ * \brief SSE2 kernel: hash four keys, one per lane.
+ * \param keys four consecutive keys
+ * \param hashes receives the four hashes
+ * \param seed the hash seed
+ */
+__attribute__ ((target ("sse2")))
+void
+Hash4 (IpFlowKey const *keys, uint32_t *hashes, uint32_t seed)
+{
+  uint8_t const *bytes = reinterpret_cast<uint8_t const *> (keys);
+  __m128i h = _mm_set1_epi32 (seed);
+  for (uint32_t block = 0; block < HASHED_WORDS; block += 4)
+    {
+      // transpose four words of four keys so that each register holds word j of every key
+      __m128i r0 = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (bytes + block * 4));
+      __m128i r1 = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (bytes + sizeof (IpFlowKey) + block * 4));
+      __m128i r2 = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (bytes + 2 * sizeof (IpFlowKey) + block * 4));
+      __m128i r3 = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (bytes + 3 * sizeof (IpFlowKey) + block * 4));
+      __m128i t0 = _mm_unpacklo_epi32 (r0, r1);
+      __m128i t1 = _mm_unpacklo_epi32 (r2, r3);
+      __m128i t2 = _mm_unpackhi_epi32 (r0, r1);
+      __m128i t3 = _mm_unpackhi_epi32 (r2, r3);
+      h = MixWord (h, _mm_unpacklo_epi64 (t0, t1));
+      h = MixWord (h, _mm_unpackhi_epi64 (t0, t1));
+      h = MixWord (h, _mm_unpacklo_epi64 (t2, t3));
+      if (block + 3 < HASHED_WORDS)
+        {
+          h = MixWord (h, _mm_unpackhi_epi64 (t2, t3));
+        }
+    }
+  // finalization
+  h = _mm_xor_si128 (h, _mm_set1_epi32 (IpFlowKey::HASHED_SIZE));
+  h = _mm_xor_si128 (h, _mm_srli_epi32 (h, 16));
+  h = Mul32 (h, _mm_set1_epi32 (static_cast<int> (0x85ebca6b)));
+  h = _mm_xor_si128 (h, _mm_srli_epi32 (h, 13));
+  h = Mul32 (h, _mm_set1_epi32 (static_cast<int> (0xc2b2ae35)));
+  h = _mm_xor_si128 (h, _mm_srli_epi32 (h, 16));
+  _mm_storeu_si128 (reinterpret_cast<__m128i *> (hashes), h);
+}
+
+/**
+ * \brief Mix one word of eight keys into eight hashes.
+ * \param h the eight hashes
+ * \param k word j of each of the eight keys
+ * \returns the eight updated hashes
+ */
+__attribute__ ((target ("avx2")))
+inline __m256i
+MixWord8 (__m256i h, __m256i k)
+{
+  k = _mm256_mullo_epi32 (k, _mm256_set1_epi32 (C1));
+  k = _mm256_or_si256 (_mm256_slli_epi32 (k, 15), _mm256_srli_epi32 (k, 17));
+  k = _mm256_mullo_epi32 (k, _mm256_set1_epi32 (C2));
+  h = _mm256_xor_si256 (h, k);
+  h = _mm256_or_si256 (_mm256_slli_epi32 (h, 13), _mm256_srli_epi32 (h, 19));
+  return _mm256_add_epi32 (_mm256_add_epi32 (h, _mm256_slli_epi32 (h, 2)),
+                           _mm256_set1_epi32 (static_cast<int> (0xe6546b64)));
+}
+
+/**
+ * \brief AVX2 kernel: hash eight keys, one per lane.
+ *
+ * Keys 0 to 3 go through the low 128-bit half and keys 4 to 7 through
+ * the high one, so the transpose is the SSE2 one done twice at once.
+ *
+ * \param keys eight consecutive keys
+ * \param hashes receives the eight hashes
+ * \param seed the hash seed
+ */
+__attribute__ ((target ("avx2")))
+void
+Hash8 (IpFlowKey const *keys, uint32_t *hashes, uint32_t seed)
+{
+  uint8_t const *bytes = reinterpret_cast<uint8_t const *> (keys);
+  __m256i h = _mm256_set1_epi32 (seed);
+  __m256i r[4];
+  for (uint32_t block = 0; block < HASHED_WORDS; block += 4)
+    {
+      for (uint32_t j = 0; j < 4; j++)
+        {
+          __m128i low = _mm_loadu_si128 (reinterpret_cast<__m128i const *>
+                                           (bytes + j * sizeof (IpFlowKey) + block * 4));
+          __m128i high = _mm_loadu_si128 (reinterpret_cast<__m128i const *>
+                                            (bytes + (j + 4) * sizeof (IpFlowKey) + block * 4));
+          r[j] = _mm256_inserti128_si256 (_mm256_castsi128_si256 (low), high, 1);
+        }
+      __m256i t0 = _mm256_unpacklo_epi32 (r[0], r[1]);
+      __m256i t1 = _mm256_unpacklo_epi32 (r[2], r[3]);
+      __m256i t2 = _mm256_unpackhi_epi32 (r[0], r[1]);
+      __m256i t3 = _mm256_unpackhi_epi32 (r[2], r[3]);
+      h = MixWord8 (h, _mm256_unpacklo_epi64 (t0, t1));
+      h = MixWord8 (h, _mm256_unpackhi_epi64 (t0, t1));
+      h = MixWord8 (h, _mm256_unpacklo_epi64 (t2, t3));
+      if (block + 3 < HASHED_WORDS)
+        {
+          h = MixWord8 (h, _mm256_unpackhi_epi64 (t2, t3));
+        }
+    }
+  h = _mm256_xor_si256 (h, _mm256_set1_epi32 (IpFlowKey::HASHED_SIZE));
+  h = _mm256_xor_si256 (h, _mm256_srli_epi32 (h, 16));
+  h = _mm256_mullo_epi32 (h, _mm256_set1_epi32 (static_cast<int> (0x85ebca6b)));
+  h = _mm256_xor_si256 (h, _mm256_srli_epi32 (h, 13));
+  h = _mm256_mullo_epi32 (h, _mm256_set1_epi32 (static_cast<int> (0xc2b2ae35)));
+  h = _mm256_xor_si256 (h, _mm256_srli_epi32 (h, 16));
+  _mm256_storeu_si256 (reinterpret_cast<__m256i *> (hashes), h);
+}
+#endif /* IP_FLOW_KEY_X86 */
+
+} // anonymous namespace
+
+bool
+IpFlowKey::Extract (uint8_t const *data, uint32_t size, IpFlowKey &key)
+{
+  std::memset (&key, 0, sizeof (key));
+  if (size == 0)
+    {
+      return false;
+    }
+  key.version = data[0] >> 4;
+  if (key.version == 4)
+    {
+      Ipv4HeaderView ipv4 (data, size);
+      if (!ipv4.IsValid ())
+        {
+          return false;
+        }
+      std::memcpy (key.source, data + 12, 4);
+      std::memcpy (key.destination, data + 16, 4);
+      key.protocol = ipv4.GetProtocol ();
+      if (ipv4.IsLastFragment () && ipv4.GetFragmentOffset () == 0)
+        {
+          uint32_t offset = ipv4.GetHeaderSize ();
+          ExtractPorts (key.protocol, data + offset, size - offset, key);
+        }
+      return true;
+    }
+  if (key.version == 6)
+    {
+      Ipv6HeaderView ipv6 (data, size);
+      if (!ipv6.IsValid ())
+        {
+          return false;
+        }
+      std::memcpy (key.source, data + 8, 16);
+      std::memcpy (key.destination, data + 24, 16);
+      key.flowLabel = ipv6.GetFlowLabel ();
+      key.protocol = ipv6.GetNextHeader ();
+      if (Ipv6ExtensionChain::IsExtension (key.protocol))
+        {
+          Ipv6ExtensionChain chain;
+          if (chain.Walk (data, size) != Ipv6ExtensionChain::CHAIN_OK)
+            {
+              // keyed on the addresses and the first next header
+              return true;
+            }
+          key.protocol = chain.GetProtocol ();
+          if (chain.IsFragment ())
+            {
+              return true;
+            }
+          uint32_t offset = chain.GetUpperLayerOffset ();
+          ExtractPorts (key.protocol, data + offset, size - offset, key);
+        }
+      else
+        {
+          ExtractPorts (key.protocol, data + Ipv6HeaderView::SIZE, size - Ipv6HeaderView::SIZE, key);
+        }
+      return true;
+    }
+  return false;
+}
+
+uint32_t
+IpFlowKey::Hash (IpFlowKey const &key, uint32_t seed)
+{
+  uint8_t const *bytes = reinterpret_cast<uint8_t const *> (&key);
+  uint32_t h = seed;
+  for (uint32_t j = 0; j < HASHED_WORDS; j++)
+    {
+      uint32_t k;
+      std::memcpy (&k, bytes + 4 * j, 4);
+      k *= C1;
+      k = Rotl (k, 15);
+      k *= C2;
+      h ^= k;
+      h = Rotl (h, 13);
+      h = h * 5 + 0xe6546b64;
+    }
+  h ^= HASHED_SIZE;
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+void
+IpFlowKey::Hash (IpFlowKey const *keys, uint32_t count, uint32_t *hashes, uint32_t seed)
+{
+  uint32_t k = 0;
+#ifdef IP_FLOW_KEY_X86
+  static const bool avx2 = __builtin_cpu_supports ("avx2");
+  static const bool sse2 = __builtin_cpu_supports ("sse2");
+  if (avx2)
+    {
+      for (; k + 8 <= count; k += 8)
+        {
+          Hash8 (keys + k, hashes + k, seed);
+        }
+    }
+  if (sse2)
+    {
+      for (; k + 4 <= count; k += 4)
+        {
+          Hash4 (keys + k, hashes + k, seed);
+        }
+    }
+#endif /* IP_FLOW_KEY_X86 */
+  for (; k < count; k++)
+    {
+      hashes[k] = Hash (keys[k], seed);
+    }
+}
+
+bool
+IpFlowKey::operator== (IpFlowKey const &o) const
+{
+  return std::memcmp (this, &o, HASHED_SIZE) == 0;
+}
+
+} // namespace ns3
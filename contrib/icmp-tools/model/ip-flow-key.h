@@ -0,0 +1,95 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IP_FLOW_KEY_H
+#define IP_FLOW_KEY_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup internet
+ *
+ * \brief Flow identity of an IPv4 or IPv6 packet, for ECMP and flow tables.
+ *
+ * Extract fills the key straight from the serialized packet bytes: the
+ * addresses, the protocol (past any IPv6 extension headers), the IPv6
+ * flow label and the TCP, UDP, DCCP or SCTP ports. An ICMP or ICMPv6 echo
+ * is keyed on its identifier, carried as the source port, and its
+ * sequence number is reported beside the key but left out of the hash so
+ * that every echo of a ping session lands on the same path. Fragments
+ * are keyed on addresses and protocol only, since only the first one
+ * carries the ports: every fragment of a packet then hashes alike.
+ *
+ * The first HASHED_SIZE bytes are the key proper: they are compared by
+ * operator== and hashed by Hash. Unused bytes are zero, IPv4 addresses
+ * take the first four bytes of the address fields.
+ *
+ * Hash is MurmurHash3 (x86, 32-bit) of the key bytes read as host-order
+ * words. The batch overload hashes eight keys at once in AVX2 lanes, or
+ * four in SSE2 lanes, picked at runtime from the CPU features, and
+ * returns the same values as the single-key one.
+ */
+struct IpFlowKey
+{
+  /// Number of leading key bytes compared and hashed.
+  static const uint32_t HASHED_SIZE = 44;
+
+  uint8_t source[16];       //!< source address, network order
+  uint8_t destination[16];  //!< destination address, network order
+  uint32_t flowLabel;       //!< IPv6 flow label, 0 for IPv4
+  uint8_t version;          //!< 4 or 6
+  uint8_t protocol;         //!< upper-layer protocol
+  uint16_t padding;         //!< always 0
+  uint16_t sourcePort;      //!< source port, or ICMP echo identifier
+  uint16_t destinationPort; //!< destination port, 0 for ICMP echo
+  uint16_t sequence;        //!< ICMP echo sequence number, not hashed
+  uint16_t reserved;        //!< always 0
+
+  /**
+   * \brief Build the key of a serialized packet.
+   * \param data the first byte of the IPv4 or IPv6 header
+   * \param size number of bytes available at data
+   * \param key receives the key
+   * \returns false if the bytes do not start with a valid IP header
+   */
+  static bool Extract (uint8_t const *data, uint32_t size, IpFlowKey &key);
+  /**
+   * \param key a key
+   * \param seed the hash seed, e.g. per router to avoid polarization
+   * \returns the hash of the key
+   */
+  static uint32_t Hash (IpFlowKey const &key, uint32_t seed = 0);
+  /**
+   * \brief Hash many keys.
+   * \param keys the keys
+   * \param count number of keys
+   * \param hashes receives count hashes, equal to Hash of each key
+   * \param seed the hash seed
+   */
+  static void Hash (IpFlowKey const *keys, uint32_t count, uint32_t *hashes, uint32_t seed = 0);
+
+  /**
+   * \param o the other key
+   * \returns true if both keys identify the same flow
+   */
+  bool operator== (IpFlowKey const &o) const;
+};
+
+} // namespace ns3
+
+#endif /* IP_FLOW_KEY_H */
@@ -0,0 +1,286 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ip-header-batch.h"
+#include "header-log.h"
+#include "ip-checksum.h"
+
+#ifdef __SSE2__
+#define IP_HEADER_BATCH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("IpHeaderBatch");
+
+namespace {
+
+/// Error flag of a bad version, the same for both families.
+const uint8_t BAD_VERSION = 1;
+/// Error flag of a bad IHL.
+const uint8_t BAD_IHL = 2;
+
+/**
+ * \brief Check the version and IHL nibbles of the first byte of each header.
+ * \param first the first byte of each header
+ * \param error receives BAD_VERSION and BAD_IHL flags for each header
+ * \param count number of headers
+ * \param version expected version
+ * \param minIhl smallest acceptable IHL
+ * \param maxIhl largest acceptable IHL
+ */
+void
+ValidateFirstBytes (uint8_t const *first, uint8_t *error, uint32_t count,
+                    uint8_t version, uint8_t minIhl, uint8_t maxIhl)
+{
+  uint32_t k = 0;
+#ifdef IP_HEADER_BATCH_SSE2
+  const __m128i versionMask = _mm_set1_epi8 (static_cast<char> (0xf0));
+  const __m128i ihlMask = _mm_set1_epi8 (0x0f);
+  const __m128i expected = _mm_set1_epi8 (static_cast<char> (version << 4));
+  const __m128i lowest = _mm_set1_epi8 (minIhl);
+  const __m128i highest = _mm_set1_epi8 (maxIhl);
+  const __m128i badVersion = _mm_set1_epi8 (BAD_VERSION);
+  const __m128i badIhl = _mm_set1_epi8 (BAD_IHL);
+  for (; k + 16 <= count; k += 16)
+    {
+      __m128i v = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (first + k));
+      __m128i versionOk = _mm_cmpeq_epi8 (_mm_and_si128 (v, versionMask), expected);
+      __m128i ihl = _mm_and_si128 (v, ihlMask);
+      // unsigned range check: ihl is in range if clamping does not change it
+      __m128i ihlOk = _mm_and_si128 (_mm_cmpeq_epi8 (_mm_max_epu8 (ihl, lowest), ihl),
+                                     _mm_cmpeq_epi8 (_mm_min_epu8 (ihl, highest), ihl));
+      __m128i flags = _mm_or_si128 (_mm_andnot_si128 (versionOk, badVersion),
+                                    _mm_andnot_si128 (ihlOk, badIhl));
+      _mm_storeu_si128 (reinterpret_cast<__m128i *> (error + k), flags);
+    }
+#endif /* IP_HEADER_BATCH_SSE2 */
+  for (; k < count; k++)
+    {
+      uint8_t ihl = first[k] & 0x0f;
+      error[k] = ((first[k] >> 4) != version ? BAD_VERSION : 0)
+        | (ihl < minIhl || ihl > maxIhl ? BAD_IHL : 0);
+    }
+}
+
+} // anonymous namespace
+
+Ipv4HeaderBatch::Ipv4HeaderBatch ()
+  : m_calcChecksum (false)
+{
+}
+
+void
+Ipv4HeaderBatch::EnableChecksum (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  m_calcChecksum = true;
+}
+
+uint32_t
+Ipv4HeaderBatch::Decode (uint8_t const *data, uint32_t count, uint32_t stride)
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<void const *> (data) << count << stride);
+  NS_ASSERT_MSG (stride >= 20, "IPv4 headers are at least 20 bytes apart");
+
+  // resize keeps the capacity, so a batch reused for bursts of similar
+  // sizes allocates once
+  m_source.resize (count);
+  m_destination.resize (count);
+  m_ttl.resize (count);
+  m_protocol.resize (count);
+  m_length.resize (count);
+  m_error.resize (count);
+  m_verIhl.resize (count);
+
+  for (uint32_t k = 0; k < count; k++)
+    {
+      m_verIhl[k] = data[k * stride];
+    }
+  uint8_t maxIhl = stride / 4 < 15 ? stride / 4 : 15;
+  ValidateFirstBytes (m_verIhl.data (), m_error.data (), count, 4, 5, maxIhl);
+
+  uint32_t valid = 0;
+  for (uint32_t k = 0; k < count; k++)
+    {
+      uint8_t const *h = data + k * stride;
+      uint8_t error = m_error[k];
+      if (error == 0)
+        {
+          uint32_t headerSize = (h[0] & 0x0f) * 4;
+          if (static_cast<uint32_t> ((h[2] << 8) | h[3]) < headerSize)
+            {
+              error |= BATCH_BAD_LENGTH;
+            }
+          else if (m_calcChecksum && IpChecksum::Calculate (h, headerSize) != 0)
+            {
+              error |= BATCH_BAD_CHECKSUM;
+            }
+        }
+      m_error[k] = error;
+      if (error != 0)
+        {
+          NS_LOG_LOGIC ("header " << k << " has error flags " << static_cast<uint32_t> (error));
+          m_source[k] = 0;
+          m_destination[k] = 0;
+          m_ttl[k] = 0;
+          m_protocol[k] = 0;
+          m_length[k] = 0;
+          continue;
+        }
+      m_length[k] = (h[2] << 8) | h[3];
+      m_ttl[k] = h[8];
+      m_protocol[k] = h[9];
+      m_source[k] = (static_cast<uint32_t> (h[12]) << 24) | (h[13] << 16) | (h[14] << 8) | h[15];
+      m_destination[k] = (static_cast<uint32_t> (h[16]) << 24) | (h[17] << 16) | (h[18] << 8) | h[19];
+      valid++;
+    }
+  return valid;
+}
+
+uint32_t
+Ipv4HeaderBatch::GetCount (void) const
+{
+  return m_error.size ();
+}
+
+std::vector<uint32_t> const &
+Ipv4HeaderBatch::GetSources (void) const
+{
+  return m_source;
+}
+
+std::vector<uint32_t> const &
+Ipv4HeaderBatch::GetDestinations (void) const
+{
+  return m_destination;
+}
+
+std::vector<uint8_t> const &
+Ipv4HeaderBatch::GetTtls (void) const
+{
+  return m_ttl;
+}
+
+std::vector<uint8_t> const &
+Ipv4HeaderBatch::GetProtocols (void) const
+{
+  return m_protocol;
+}
+
+std::vector<uint16_t> const &
+Ipv4HeaderBatch::GetLengths (void) const
+{
+  return m_length;
+}
+
+std::vector<uint8_t> const &
+Ipv4HeaderBatch::GetErrors (void) const
+{
+  return m_error;
+}
+
+uint32_t
+Ipv6HeaderBatch::Decode (uint8_t const *data, uint32_t count, uint32_t stride)
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<void const *> (data) << count << stride);
+  NS_ASSERT_MSG (stride >= 40, "IPv6 headers are at least 40 bytes apart");
+
+  m_source.resize (count);
+  m_destination.resize (count);
+  m_hopLimit.resize (count);
+  m_nextHeader.resize (count);
+  m_length.resize (count);
+  m_error.resize (count);
+  m_version.resize (count);
+
+  for (uint32_t k = 0; k < count; k++)
+    {
+      m_version[k] = data[k * stride];
+    }
+  // the low nibble belongs to the traffic class, any value goes
+  ValidateFirstBytes (m_version.data (), m_error.data (), count, 6, 0, 15);
+
+  uint32_t valid = 0;
+  for (uint32_t k = 0; k < count; k++)
+    {
+      uint8_t const *h = data + k * stride;
+      if (m_error[k] != 0)
+        {
+          NS_LOG_LOGIC ("header " << k << " is not IPv6");
+          m_source[k] = Ipv6Address ();
+          m_destination[k] = Ipv6Address ();
+          m_hopLimit[k] = 0;
+          m_nextHeader[k] = 0;
+          m_length[k] = 0;
+          continue;
+        }
+      m_length[k] = (h[4] << 8) | h[5];
+      m_nextHeader[k] = h[6];
+      m_hopLimit[k] = h[7];
+      m_source[k] = Ipv6Address::Deserialize (h + 8);
+      m_destination[k] = Ipv6Address::Deserialize (h + 24);
+      valid++;
+    }
+  return valid;
+}
+
+uint32_t
+Ipv6HeaderBatch::GetCount (void) const
+{
+  return m_error.size ();
+}
+
+std::vector<Ipv6Address> const &
+Ipv6HeaderBatch::GetSources (void) const
+{
+  return m_source;
+}
+
+std::vector<Ipv6Address> const &
+Ipv6HeaderBatch::GetDestinations (void) const
+{
+  return m_destination;
+}
+
+std::vector<uint8_t> const &
+Ipv6HeaderBatch::GetHopLimits (void) const
+{
+  return m_hopLimit;
+}
+
+std::vector<uint8_t> const &
+Ipv6HeaderBatch::GetNextHeaders (void) const
+{
+  return m_nextHeader;
+}
+
+std::vector<uint16_t> const &
+Ipv6HeaderBatch::GetLengths (void) const
+{
+  return m_length;
+}
+
+std::vector<uint8_t> const &
+Ipv6HeaderBatch::GetErrors (void) const
+{
+  return m_error;
+}
+
+} // namespace ns3
@@ -0,0 +1,183 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IP_HEADER_BATCH_H
+#define IP_HEADER_BATCH_H
+
+#include "ns3/ipv6-address.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4
+ *
+ * \brief Decode a burst of serialized IPv4 headers into columns.
+ *
+ * Decode takes count headers laid out at a fixed stride (back-to-back
+ * headers, or the fixed-size records of a capture) and fills one column
+ * per field, so that statistics over a trace walk small contiguous arrays
+ * instead of Ipv4CodecHeader objects. The version and IHL of the whole burst
+ * are validated with SSE2 where available, before any field is decoded.
+ *
+ * A header that fails validation has a non-zero GetErrors entry and zero
+ * in every other column.
+ */
+class Ipv4HeaderBatch
+{
+public:
+  /**
+   * \enum Error
+   * \brief Per-header error flags, or-ed together.
+   */
+  enum Error
+    {
+      BATCH_BAD_VERSION = 1,  //!< version is not 4
+      BATCH_BAD_IHL = 2,      //!< IHL below 5, or header longer than the stride
+      BATCH_BAD_LENGTH = 4,   //!< total length shorter than the header
+      BATCH_BAD_CHECKSUM = 8  //!< checksum verification failed
+    };
+
+  /**
+   * \brief Constructor.
+   */
+  Ipv4HeaderBatch ();
+  /**
+   * \brief Verify the header checksums in Decode.
+   */
+  void EnableChecksum (void);
+  /**
+   * \brief Decode a burst of headers, replacing the previous one.
+   * \param data the first byte of the first header
+   * \param count number of headers
+   * \param stride distance in bytes between two headers, at least 20
+   * \returns the number of headers without error
+   */
+  uint32_t Decode (uint8_t const *data, uint32_t count, uint32_t stride);
+
+  /**
+   * \returns the number of headers of the last burst
+   */
+  uint32_t GetCount (void) const;
+  /**
+   * \returns the source addresses, in host order as Ipv4Address::Get
+   */
+  std::vector<uint32_t> const &GetSources (void) const;
+  /**
+   * \returns the destination addresses, in host order as Ipv4Address::Get
+   */
+  std::vector<uint32_t> const &GetDestinations (void) const;
+  /**
+   * \returns the TTL fields
+   */
+  std::vector<uint8_t> const &GetTtls (void) const;
+  /**
+   * \returns the protocol fields
+   */
+  std::vector<uint8_t> const &GetProtocols (void) const;
+  /**
+   * \returns the total length fields, header included
+   */
+  std::vector<uint16_t> const &GetLengths (void) const;
+  /**
+   * \returns the Error flags of each header, 0 for a valid header
+   */
+  std::vector<uint8_t> const &GetErrors (void) const;
+
+private:
+  bool m_calcChecksum; //!< true if the checksums must be verified
+  std::vector<uint32_t> m_source; //!< source addresses
+  std::vector<uint32_t> m_destination; //!< destination addresses
+  std::vector<uint8_t> m_ttl; //!< TTLs
+  std::vector<uint8_t> m_protocol; //!< protocols
+  std::vector<uint16_t> m_length; //!< total lengths
+  std::vector<uint8_t> m_error; //!< error flags
+  std::vector<uint8_t> m_verIhl; //!< first header bytes, gathered for validation
+};
+
+/**
+ * \ingroup ipv6
+ *
+ * \brief Decode a burst of serialized IPv6 headers into columns.
+ *
+ * The IPv6 counterpart of Ipv4HeaderBatch. Only the version can be
+ * invalid in a fixed IPv6 header.
+ */
+class Ipv6HeaderBatch
+{
+public:
+  /**
+   * \enum Error
+   * \brief Per-header error flags.
+   */
+  enum Error
+    {
+      BATCH_BAD_VERSION = 1   //!< version is not 6
+    };
+
+  /**
+   * \brief Decode a burst of headers, replacing the previous one.
+   * \param data the first byte of the first header
+   * \param count number of headers
+   * \param stride distance in bytes between two headers, at least 40
+   * \returns the number of headers without error
+   */
+  uint32_t Decode (uint8_t const *data, uint32_t count, uint32_t stride);
+
+  /**
+   * \returns the number of headers of the last burst
+   */
+  uint32_t GetCount (void) const;
+  /**
+   * \returns the source addresses
+   */
+  std::vector<Ipv6Address> const &GetSources (void) const;
+  /**
+   * \returns the destination addresses
+   */
+  std::vector<Ipv6Address> const &GetDestinations (void) const;
+  /**
+   * \returns the hop limit fields
+   */
+  std::vector<uint8_t> const &GetHopLimits (void) const;
+  /**
+   * \returns the next header fields
+   */
+  std::vector<uint8_t> const &GetNextHeaders (void) const;
+  /**
+   * \returns the payload length fields
+   */
+  std::vector<uint16_t> const &GetLengths (void) const;
+  /**
+   * \returns the Error flags of each header, 0 for a valid header
+   */
+  std::vector<uint8_t> const &GetErrors (void) const;
+
+private:
+  std::vector<Ipv6Address> m_source; //!< source addresses
+  std::vector<Ipv6Address> m_destination; //!< destination addresses
+  std::vector<uint8_t> m_hopLimit; //!< hop limits
+  std::vector<uint8_t> m_nextHeader; //!< next headers
+  std::vector<uint16_t> m_length; //!< payload lengths
+  std::vector<uint8_t> m_error; //!< error flags
+  std::vector<uint8_t> m_version; //!< first header bytes, gathered for validation
+};
+
+} // namespace ns3
+
+#endif /* IP_HEADER_BATCH_H */
@@ -0,0 +1,871 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2005 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
+ */
+
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/header.h"
+#include "ipv4-codec-header.h"
+#include "header-log.h"
+#include "header-format.h"
+#include "ip-checksum.h"
+
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4CodecHeader");
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv4CodecHeader);
+
+namespace {
+
+/// Name of the DSCP codepoints that DscpType does not define.
+const char g_unrecognizedDscp[] = "Unrecognized DSCP";
+
+/// DSCP names, indexed by codepoint.
+const char *const g_dscpNames[64] = {
+  "Default", g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp,
+  g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp,
+  "CS1", g_unrecognizedDscp, "AF11", g_unrecognizedDscp,
+  "AF12", g_unrecognizedDscp, "AF13", g_unrecognizedDscp,
+  "CS2", g_unrecognizedDscp, "AF21", g_unrecognizedDscp,
+  "AF22", g_unrecognizedDscp, "AF23", g_unrecognizedDscp,
+  "CS3", g_unrecognizedDscp, "AF31", g_unrecognizedDscp,
+  "AF32", g_unrecognizedDscp, "AF33", g_unrecognizedDscp,
+  "CS4", g_unrecognizedDscp, "AF41", g_unrecognizedDscp,
+  "AF42", g_unrecognizedDscp, "AF43", g_unrecognizedDscp,
+  "CS5", g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp,
+  g_unrecognizedDscp, g_unrecognizedDscp, "EF", g_unrecognizedDscp,
+  "CS6", g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp,
+  g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp,
+  "CS7", g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp,
+  g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp
+};
+
+/// ECN names, indexed by codepoint.
+const char *const g_ecnNames[4] = { "Not-ECT", "ECT (1)", "ECT (0)", "CE" };
+
+} // anonymous namespace
+
+Ipv4CodecHeader::Ipv4CodecHeader ()
+  : m_calcChecksum (false),
+    m_incrementalChecksum (false),
+    m_payloadSize (0),
+    m_identification (0),
+    m_tos (0),
+    m_ttl (0),
+    m_protocol (0),
+    m_flags (0),
+    m_fragmentOffset (0),
+    m_checksum (0),
+    m_checksumValid (false),
+    m_goodChecksum (true),
+    m_headerSize(5*4),
+    m_optionsSize (0)
+{
+}
+
+void
+Ipv4CodecHeader::EnableChecksum (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  m_calcChecksum = true;
+}
+
+void
+Ipv4CodecHeader::EnableIncrementalChecksum (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  m_calcChecksum = true;
+  m_incrementalChecksum = true;
+}
+
+uint16_t
+Ipv4CodecHeader::GetFlagsFragmentWord (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  uint32_t fragmentOffset = m_fragmentOffset / 8;
+  uint8_t flagsFrag = (fragmentOffset >> 8) & 0x1f;
+  if (m_flags & DONT_FRAGMENT)
+    {
+      flagsFrag |= (1<<6);
+    }
+  if (m_flags & MORE_FRAGMENTS)
+    {
+      flagsFrag |= (1<<5);
+    }
+  return (flagsFrag << 8) | (fragmentOffset & 0xff);
+}
+
+void
+Ipv4CodecHeader::UpdateChecksum (uint16_t oldWord, uint16_t newWord)
+{
+  NS_HEADER_LOG_FUNCTION (this << oldWord << newWord);
+  if (!m_checksumValid)
+    {
+      return;
+    }
+  // m_checksum holds the field as Buffer::Iterator::ReadU16 returns it,
+  // i.e. byte-swapped with respect to the header words.
+  uint16_t hc = (m_checksum >> 8) | (m_checksum << 8);
+  // RFC 1624, eqn. 3: HC' = ~(~HC + ~m + m')
+  uint32_t sum = static_cast<uint16_t> (~hc);
+  sum += static_cast<uint16_t> (~oldWord);
+  sum += newWord;
+  sum = (sum & 0xffff) + (sum >> 16);
+  sum = (sum & 0xffff) + (sum >> 16);
+  hc = ~sum;
+  m_checksum = (hc >> 8) | (hc << 8);
+}
+
+void
+Ipv4CodecHeader::SetPayloadSize (uint16_t size)
+{
+  NS_HEADER_LOG_FUNCTION (this << size);
+  UpdateChecksum (m_payloadSize + m_headerSize, size + m_headerSize);
+  m_payloadSize = size;
+}
+uint16_t
+Ipv4CodecHeader::GetPayloadSize (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return m_payloadSize;
+}
+
+uint16_t
+Ipv4CodecHeader::GetIdentification (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return m_identification;
+}
+void
+Ipv4CodecHeader::SetIdentification (uint16_t identification)
+{
+  NS_HEADER_LOG_FUNCTION (this << identification);
+  UpdateChecksum (m_identification, identification);
+  m_identification = identification;
+}
+
+void 
+Ipv4CodecHeader::SetTos (uint8_t tos)
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<uint32_t> (tos));
+  UpdateChecksum (m_tos, tos);
+  m_tos = tos;
+}
+
+void
+Ipv4CodecHeader::SetDscp (DscpType dscp)
+{
+  NS_HEADER_LOG_FUNCTION (this << dscp);
+  uint8_t oldTos = m_tos;
+  m_tos &= 0x3; // Clear out the DSCP part, retain 2 bits of ECN
+  m_tos |= (dscp << 2);
+  UpdateChecksum (oldTos, m_tos);
+}
+
+void
+Ipv4CodecHeader::SetEcn (EcnType ecn)
+{
+  NS_HEADER_LOG_FUNCTION (this << ecn);
+  uint8_t oldTos = m_tos;
+  m_tos &= 0xFC; // Clear out the ECN part, retain 6 bits of DSCP
+  m_tos |= ecn;
+  UpdateChecksum (oldTos, m_tos);
+}
+
+Ipv4CodecHeader::DscpType 
+Ipv4CodecHeader::GetDscp (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  // Extract only first 6 bits of TOS byte, i.e 0xFC
+  return DscpType ((m_tos & 0xFC) >> 2);
+}
+
+std::string 
+Ipv4CodecHeader::DscpTypeToString (DscpType dscp) const
+{
+  NS_HEADER_LOG_FUNCTION (this << dscp);
+  return GetDscpName (dscp);
+}
+
+char const *
+Ipv4CodecHeader::GetDscpName (DscpType dscp)
+{
+  return static_cast<uint32_t> (dscp) < 64 ? g_dscpNames[dscp] : g_unrecognizedDscp;
+}
+
+
+Ipv4CodecHeader::EcnType 
+Ipv4CodecHeader::GetEcn (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  // Extract only last 2 bits of TOS byte, i.e 0x3
+  return EcnType (m_tos & 0x3);
+}
+
+std::string 
+Ipv4CodecHeader::EcnTypeToString (EcnType ecn) const
+{
+  NS_HEADER_LOG_FUNCTION (this << ecn);
+  return GetEcnName (ecn);
+}
+
+char const *
+Ipv4CodecHeader::GetEcnName (EcnType ecn)
+{
+  return static_cast<uint32_t> (ecn) < 4 ? g_ecnNames[ecn] : "Unknown ECN";
+}
+
+uint8_t 
+Ipv4CodecHeader::GetTos (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return m_tos;
+}
+void 
+Ipv4CodecHeader::SetMoreFragments (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  uint16_t oldWord = GetFlagsFragmentWord ();
+  m_flags |= MORE_FRAGMENTS;
+  UpdateChecksum (oldWord, GetFlagsFragmentWord ());
+}
+void
+Ipv4CodecHeader::SetLastFragment (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  uint16_t oldWord = GetFlagsFragmentWord ();
+  m_flags &= ~MORE_FRAGMENTS;
+  UpdateChecksum (oldWord, GetFlagsFragmentWord ());
+}
+bool 
+Ipv4CodecHeader::IsLastFragment (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return !(m_flags & MORE_FRAGMENTS);
+}
+
+void 
+Ipv4CodecHeader::SetDontFragment (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  uint16_t oldWord = GetFlagsFragmentWord ();
+  m_flags |= DONT_FRAGMENT;
+  UpdateChecksum (oldWord, GetFlagsFragmentWord ());
+}
+void 
+Ipv4CodecHeader::SetMayFragment (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  uint16_t oldWord = GetFlagsFragmentWord ();
+  m_flags &= ~DONT_FRAGMENT;
+  UpdateChecksum (oldWord, GetFlagsFragmentWord ());
+}
+bool 
+Ipv4CodecHeader::IsDontFragment (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return (m_flags & DONT_FRAGMENT);
+}
+
+void 
+Ipv4CodecHeader::SetFragmentOffset (uint16_t offsetBytes)
+{
+  NS_HEADER_LOG_FUNCTION (this << offsetBytes);
+  // check if the user is trying to set an invalid offset
+  NS_ABORT_MSG_IF ((offsetBytes & 0x7), "offsetBytes must be multiple of 8 bytes");
+  uint16_t oldWord = GetFlagsFragmentWord ();
+  m_fragmentOffset = offsetBytes;
+  UpdateChecksum (oldWord, GetFlagsFragmentWord ());
+}
+uint16_t 
+Ipv4CodecHeader::GetFragmentOffset (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  // -fstrict-overflow sensitive, see bug 1868
+  if ( m_fragmentOffset + m_payloadSize > 65535 - 5*4 )
+    {
+      NS_LOG_WARN("Fragment will exceed the maximum packet size once reassembled");
+    }
+
+  return m_fragmentOffset;
+}
+
+void 
+Ipv4CodecHeader::SetTtl (uint8_t ttl)
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<uint32_t> (ttl));
+  UpdateChecksum (m_ttl << 8, ttl << 8);
+  m_ttl = ttl;
+}
+uint8_t 
+Ipv4CodecHeader::GetTtl (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return m_ttl;
+}
+
+uint8_t 
+Ipv4CodecHeader::GetProtocol (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return m_protocol;
+}
+void 
+Ipv4CodecHeader::SetProtocol (uint8_t protocol)
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<uint32_t> (protocol));
+  UpdateChecksum (m_protocol, protocol);
+  m_protocol = protocol;
+}
+
+void 
+Ipv4CodecHeader::SetSource (Ipv4Address source)
+{
+  NS_HEADER_LOG_FUNCTION (this << source);
+  UpdateChecksum (m_source.Get () >> 16, source.Get () >> 16);
+  UpdateChecksum (m_source.Get () & 0xffff, source.Get () & 0xffff);
+  m_source = source;
+}
+Ipv4Address
+Ipv4CodecHeader::GetSource (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return m_source;
+}
+
+void 
+Ipv4CodecHeader::SetDestination (Ipv4Address dst)
+{
+  NS_HEADER_LOG_FUNCTION (this << dst);
+  UpdateChecksum (m_destination.Get () >> 16, dst.Get () >> 16);
+  UpdateChecksum (m_destination.Get () & 0xffff, dst.Get () & 0xffff);
+  m_destination = dst;
+}
+Ipv4Address
+Ipv4CodecHeader::GetDestination (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return m_destination;
+}
+
+
+bool
+Ipv4CodecHeader::IsChecksumOk (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return m_goodChecksum;
+}
+
+void
+Ipv4CodecHeader::AddRecordRouteOption (uint8_t slots)
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<uint32_t> (slots));
+  NS_ABORT_MSG_IF (slots == 0 || slots > 9, "Record Route holds 1 to 9 addresses");
+  uint8_t option[3 + 4 * 9] = { 0 };
+  option[0] = OPTION_RECORD_ROUTE;
+  option[1] = 3 + 4 * slots;
+  option[2] = 4; // pointer to the first free slot, counted from 1
+  AddOption (option, option[1]);
+}
+
+void
+Ipv4CodecHeader::AddTimestampOption (uint8_t slots, TimestampFlag flag)
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<uint32_t> (slots) << flag);
+  uint32_t entry = (flag == TIMESTAMP_ONLY) ? 4 : 8;
+  NS_ABORT_MSG_IF (slots == 0 || 4 + entry * slots > 40, "Timestamp option larger than 40 bytes");
+  uint8_t option[40] = { 0 };
+  option[0] = OPTION_TIMESTAMP;
+  option[1] = 4 + entry * slots;
+  option[2] = 5; // pointer to the first free entry, counted from 1
+  option[3] = flag; // overflow counter (high nibble) starts at 0
+  AddOption (option, option[1]);
+}
+
+void
+Ipv4CodecHeader::SetTimestampAddress (uint8_t slot, Ipv4Address address)
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<uint32_t> (slot) << address);
+  int32_t o = FindOption (OPTION_TIMESTAMP);
+  NS_ABORT_MSG_IF (o < 0 || (m_options[o + 3] & 0x0f) != TIMESTAMP_PRESPECIFIED,
+                   "No prespecified Timestamp option");
+  uint32_t offset = o + 4 + 8 * slot;
+  NS_ABORT_MSG_IF (offset + 8 > static_cast<uint32_t> (o) + m_options[o + 1], "Timestamp entry out of range");
+  SetOptionU32 (offset, address.Get ());
+}
+
+void
+Ipv4CodecHeader::AddRouterAlertOption (uint16_t value)
+{
+  NS_HEADER_LOG_FUNCTION (this << value);
+  uint8_t option[4];
+  option[0] = OPTION_ROUTER_ALERT;
+  option[1] = 4;
+  option[2] = value >> 8;
+  option[3] = value & 0xff;
+  AddOption (option, 4);
+}
+
+void
+Ipv4CodecHeader::RemoveOptions (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  m_optionsSize = 0;
+  m_headerSize = 5*4;
+  m_checksumValid = false;
+}
+
+bool
+Ipv4CodecHeader::RecordRoute (Ipv4Address address)
+{
+  NS_HEADER_LOG_FUNCTION (this << address);
+  int32_t o = FindOption (OPTION_RECORD_ROUTE);
+  if (o < 0)
+    {
+      return false;
+    }
+  uint8_t length = m_options[o + 1];
+  uint8_t pointer = m_options[o + 2];
+  if (pointer < 4 || pointer + 3 > length)
+    {
+      NS_LOG_LOGIC ("Record Route option full");
+      return false;
+    }
+  SetOptionU32 (o + pointer - 1, address.Get ());
+  SetOptionByte (o + 2, pointer + 4);
+  return true;
+}
+
+bool
+Ipv4CodecHeader::RecordTimestamp (Ipv4Address address, uint32_t timestamp)
+{
+  NS_HEADER_LOG_FUNCTION (this << address << timestamp);
+  int32_t o = FindOption (OPTION_TIMESTAMP);
+  if (o < 0)
+    {
+      return false;
+    }
+  uint8_t length = m_options[o + 1];
+  uint8_t pointer = m_options[o + 2];
+  uint8_t overflowFlag = m_options[o + 3];
+  uint8_t flag = overflowFlag & 0x0f;
+  uint32_t entry = (flag == TIMESTAMP_ONLY) ? 4 : 8;
+  if (pointer < 5 || pointer + entry - 1 > length)
+    {
+      NS_LOG_LOGIC ("Timestamp option full");
+      if ((overflowFlag >> 4) < 15)
+        {
+          SetOptionByte (o + 3, overflowFlag + 0x10);
+        }
+      return false;
+    }
+  uint32_t offset = o + pointer - 1;
+  if (flag == TIMESTAMP_PRESPECIFIED)
+    {
+      if (GetOptionU32 (offset) != address.Get ())
+        {
+          // the next entry is reserved for another router
+          return false;
+        }
+      SetOptionU32 (offset + 4, timestamp);
+    }
+  else if (flag == TIMESTAMP_AND_ADDRESS)
+    {
+      SetOptionU32 (offset, address.Get ());
+      SetOptionU32 (offset + 4, timestamp);
+    }
+  else
+    {
+      SetOptionU32 (offset, timestamp);
+    }
+  SetOptionByte (o + 2, pointer + entry);
+  return true;
+}
+
+std::vector<Ipv4Address>
+Ipv4CodecHeader::GetRecordedRoute (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  std::vector<Ipv4Address> route;
+  int32_t o = FindOption (OPTION_RECORD_ROUTE);
+  if (o >= 0)
+    {
+      uint8_t length = m_options[o + 1];
+      uint8_t pointer = m_options[o + 2];
+      for (uint32_t p = 4; p < pointer && p + 3 <= length; p += 4)
+        {
+          route.push_back (Ipv4Address (GetOptionU32 (o + p - 1)));
+        }
+    }
+  return route;
+}
+
+uint8_t
+Ipv4CodecHeader::GetRecordedTimestamps (std::vector<Ipv4Address> &addresses,
+                                        std::vector<uint32_t> &timestamps) const
+{
+  NS_HEADER_LOG_FUNCTION (this << &addresses << &timestamps);
+  addresses.clear ();
+  timestamps.clear ();
+  int32_t o = FindOption (OPTION_TIMESTAMP);
+  if (o < 0)
+    {
+      return 0;
+    }
+  uint8_t length = m_options[o + 1];
+  uint8_t pointer = m_options[o + 2];
+  uint8_t flag = m_options[o + 3] & 0x0f;
+  uint32_t entry = (flag == TIMESTAMP_ONLY) ? 4 : 8;
+  for (uint32_t p = 5; p < pointer && p + entry - 1 <= length; p += entry)
+    {
+      if (flag == TIMESTAMP_ONLY)
+        {
+          timestamps.push_back (GetOptionU32 (o + p - 1));
+        }
+      else
+        {
+          addresses.push_back (Ipv4Address (GetOptionU32 (o + p - 1)));
+          timestamps.push_back (GetOptionU32 (o + p + 3));
+        }
+    }
+  return m_options[o + 3] >> 4;
+}
+
+bool
+Ipv4CodecHeader::HasRouterAlert (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return FindOption (OPTION_ROUTER_ALERT) >= 0;
+}
+
+uint32_t
+Ipv4CodecHeader::GetOptionsSize (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return m_headerSize - 5*4;
+}
+
+int32_t
+Ipv4CodecHeader::FindOption (uint8_t type) const
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<uint32_t> (type));
+  uint32_t o = 0;
+  while (o < m_optionsSize && m_options[o] != OPTION_EOL)
+    {
+      if (m_options[o] == OPTION_NOP)
+        {
+          o++;
+          continue;
+        }
+      if (o + 1 >= m_optionsSize || m_options[o + 1] < 2
+          || o + m_options[o + 1] > m_optionsSize)
+        {
+          NS_LOG_WARN ("Malformed IPv4 option at offset " << o);
+          break;
+        }
+      if (m_options[o] == type)
+        {
+          return o;
+        }
+      o += m_options[o + 1];
+    }
+  return -1;
+}
+
+void
+Ipv4CodecHeader::AddOption (uint8_t const *option, uint8_t size)
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<uint32_t> (size));
+  NS_ABORT_MSG_IF (m_optionsSize + size > 40, "IPv4 options larger than 40 bytes");
+  std::memcpy (m_options + m_optionsSize, option, size);
+  m_optionsSize += size;
+  // round up to the next 32-bit word, as the IHL counts words
+  m_headerSize = 5*4 + ((m_optionsSize + 3) & ~3);
+  m_checksumValid = false;
+}
+
+void
+Ipv4CodecHeader::SetOptionByte (uint32_t offset, uint8_t value)
+{
+  NS_HEADER_LOG_FUNCTION (this << offset << static_cast<uint32_t> (value));
+  // the options start at byte 20, so an even offset is the high byte of a word
+  if (offset & 1)
+    {
+      UpdateChecksum (m_options[offset], value);
+    }
+  else
+    {
+      UpdateChecksum (m_options[offset] << 8, value << 8);
+    }
+  m_options[offset] = value;
+}
+
+void
+Ipv4CodecHeader::SetOptionU32 (uint32_t offset, uint32_t value)
+{
+  NS_HEADER_LOG_FUNCTION (this << offset << value);
+  SetOptionByte (offset, value >> 24);
+  SetOptionByte (offset + 1, (value >> 16) & 0xff);
+  SetOptionByte (offset + 2, (value >> 8) & 0xff);
+  SetOptionByte (offset + 3, value & 0xff);
+}
+
+uint32_t
+Ipv4CodecHeader::GetOptionU32 (uint32_t offset) const
+{
+  NS_HEADER_LOG_FUNCTION (this << offset);
+  return (static_cast<uint32_t> (m_options[offset]) << 24) | (m_options[offset + 1] << 16)
+         | (m_options[offset + 2] << 8) | m_options[offset + 3];
+}
+
+bool
+Ipv4CodecHeader::DeserializeOptions (Buffer::Iterator i, uint32_t size)
+{
+  NS_HEADER_LOG_FUNCTION (this << &i << size);
+  i.Read (m_options, size);
+  m_optionsSize = size;
+
+  // keep the options up to the End of Option List, Serialize pads them back
+  uint32_t end = 0;
+  while (end < size && m_options[end] != OPTION_EOL)
+    {
+      if (m_options[end] == OPTION_NOP)
+        {
+          end++;
+          continue;
+        }
+      if (end + 1 >= size || m_options[end + 1] < 2 || end + m_options[end + 1] > size)
+        {
+          NS_LOG_WARN ("Malformed IPv4 options, keeping them verbatim");
+          return true;
+        }
+      end += m_options[end + 1];
+    }
+  bool zeroPadding = true;
+  for (uint32_t k = end; k < size; k++)
+    {
+      zeroPadding = zeroPadding && (m_options[k] == 0);
+    }
+  m_optionsSize = end;
+  return zeroPadding;
+}
+
+Ipv4CodecHeader::ValidationResult
+Ipv4CodecHeader::Validate (uint8_t const *data, uint32_t size, uint32_t packetSize)
+{
+  NS_HEADER_LOG_FUNCTION (static_cast<void const *> (data) << size << packetSize);
+  NS_ASSERT_MSG (size <= packetSize, "more header bytes than packet bytes");
+  if (size == 0)
+    {
+      return VALIDATE_TRUNCATED;
+    }
+  if ((data[0] >> 4) != 4)
+    {
+      return VALIDATE_BAD_VERSION;
+    }
+  uint32_t headerSize = (data[0] & 0x0f) * 4;
+  if (headerSize < 5*4)
+    {
+      return VALIDATE_BAD_IHL;
+    }
+  if (size < headerSize)
+    {
+      return VALIDATE_TRUNCATED;
+    }
+  uint32_t totalLength = (data[2] << 8) | data[3];
+  if (totalLength < headerSize || totalLength > packetSize)
+    {
+      return VALIDATE_BAD_LENGTH;
+    }
+  if (IpChecksum::Calculate (data, headerSize) != 0)
+    {
+      return VALIDATE_BAD_CHECKSUM;
+    }
+  return VALIDATE_OK;
+}
+
+char const *
+Ipv4CodecHeader::GetValidationName (ValidationResult result)
+{
+  static char const *const names[] = { "OK", "truncated", "bad version", "bad IHL",
+                                       "bad length", "bad checksum" };
+  return static_cast<uint32_t> (result) < sizeof (names) / sizeof (names[0]) ? names[result] : "unknown";
+}
+
+TypeId 
+Ipv4CodecHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4CodecHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<Ipv4CodecHeader> ()
+  ;
+  return tid;
+}
+TypeId 
+Ipv4CodecHeader::GetInstanceTypeId (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return GetTypeId ();
+}
+void 
+Ipv4CodecHeader::Print (std::ostream &os) const
+{
+  NS_HEADER_LOG_FUNCTION (this << &os);
+  // ipv4, right ?
+  // indexed by the DF and MF bits, when some flag is set
+  static char const *const flagNames[4] = { "XX", "DF", "MF", "MF|DF" };
+  HeaderFormatter text;
+  text.Append ("TOS 0x").AppendHex (m_tos).Append (" \n")
+    .Append ("DSCP ").Append (GetDscpName (GetDscp ())).Append (" \n")
+    .Append ("ECN ").Append (GetEcnName (GetEcn ())).Append (" \n")
+    .Append ("TTL ").AppendDecimal (m_ttl).Append (" \n")
+    .Append ("ID ").AppendDecimal (m_identification).Append (" \n")
+    .Append ("PROTOCOL ").AppendDecimal (m_protocol).Append (" \n")
+    .Append ("OFFSET (bytes) ").AppendDecimal (m_fragmentOffset).Append (" \n")
+    .Append ("FLAGS [").Append (m_flags == 0 ? "none" : flagNames[m_flags & 3]).Append ("] \n")
+    .Append ("LENGTH: ").AppendDecimal (m_payloadSize + m_headerSize).Append (" \n")
+    .Append ("source: ").AppendIpv4 (m_source).Append (" > destination: ").AppendIpv4 (m_destination);
+  if (m_optionsSize != 0)
+    {
+      text.Append (" \n")
+        .Append ("OPTIONS (bytes) ").AppendDecimal (GetOptionsSize ());
+    }
+  text.WriteTo (os);
+}
+uint32_t 
+Ipv4CodecHeader::GetSerializedSize (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  //return 5 * 4;
+	return m_headerSize;
+}
+
+void
+Ipv4CodecHeader::Serialize (Buffer::Iterator start) const
+{
+  NS_HEADER_LOG_FUNCTION (this << &start);
+  Buffer::Iterator i = start;
+
+  uint8_t verIhl = (4 << 4) | (m_headerSize / 4);
+  i.WriteU8 (verIhl);
+  i.WriteU8 (m_tos);
+  i.WriteHtonU16 (m_payloadSize + m_headerSize);
+  i.WriteHtonU16 (m_identification);
+  i.WriteHtonU16 (GetFlagsFragmentWord ());
+  i.WriteU8 (m_ttl);
+  i.WriteU8 (m_protocol);
+  // an incrementally maintained checksum is written as is, no rescan needed
+  i.WriteU16 (m_checksumValid ? m_checksum : 0);
+  i.WriteHtonU32 (m_source.Get ());
+  i.WriteHtonU32 (m_destination.Get ());
+  // the 20-byte header is the common case: one predictable branch, no loop.
+  // Branch on the IHL, not on the options: an option area that starts with
+  // End of Option List keeps no option bytes but still has to be written.
+  if (m_headerSize != 5*4)
+    {
+      i.Write (m_options, m_optionsSize);
+      // End of Option List and padding up to the IHL boundary, all zeros
+      i.WriteU8 (0, m_headerSize - 5*4 - m_optionsSize);
+    }
+
+  if (m_calcChecksum && !m_checksumValid)
+    {
+      uint16_t checksum = IpChecksum::Calculate (start, m_headerSize);
+      NS_LOG_LOGIC ("checksum=" <<checksum);
+      i = start;
+      i.Next (10);
+      i.WriteU16 (checksum);
+    }
+}
+uint32_t
+Ipv4CodecHeader::Deserialize (Buffer::Iterator start)
+{
+  NS_HEADER_LOG_FUNCTION (this << &start);
+  Buffer::Iterator i = start;
+
+  uint8_t verIhl = i.ReadU8 ();
+  uint8_t ihl = verIhl & 0x0f; 
+  uint16_t headerSize = ihl * 4;
+
+  if ((verIhl >> 4) != 4)
+    {
+      NS_LOG_WARN ("Trying to decode a non-IPv4 header, refusing to do it.");
+      return 0;
+    }
+  if (ihl < 5)
+    {
+      NS_LOG_WARN ("Trying to decode an IPv4 header shorter than 20 bytes, refusing to do it.");
+      return 0;
+    }
+
+  m_tos = i.ReadU8 ();
+  uint16_t size = i.ReadNtohU16 ();
+  m_payloadSize = size - headerSize;
+  m_identification = i.ReadNtohU16 ();
+  uint8_t flags = i.ReadU8 ();
+  m_flags = 0;
+  if (flags & (1<<6)) 
+    {
+      m_flags |= DONT_FRAGMENT;
+    }
+  if (flags & (1<<5)) 
+    {
+      m_flags |= MORE_FRAGMENTS;
+    }
+  i.Prev ();
+  m_fragmentOffset = i.ReadU8 () & 0x1f;
+  m_fragmentOffset <<= 8;
+  m_fragmentOffset |= i.ReadU8 ();
+  m_fragmentOffset <<= 3;
+  m_ttl = i.ReadU8 ();
+  m_protocol = i.ReadU8 ();
+  m_checksum = i.ReadU16 ();
+  /* i.Next (2); // checksum */
+  m_source.Set (i.ReadNtohU32 ());
+  m_destination.Set (i.ReadNtohU32 ());
+  m_headerSize = headerSize;
+  m_checksumValid = false;
+  // Serialize writes back the very same bytes unless the reserved flag is
+  // set or the options are followed by non-zero padding
+  bool sameBytes = !(flags & (1<<7));
+  m_optionsSize = 0;
+  if (headerSize > 5*4)
+    {
+      sameBytes = DeserializeOptions (i, headerSize - 5*4) && sameBytes;
+    }
+
+  if (m_calcChecksum) 
+    {
+      uint16_t checksum = IpChecksum::Calculate (start, headerSize);
+      NS_LOG_LOGIC ("checksum=" <<checksum);
+
+      m_goodChecksum = (checksum == 0);
+      // the received checksum can be carried over if Serialize writes back
+      // exactly the bytes it covers
+      m_checksumValid = m_incrementalChecksum && m_goodChecksum && sameBytes;
+    }
+  return GetSerializedSize ();
+}
+
+} // namespace ns3
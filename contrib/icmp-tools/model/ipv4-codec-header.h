@@ -0,0 +1,477 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2005 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
+ */
+
+#ifndef IPV4_CODEC_HEADER_H
+#define IPV4_CODEC_HEADER_H
+
+#include <vector>
+#include "ns3/header.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+/**
+ * \ingroup ipv4
+ *
+ * \brief Packet header for IPv4
+ *
+ * The internet module's Ipv4Header with this tree's codec changes. It has
+ * its own name, TypeId and log component so that a program can link it
+ * together with the internet module.
+ */
+class Ipv4CodecHeader : public Header
+{
+public:
+  /**
+   * \brief Construct a null IPv4 header
+   */
+  Ipv4CodecHeader ();
+  /**
+   * \brief Enable checksum calculation for this header.
+   */
+  void EnableChecksum (void);
+  /**
+   * \brief Enable checksum calculation, keeping the checksum field
+   * incrementally updated (\RFC{1624}) across setter calls.
+   *
+   * Once a header carrying a good checksum has been deserialized, every
+   * setter patches the stored checksum instead of invalidating it, and
+   * Serialize writes it back without rescanning the header. This is what
+   * a forwarding hop wants: Deserialize, SetTtl (GetTtl () - 1), Serialize.
+   * Headers built from scratch (or received with a bad checksum) still get
+   * a full checksum calculation on Serialize.
+   */
+  void EnableIncrementalChecksum (void);
+  /**
+   * \param size the size of the payload in bytes
+   */
+  void SetPayloadSize (uint16_t size);
+  /**
+   * \param identification the Identification field of IPv4 packets.
+   *
+   * By default, set to zero.
+   */
+  void SetIdentification (uint16_t identification);
+  /**
+   * \param tos the 8 bits of Ipv4 TOS.
+   */
+  void SetTos (uint8_t tos);
+public:
+  /**
+   * \enum DscpType
+   * \brief DiffServ codepoints
+   *
+   * The values correspond to the 6-bit DSCP codepoint within the 8-bit
+   * DS field defined in \RFC{2474}.  ECN bits are separately set with the
+   * SetEcn() method.  Codepoints are defined in
+   * Assured Forwarding (AF) \RFC{2597}
+   * Expedited Forwarding (EF) \RFC{2598}
+   * Default and Class Selector (CS) \RFC{2474}
+   */
+  enum DscpType
+    {
+      DscpDefault = 0x00,
+
+      // Prefixed with "DSCP" to avoid name clash (bug 1723)
+      DSCP_CS1  = 0x08,  // octal 010
+      DSCP_AF11 = 0x0A,  // octal 012
+      DSCP_AF12 = 0x0C,  // octal 014
+      DSCP_AF13 = 0x0E,  // octal 016
+
+      DSCP_CS2  = 0x10,  // octal 020
+      DSCP_AF21 = 0x12,  // octal 022
+      DSCP_AF22 = 0x14,  // octal 024
+      DSCP_AF23 = 0x16,  // octal 026
+
+      DSCP_CS3  = 0x18,  // octal 030
+      DSCP_AF31 = 0x1A,  // octal 032
+      DSCP_AF32 = 0x1C,  // octal 034
+      DSCP_AF33 = 0x1E,  // octal 036
+
+      DSCP_CS4  = 0x20,  // octal 040
+      DSCP_AF41 = 0x22,  // octal 042
+      DSCP_AF42 = 0x24,  // octal 044
+      DSCP_AF43 = 0x26,  // octal 046
+
+      DSCP_CS5  = 0x28,  // octal 050
+      DSCP_EF   = 0x2E,  // octal 056
+
+      DSCP_CS6  = 0x30,  // octal 060
+      DSCP_CS7  = 0x38   // octal 070
+
+    };
+  /**
+   * \brief Set DSCP Field
+   * \param dscp DSCP value
+   */
+  void SetDscp (DscpType dscp);
+
+  /**
+   * \enum EcnType
+   * \brief ECN Type defined in \RFC{3168}
+   */
+  enum EcnType
+    {
+      // Prefixed with "ECN" to avoid name clash (bug 1723)
+      ECN_NotECT = 0x00,
+      ECN_ECT1 = 0x01,
+      ECN_ECT0 = 0x02,
+      ECN_CE = 0x03
+    };
+  /**
+   * \enum ValidationResult
+   * \brief Outcome of Validate, the first check that failed
+   */
+  enum ValidationResult
+    {
+      VALIDATE_OK,            //!< the header can be accepted
+      VALIDATE_TRUNCATED,     //!< fewer bytes than the IHL announces
+      VALIDATE_BAD_VERSION,   //!< version is not 4
+      VALIDATE_BAD_IHL,       //!< IHL below 5
+      VALIDATE_BAD_LENGTH,    //!< total length shorter than the header or longer than the packet
+      VALIDATE_BAD_CHECKSUM   //!< header checksum is wrong
+    };
+  /**
+   * \brief Set ECN Field
+   * \param ecn ECN Type
+   */
+  void SetEcn (EcnType ecn);
+  /**
+   * This packet is not the last packet of a fragmented ipv4 packet.
+   */
+  void SetMoreFragments (void);
+  /**
+   * This packet is the last packet of a fragmented ipv4 packet.
+   */
+  void SetLastFragment (void);
+  /**
+   * Don't fragment this packet: if you need to anyway, drop it.
+   */
+  void SetDontFragment (void);
+  /**
+   * If you need to fragment this packet, you can do it.
+   */
+  void SetMayFragment (void);
+  /**
+   * The offset is measured in bytes for the packet start.
+   * Mind that IPv4 "fragment offset" field is 13 bits long and is measured in 8-bytes words.
+   * Hence, the function does enforce that the offset is a multiple of 8.
+   * \param offsetBytes the ipv4 fragment offset measured in bytes from the start.
+   */
+  void SetFragmentOffset (uint16_t offsetBytes);
+  /**
+   * \param ttl the ipv4 TTL
+   */
+  void SetTtl (uint8_t ttl);
+  /**
+   * \param num the ipv4 protocol field
+   */
+  void SetProtocol (uint8_t num);
+  /**
+   * \param source the source of this packet
+   */
+  void SetSource (Ipv4Address source);
+  /**
+   * \param destination the destination of this packet.
+   */
+  void SetDestination (Ipv4Address destination);
+  /**
+   * \enum OptionType
+   * \brief Option types understood by the option helpers (\RFC{791}, \RFC{2113}).
+   */
+  enum OptionType
+    {
+      OPTION_EOL = 0,            //!< End of Option List
+      OPTION_NOP = 1,            //!< No Operation
+      OPTION_RECORD_ROUTE = 7,   //!< Record Route
+      OPTION_TIMESTAMP = 68,     //!< Internet Timestamp
+      OPTION_ROUTER_ALERT = 148  //!< Router Alert
+    };
+  /**
+   * \enum TimestampFlag
+   * \brief Contents of the Internet Timestamp option (\RFC{791}).
+   */
+  enum TimestampFlag
+    {
+      TIMESTAMP_ONLY = 0,         //!< timestamps only
+      TIMESTAMP_AND_ADDRESS = 1,  //!< each router records its address and a timestamp
+      TIMESTAMP_PRESPECIFIED = 3  //!< only the prespecified addresses record a timestamp
+    };
+  /**
+   * \brief Append a Record Route option with room for a number of addresses.
+   * \param slots number of addresses the option can hold, at most 9
+   */
+  void AddRecordRouteOption (uint8_t slots);
+  /**
+   * \brief Append an Internet Timestamp option.
+   *
+   * With TIMESTAMP_PRESPECIFIED the addresses are filled in with
+   * SetTimestampAddress before the packet is sent.
+   *
+   * \param slots number of entries the option can hold
+   * \param flag what each entry holds
+   */
+  void AddTimestampOption (uint8_t slots, TimestampFlag flag);
+  /**
+   * \brief Prespecify the router that fills a timestamp entry.
+   * \param slot the entry, starting from 0
+   * \param address the router address
+   */
+  void SetTimestampAddress (uint8_t slot, Ipv4Address address);
+  /**
+   * \brief Append a Router Alert option.
+   * \param value the option value, 0 meaning "examine packet"
+   */
+  void AddRouterAlertOption (uint16_t value = 0);
+  /**
+   * \brief Remove all the options.
+   */
+  void RemoveOptions (void);
+  /**
+   * \brief Record a router address in the Record Route option, if any.
+   * \param address the address of the outgoing interface
+   * \returns true if the address was recorded, false if there is no
+   * Record Route option or it is full
+   */
+  bool RecordRoute (Ipv4Address address);
+  /**
+   * \brief Record a timestamp in the Internet Timestamp option, if any.
+   *
+   * When the option is full, its overflow counter is incremented instead.
+   *
+   * \param address the address of the recording router
+   * \param timestamp milliseconds since midnight UT
+   * \returns true if the timestamp was recorded
+   */
+  bool RecordTimestamp (Ipv4Address address, uint32_t timestamp);
+  /**
+   * \returns the addresses recorded so far in the Record Route option
+   */
+  std::vector<Ipv4Address> GetRecordedRoute (void) const;
+  /**
+   * \param addresses receives the recorded addresses, left empty with TIMESTAMP_ONLY
+   * \param timestamps receives the recorded timestamps
+   * \returns the overflow counter of the Internet Timestamp option
+   */
+  uint8_t GetRecordedTimestamps (std::vector<Ipv4Address> &addresses,
+                                 std::vector<uint32_t> &timestamps) const;
+  /**
+   * \returns true if the header carries a Router Alert option
+   */
+  bool HasRouterAlert (void) const;
+  /**
+   * \returns the size of the options in bytes, padding included
+   */
+  uint32_t GetOptionsSize (void) const;
+  /**
+   * \returns the size of the payload in bytes
+   */
+  uint16_t GetPayloadSize (void) const;
+  /**
+   * \returns the identification field of this packet.
+   */
+  uint16_t GetIdentification (void) const;
+  /**
+   * \returns the TOS field of this packet.
+   */
+  uint8_t GetTos (void) const;
+  /**
+   * \returns the DSCP field of this packet.
+   */
+  DscpType GetDscp (void) const;
+  /**
+   * \param dscp the dscp
+   * \returns std::string of DSCPType
+   */
+  std::string DscpTypeToString (DscpType dscp) const;
+  /**
+   * \returns the ECN field of this packet.
+   */
+  EcnType GetEcn (void) const;
+  /**
+   * \param ecn the ECNType
+   * \returns std::string of ECNType
+   */
+  std::string EcnTypeToString (EcnType ecn) const;
+  /**
+   * \param dscp the dscp
+   * \returns the name of the DSCPType, a static string
+   */
+  static char const *GetDscpName (DscpType dscp);
+  /**
+   * \param ecn the ECNType
+   * \returns the name of the ECNType, a static string
+   */
+  static char const *GetEcnName (EcnType ecn);
+  /**
+   * \returns true if this is the last fragment of a packet, false otherwise.
+   */
+  bool IsLastFragment (void) const;
+  /**
+   * \returns true if this is this packet can be fragmented.
+   */
+  bool IsDontFragment (void) const;
+  /**
+   * \returns the offset of this fragment measured in bytes from the start.
+   */
+  uint16_t GetFragmentOffset (void) const;
+  /**
+   * \returns the TTL field of this packet
+   */
+  uint8_t GetTtl (void) const;
+  /**
+   * \returns the protocol field of this packet
+   */
+  uint8_t GetProtocol (void) const;
+  /**
+   * \returns the source address of this packet
+   */
+  Ipv4Address GetSource (void) const;
+  /**
+   * \returns the destination address of this packet
+   */
+  Ipv4Address GetDestination (void) const;
+
+  /**
+   * \returns true if the ipv4 checksum is correct, false otherwise.
+   *
+   * If Ipv4CodecHeader::EnableChecksums has not been called prior to
+   * deserializing this header, this method will always return true.
+   */
+  bool IsChecksumOk (void) const;
+
+  /**
+   * \brief Check a serialized header without deserializing it.
+   *
+   * Version, IHL, total length and checksum are checked in one pass
+   * over the header bytes, and no field is decoded into an object. This
+   * is meant for ingress filters that drop most of what they see:
+   *
+   * \code
+   *   uint8_t bytes[60];
+   *   uint32_t size = p->CopyData (bytes, sizeof (bytes));
+   *   if (Ipv4CodecHeader::Validate (bytes, size, p->GetSize ()) != Ipv4CodecHeader::VALIDATE_OK)
+   *     {
+   *       return; // drop
+   *     }
+   * \endcode
+   *
+   * \param data the first byte of the header
+   * \param size number of bytes at data, all of the header when the packet holds it
+   * \param packetSize number of bytes from the header to the end of the packet
+   * \returns VALIDATE_OK, or the first check that failed
+   */
+  static ValidationResult Validate (uint8_t const *data, uint32_t size, uint32_t packetSize);
+  /**
+   * \param result a Validate outcome
+   * \returns the name of the outcome, a static string
+   */
+  static char const *GetValidationName (ValidationResult result);
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+private:
+
+  /// flags related to IP fragmentation
+  enum FlagsE {
+    DONT_FRAGMENT = (1<<0),
+    MORE_FRAGMENTS = (1<<1)
+  };
+
+  /**
+   * \returns the flags and fragment offset 16-bit word, as on the wire.
+   */
+  uint16_t GetFlagsFragmentWord (void) const;
+  /**
+   * \brief Patch m_checksum after a 16-bit header word changed (\RFC{1624}).
+   *
+   * Does nothing unless the stored checksum is known to be valid.
+   *
+   * \param oldWord the word before the change, in host order
+   * \param newWord the word after the change, in host order
+   */
+  void UpdateChecksum (uint16_t oldWord, uint16_t newWord);
+  /**
+   * \param type an option type
+   * \returns the offset of the first option of this type in m_options, or -1
+   */
+  int32_t FindOption (uint8_t type) const;
+  /**
+   * \brief Append an option and grow the header accordingly.
+   * \param option the option bytes, type and length included
+   * \param size the option size
+   */
+  void AddOption (uint8_t const *option, uint8_t size);
+  /**
+   * \brief Change one option byte, keeping the checksum up to date.
+   * \param offset the byte offset in m_options
+   * \param value the new byte value
+   */
+  void SetOptionByte (uint32_t offset, uint8_t value);
+  /**
+   * \brief Write an address into the options, keeping the checksum up to date.
+   * \param offset the byte offset in m_options
+   * \param value the 32-bit value, in host order
+   */
+  void SetOptionU32 (uint32_t offset, uint32_t value);
+  /**
+   * \param offset the byte offset in m_options
+   * \returns the network order 32-bit value at offset, in host order
+   */
+  uint32_t GetOptionU32 (uint32_t offset) const;
+  /**
+   * \brief Read the options of a header longer than 20 bytes.
+   * \param i iterator on the first option byte
+   * \param size the size of the option area
+   * \returns true if Serialize would write back the very same bytes
+   */
+  bool DeserializeOptions (Buffer::Iterator i, uint32_t size);
+
+  bool m_calcChecksum; //!< true if the checksum must be calculated
+  bool m_incrementalChecksum; //!< true if m_checksum is kept up to date by the setters
+
+  uint16_t m_payloadSize; //!< payload size
+  uint16_t m_identification; //!< identification
+  uint32_t m_tos : 8; //!< TOS, also used as DSCP + ECN value
+  uint32_t m_ttl : 8; //!< TTL
+  uint32_t m_protocol : 8;  //!< Protocol
+  uint32_t m_flags : 3; //!< flags
+  uint16_t m_fragmentOffset;  //!< Fragment offset
+  Ipv4Address m_source; //!< source address
+  Ipv4Address m_destination; //!< destination address
+  uint16_t m_checksum; //!< checksum, as read from the buffer (Buffer::Iterator::ReadU16)
+  bool m_checksumValid; //!< true if m_checksum matches the current header fields
+  bool m_goodChecksum; //!< true if checksum is correct
+  uint32_t m_headerSize; //!< IP header size
+  uint8_t m_options[40]; //!< options, without the trailing End of Option List padding
+  uint8_t m_optionsSize; //!< number of bytes used in m_options
+};
+
+} // namespace ns3
+
+
+#endif /* IPV4_CODEC_HEADER_H */
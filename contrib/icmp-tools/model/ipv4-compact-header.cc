@@ -0,0 +1,330 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ipv4-compact-header.h"
+#include "header-log.h"
+#include "ipv4-header-view.h"
+#include "ip-checksum.h"
+
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4CompactHeader");
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv4CompactHeader);
+
+Ipv4CompactHeader::Ipv4CompactHeader ()
+  : m_calcChecksum (false),
+    m_goodChecksum (true)
+{
+  std::memset (m_bytes, 0, sizeof (m_bytes));
+  m_bytes[0] = (4 << 4) | 5;
+  m_bytes[3] = 5*4; // total length, no payload
+}
+
+void
+Ipv4CompactHeader::EnableChecksum (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  m_calcChecksum = true;
+}
+
+void
+Ipv4CompactHeader::Write16 (uint32_t offset, uint16_t value)
+{
+  m_bytes[offset] = value >> 8;
+  m_bytes[offset + 1] = value & 0xff;
+}
+
+void
+Ipv4CompactHeader::Write32 (uint32_t offset, uint32_t value)
+{
+  Write16 (offset, value >> 16);
+  Write16 (offset + 2, value & 0xffff);
+}
+
+void
+Ipv4CompactHeader::SetPayloadSize (uint16_t size)
+{
+  NS_HEADER_LOG_FUNCTION (this << size);
+  Write16 (2, size + 5*4);
+}
+uint16_t
+Ipv4CompactHeader::GetPayloadSize (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return Ipv4HeaderView (m_bytes, 20).GetPayloadSize ();
+}
+
+uint16_t
+Ipv4CompactHeader::GetIdentification (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return Ipv4HeaderView (m_bytes, 20).GetIdentification ();
+}
+void
+Ipv4CompactHeader::SetIdentification (uint16_t identification)
+{
+  NS_HEADER_LOG_FUNCTION (this << identification);
+  Write16 (4, identification);
+}
+
+void
+Ipv4CompactHeader::SetTos (uint8_t tos)
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<uint32_t> (tos));
+  m_bytes[1] = tos;
+}
+
+void
+Ipv4CompactHeader::SetDscp (Ipv4CodecHeader::DscpType dscp)
+{
+  NS_HEADER_LOG_FUNCTION (this << dscp);
+  m_bytes[1] = (m_bytes[1] & 0x3) | (dscp << 2);
+}
+
+void
+Ipv4CompactHeader::SetEcn (Ipv4CodecHeader::EcnType ecn)
+{
+  NS_HEADER_LOG_FUNCTION (this << ecn);
+  m_bytes[1] = (m_bytes[1] & 0xFC) | ecn;
+}
+
+Ipv4CodecHeader::DscpType
+Ipv4CompactHeader::GetDscp (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return Ipv4CodecHeader::DscpType ((m_bytes[1] & 0xFC) >> 2);
+}
+
+Ipv4CodecHeader::EcnType
+Ipv4CompactHeader::GetEcn (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return Ipv4CodecHeader::EcnType (m_bytes[1] & 0x3);
+}
+
+uint8_t
+Ipv4CompactHeader::GetTos (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return m_bytes[1];
+}
+void
+Ipv4CompactHeader::SetMoreFragments (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  m_bytes[6] |= (1<<5);
+}
+void
+Ipv4CompactHeader::SetLastFragment (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  m_bytes[6] &= ~(1<<5);
+}
+bool
+Ipv4CompactHeader::IsLastFragment (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return Ipv4HeaderView (m_bytes, 20).IsLastFragment ();
+}
+
+void
+Ipv4CompactHeader::SetDontFragment (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  m_bytes[6] |= (1<<6);
+}
+void
+Ipv4CompactHeader::SetMayFragment (void)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  m_bytes[6] &= ~(1<<6);
+}
+bool
+Ipv4CompactHeader::IsDontFragment (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return Ipv4HeaderView (m_bytes, 20).IsDontFragment ();
+}
+
+void
+Ipv4CompactHeader::SetFragmentOffset (uint16_t offsetBytes)
+{
+  NS_HEADER_LOG_FUNCTION (this << offsetBytes);
+  // check if the user is trying to set an invalid offset
+  NS_ABORT_MSG_IF ((offsetBytes & 0x7), "offsetBytes must be multiple of 8 bytes");
+  uint16_t fragmentOffset = offsetBytes / 8;
+  m_bytes[6] = (m_bytes[6] & 0xe0) | ((fragmentOffset >> 8) & 0x1f);
+  m_bytes[7] = fragmentOffset & 0xff;
+}
+uint16_t
+Ipv4CompactHeader::GetFragmentOffset (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  Ipv4HeaderView view (m_bytes, 20);
+  // -fstrict-overflow sensitive, see bug 1868
+  if ( view.GetFragmentOffset () + view.GetPayloadSize () > 65535 - 5*4 )
+    {
+      NS_LOG_WARN("Fragment will exceed the maximum packet size once reassembled");
+    }
+  return view.GetFragmentOffset ();
+}
+
+void
+Ipv4CompactHeader::SetTtl (uint8_t ttl)
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<uint32_t> (ttl));
+  m_bytes[8] = ttl;
+}
+uint8_t
+Ipv4CompactHeader::GetTtl (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return m_bytes[8];
+}
+
+uint8_t
+Ipv4CompactHeader::GetProtocol (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return m_bytes[9];
+}
+void
+Ipv4CompactHeader::SetProtocol (uint8_t protocol)
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<uint32_t> (protocol));
+  m_bytes[9] = protocol;
+}
+
+void
+Ipv4CompactHeader::SetSource (Ipv4Address source)
+{
+  NS_HEADER_LOG_FUNCTION (this << source);
+  Write32 (12, source.Get ());
+}
+Ipv4Address
+Ipv4CompactHeader::GetSource (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return Ipv4HeaderView (m_bytes, 20).GetSource ();
+}
+
+void
+Ipv4CompactHeader::SetDestination (Ipv4Address dst)
+{
+  NS_HEADER_LOG_FUNCTION (this << dst);
+  Write32 (16, dst.Get ());
+}
+Ipv4Address
+Ipv4CompactHeader::GetDestination (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return Ipv4HeaderView (m_bytes, 20).GetDestination ();
+}
+
+bool
+Ipv4CompactHeader::IsChecksumOk (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return m_goodChecksum;
+}
+
+TypeId
+Ipv4CompactHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4CompactHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<Ipv4CompactHeader> ()
+  ;
+  return tid;
+}
+TypeId
+Ipv4CompactHeader::GetInstanceTypeId (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return GetTypeId ();
+}
+void
+Ipv4CompactHeader::Print (std::ostream &os) const
+{
+  NS_HEADER_LOG_FUNCTION (this << &os);
+  // same output as Ipv4CodecHeader::Print
+  Buffer buffer;
+  buffer.AddAtStart (5*4);
+  Serialize (buffer.Begin ());
+  Ipv4CodecHeader header;
+  header.Deserialize (buffer.Begin ());
+  header.Print (os);
+}
+uint32_t
+Ipv4CompactHeader::GetSerializedSize (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  return 5*4;
+}
+
+void
+Ipv4CompactHeader::Serialize (Buffer::Iterator start) const
+{
+  NS_HEADER_LOG_FUNCTION (this << &start);
+  uint8_t bytes[5*4];
+  std::memcpy (bytes, m_bytes, sizeof (bytes));
+  bytes[10] = 0;
+  bytes[11] = 0;
+  if (m_calcChecksum)
+    {
+      uint16_t checksum = IpChecksum::Calculate (bytes, sizeof (bytes));
+      NS_LOG_LOGIC ("checksum=" <<checksum);
+      // Buffer::Iterator::WriteU16 order
+      bytes[10] = checksum & 0xff;
+      bytes[11] = checksum >> 8;
+    }
+  start.Write (bytes, sizeof (bytes));
+}
+uint32_t
+Ipv4CompactHeader::Deserialize (Buffer::Iterator start)
+{
+  NS_HEADER_LOG_FUNCTION (this << &start);
+  uint8_t verIhl = start.PeekU8 ();
+  if ((verIhl >> 4) != 4)
+    {
+      NS_LOG_WARN ("Trying to decode a non-IPv4 header, refusing to do it.");
+      return 0;
+    }
+  if ((verIhl & 0x0f) != 5)
+    {
+      NS_LOG_WARN ("Ipv4CompactHeader does not hold options, refusing to decode an IHL of "
+                   << (verIhl & 0x0f));
+      return 0;
+    }
+  start.Read (m_bytes, sizeof (m_bytes));
+
+  if (m_calcChecksum)
+    {
+      uint16_t checksum = IpChecksum::Calculate (m_bytes, sizeof (m_bytes));
+      NS_LOG_LOGIC ("checksum=" <<checksum);
+      m_goodChecksum = (checksum == 0);
+    }
+  return GetSerializedSize ();
+}
+
+} // namespace ns3
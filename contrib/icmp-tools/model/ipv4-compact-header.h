@@ -0,0 +1,194 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_COMPACT_HEADER_H
+#define IPV4_COMPACT_HEADER_H
+
+#include "ns3/header.h"
+#include "ns3/ipv4-address.h"
+#include "ipv4-codec-header.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4
+ *
+ * \brief IPv4 header stored in its 20-byte wire layout.
+ *
+ * Same interface as Ipv4CodecHeader, but the fields live in network order in a
+ * 20-byte array. Getters decode from it (through Ipv4HeaderView), setters
+ * encode into it, and Serialize / Deserialize are a single copy plus the
+ * checksum when enabled. On LP64 the object takes 32 bytes against 80 for
+ * an Ipv4CodecHeader, which matters when millions of headers sit in queues or
+ * trace buffers.
+ *
+ * Only option-less headers are represented: Deserialize refuses a header
+ * with an IHL other than 5, use Ipv4CodecHeader for those.
+ */
+class Ipv4CompactHeader : public Header
+{
+public:
+  /**
+   * \brief Construct a null IPv4 header
+   */
+  Ipv4CompactHeader ();
+  /**
+   * \brief Enable checksum calculation for this header.
+   */
+  void EnableChecksum (void);
+  /**
+   * \param size the size of the payload in bytes
+   */
+  void SetPayloadSize (uint16_t size);
+  /**
+   * \param identification the Identification field of IPv4 packets.
+   */
+  void SetIdentification (uint16_t identification);
+  /**
+   * \param tos the 8 bits of Ipv4 TOS.
+   */
+  void SetTos (uint8_t tos);
+  /**
+   * \param dscp DSCP value
+   */
+  void SetDscp (Ipv4CodecHeader::DscpType dscp);
+  /**
+   * \param ecn ECN Type
+   */
+  void SetEcn (Ipv4CodecHeader::EcnType ecn);
+  /**
+   * This packet is not the last packet of a fragmented ipv4 packet.
+   */
+  void SetMoreFragments (void);
+  /**
+   * This packet is the last packet of a fragmented ipv4 packet.
+   */
+  void SetLastFragment (void);
+  /**
+   * Don't fragment this packet: if you need to anyway, drop it.
+   */
+  void SetDontFragment (void);
+  /**
+   * If you need to fragment this packet, you can do it.
+   */
+  void SetMayFragment (void);
+  /**
+   * \param offsetBytes the ipv4 fragment offset measured in bytes from the start,
+   * a multiple of 8.
+   */
+  void SetFragmentOffset (uint16_t offsetBytes);
+  /**
+   * \param ttl the ipv4 TTL
+   */
+  void SetTtl (uint8_t ttl);
+  /**
+   * \param num the ipv4 protocol field
+   */
+  void SetProtocol (uint8_t num);
+  /**
+   * \param source the source of this packet
+   */
+  void SetSource (Ipv4Address source);
+  /**
+   * \param destination the destination of this packet.
+   */
+  void SetDestination (Ipv4Address destination);
+  /**
+   * \returns the size of the payload in bytes
+   */
+  uint16_t GetPayloadSize (void) const;
+  /**
+   * \returns the identification field of this packet.
+   */
+  uint16_t GetIdentification (void) const;
+  /**
+   * \returns the TOS field of this packet.
+   */
+  uint8_t GetTos (void) const;
+  /**
+   * \returns the DSCP field of this packet.
+   */
+  Ipv4CodecHeader::DscpType GetDscp (void) const;
+  /**
+   * \returns the ECN field of this packet.
+   */
+  Ipv4CodecHeader::EcnType GetEcn (void) const;
+  /**
+   * \returns true if this is the last fragment of a packet, false otherwise.
+   */
+  bool IsLastFragment (void) const;
+  /**
+   * \returns true if this is this packet can be fragmented.
+   */
+  bool IsDontFragment (void) const;
+  /**
+   * \returns the offset of this fragment measured in bytes from the start.
+   */
+  uint16_t GetFragmentOffset (void) const;
+  /**
+   * \returns the TTL field of this packet
+   */
+  uint8_t GetTtl (void) const;
+  /**
+   * \returns the protocol field of this packet
+   */
+  uint8_t GetProtocol (void) const;
+  /**
+   * \returns the source address of this packet
+   */
+  Ipv4Address GetSource (void) const;
+  /**
+   * \returns the destination address of this packet
+   */
+  Ipv4Address GetDestination (void) const;
+  /**
+   * \returns true if the ipv4 checksum is correct, false otherwise.
+   *
+   * If EnableChecksum has not been called prior to deserializing this
+   * header, this method will always return true.
+   */
+  bool IsChecksumOk (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+private:
+  /**
+   * \param offset byte offset in the header
+   * \param value the 16-bit value, in host order
+   */
+  void Write16 (uint32_t offset, uint16_t value);
+  /**
+   * \param offset byte offset in the header
+   * \param value the 32-bit value, in host order
+   */
+  void Write32 (uint32_t offset, uint32_t value);
+
+  uint8_t m_bytes[20]; //!< the header, as on the wire; the checksum field is kept as received
+  bool m_calcChecksum; //!< true if the checksum must be calculated
+  bool m_goodChecksum; //!< true if checksum is correct
+};
+
+} // namespace ns3
+
+#endif /* IPV4_COMPACT_HEADER_H */
@@ -0,0 +1,224 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_HEADER_VIEW_H
+#define IPV4_HEADER_VIEW_H
+
+#include <stdint.h>
+#include "ns3/assert.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4
+ *
+ * \brief Read-only view of a serialized IPv4 header.
+ *
+ * Unlike Ipv4CodecHeader::Deserialize, which decodes every field into the
+ * header object, the view keeps a pointer to the wire bytes and decodes a
+ * field only when its getter is called. Classifying a packet by protocol
+ * or TTL costs a single byte load.
+ *
+ * The view does not own the bytes. A packet's bytes are usually obtained
+ * with Packet::CopyData into a stack array of MAX_SIZE bytes:
+ *
+ * \code
+ *   uint8_t bytes[Ipv4HeaderView::MAX_SIZE];
+ *   Ipv4HeaderView ipv4 (bytes, p->CopyData (bytes, sizeof (bytes)));
+ *   if (ipv4.IsValid () && ipv4.GetProtocol () == 1)
+ *     {
+ *       p->RemoveAtStart (ipv4.GetHeaderSize ());
+ *       ...
+ *     }
+ * \endcode
+ *
+ * Getters other than IsValid and GetVersion must only be called on a valid view.
+ */
+class Ipv4HeaderView
+{
+public:
+  /// Largest IPv4 header, options included.
+  static const uint32_t MAX_SIZE = 60;
+
+  /**
+   * \brief Construct an empty (invalid) view.
+   */
+  Ipv4HeaderView ()
+    : m_data (0),
+      m_size (0)
+  {
+  }
+  /**
+   * \brief Construct a view over serialized bytes.
+   * \param data the first byte of the header
+   * \param size number of bytes available at data
+   */
+  Ipv4HeaderView (uint8_t const *data, uint32_t size)
+    : m_data (data),
+      m_size (size)
+  {
+  }
+
+  /**
+   * \returns true if the bytes hold a complete IPv4 header: version 4,
+   * IHL of at least 5 words, header and total length within bounds.
+   */
+  bool IsValid (void) const
+  {
+    if (m_size < 20 || (m_data[0] >> 4) != 4)
+      {
+        return false;
+      }
+    uint32_t headerSize = (m_data[0] & 0x0f) * 4;
+    return headerSize >= 20 && headerSize <= m_size && GetTotalLength () >= headerSize;
+  }
+  /**
+   * \returns the version field, 0 if the view is empty
+   */
+  uint8_t GetVersion (void) const
+  {
+    return m_size ? m_data[0] >> 4 : 0;
+  }
+  /**
+   * \returns the header size in bytes, options included (IHL * 4)
+   */
+  uint32_t GetHeaderSize (void) const
+  {
+    return (Read8 (0) & 0x0f) * 4;
+  }
+  /**
+   * \returns the TOS field
+   */
+  uint8_t GetTos (void) const
+  {
+    return Read8 (1);
+  }
+  /**
+   * \returns the total length field, header included
+   */
+  uint16_t GetTotalLength (void) const
+  {
+    return Read16 (2);
+  }
+  /**
+   * \returns the size of the payload in bytes
+   */
+  uint16_t GetPayloadSize (void) const
+  {
+    return GetTotalLength () - GetHeaderSize ();
+  }
+  /**
+   * \returns the identification field
+   */
+  uint16_t GetIdentification (void) const
+  {
+    return Read16 (4);
+  }
+  /**
+   * \returns true if the DF flag is set
+   */
+  bool IsDontFragment (void) const
+  {
+    return Read8 (6) & (1 << 6);
+  }
+  /**
+   * \returns true if the MF flag is clear
+   */
+  bool IsLastFragment (void) const
+  {
+    return !(Read8 (6) & (1 << 5));
+  }
+  /**
+   * \returns the fragment offset in bytes
+   */
+  uint16_t GetFragmentOffset (void) const
+  {
+    return (Read16 (6) & 0x1fff) << 3;
+  }
+  /**
+   * \returns the TTL field
+   */
+  uint8_t GetTtl (void) const
+  {
+    return Read8 (8);
+  }
+  /**
+   * \returns the protocol field
+   */
+  uint8_t GetProtocol (void) const
+  {
+    return Read8 (9);
+  }
+  /**
+   * \returns the source address
+   */
+  Ipv4Address GetSource (void) const
+  {
+    return Ipv4Address (Read32 (12));
+  }
+  /**
+   * \returns the destination address
+   */
+  Ipv4Address GetDestination (void) const
+  {
+    return Ipv4Address (Read32 (16));
+  }
+  /**
+   * \returns the first byte of the header
+   */
+  uint8_t const * GetData (void) const
+  {
+    return m_data;
+  }
+
+private:
+  /**
+   * \param offset byte offset in the header
+   * \returns the byte at offset
+   */
+  uint8_t Read8 (uint32_t offset) const
+  {
+    NS_ASSERT_MSG (offset < m_size, "read past the end of the IPv4 header view");
+    return m_data[offset];
+  }
+  /**
+   * \param offset byte offset in the header
+   * \returns the network order 16-bit word at offset, in host order
+   */
+  uint16_t Read16 (uint32_t offset) const
+  {
+    NS_ASSERT_MSG (offset + 2 <= m_size, "read past the end of the IPv4 header view");
+    return (m_data[offset] << 8) | m_data[offset + 1];
+  }
+  /**
+   * \param offset byte offset in the header
+   * \returns the network order 32-bit word at offset, in host order
+   */
+  uint32_t Read32 (uint32_t offset) const
+  {
+    NS_ASSERT_MSG (offset + 4 <= m_size, "read past the end of the IPv4 header view");
+    return (static_cast<uint32_t> (m_data[offset]) << 24) | (m_data[offset + 1] << 16)
+           | (m_data[offset + 2] << 8) | m_data[offset + 3];
+  }
+
+  uint8_t const *m_data; //!< first byte of the header
+  uint32_t m_size; //!< number of bytes available at m_data
+};
+
+} // namespace ns3
+
+#endif /* IPV4_HEADER_VIEW_H */
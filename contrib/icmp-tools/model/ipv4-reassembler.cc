@@ -0,0 +1,264 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ipv4-reassembler.h"
+#include "header-log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4Reassembler");
+
+Ipv4Reassembler::Ipv4Reassembler ()
+  : m_timeout (Seconds (30)),
+    m_maxFlowSize (65515),
+    m_memory (0),
+    m_peakMemory (0),
+    m_complete (0),
+    m_evicted (0),
+    m_dropped (0)
+{
+  NS_HEADER_LOG_FUNCTION (this);
+}
+
+void
+Ipv4Reassembler::SetTimeout (Time timeout)
+{
+  NS_HEADER_LOG_FUNCTION (this << timeout);
+  m_timeout = timeout;
+}
+
+void
+Ipv4Reassembler::SetMaxFlowSize (uint32_t bytes)
+{
+  NS_HEADER_LOG_FUNCTION (this << bytes);
+  m_maxFlowSize = bytes;
+}
+
+uint64_t
+Ipv4Reassembler::GetFootprint (Flow const &flow)
+{
+  return sizeof (FlowKey) + sizeof (Flow) + flow.data.capacity ()
+         + flow.holes.capacity () * sizeof (Hole);
+}
+
+void
+Ipv4Reassembler::Erase (FlowMap::iterator it)
+{
+  m_memory -= GetFootprint (it->second);
+  m_flows.erase (it);
+}
+
+Ipv4Reassembler::Result
+Ipv4Reassembler::Add (Ipv4CodecHeader const &header, uint8_t const *payload, uint32_t size, Time now)
+{
+  NS_HEADER_LOG_FUNCTION (this << &header << size << now);
+  Expire (now);
+
+  uint32_t offset = header.GetFragmentOffset ();
+  bool last = header.IsLastFragment ();
+  if (last && offset == 0)
+    {
+      // not a fragment
+      m_packet.assign (payload, payload + size);
+      m_complete++;
+      return PACKET_COMPLETE;
+    }
+
+  FlowKey key;
+  key.addresses = (static_cast<uint64_t> (header.GetSource ().Get ()) << 32)
+    | header.GetDestination ().Get ();
+  key.idProtocol = (static_cast<uint32_t> (header.GetIdentification ()) << 8) | header.GetProtocol ();
+  uint32_t end = offset + size;
+
+  if (!last && size % 8 != 0)
+    {
+      NS_LOG_LOGIC ("Fragment of " << size << " bytes is not the last but not a multiple of 8");
+      m_dropped++;
+      return FRAGMENT_DROPPED;
+    }
+  if (end > m_maxFlowSize)
+    {
+      NS_LOG_LOGIC ("Fragment ends at " << end << ", over the bound of " << m_maxFlowSize);
+      FlowMap::iterator it = m_flows.find (key);
+      if (it != m_flows.end ())
+        {
+          Erase (it);
+        }
+      m_dropped++;
+      return FRAGMENT_DROPPED;
+    }
+
+  std::pair<FlowMap::iterator, bool> inserted = m_flows.insert (std::make_pair (key, Flow ()));
+  Flow &flow = inserted.first->second;
+  if (inserted.second)
+    {
+      Hole all = { 0, UINT32_MAX };
+      flow.holes.push_back (all);
+      flow.size = 0;
+      flow.deadline = now + m_timeout;
+      m_deadlines.push_back (std::make_pair (flow.deadline, key));
+      m_memory += GetFootprint (flow);
+    }
+  uint64_t footprint = GetFootprint (flow);
+
+  if (last)
+    {
+      if ((flow.size != 0 && flow.size != end) || flow.holes.back ().first > end)
+        {
+          NS_LOG_LOGIC ("Last fragment ending at " << end << " contradicts the data received");
+          m_dropped++;
+          return FRAGMENT_DROPPED;
+        }
+      flow.size = end;
+      while (!flow.holes.empty () && flow.holes.back ().first >= end)
+        {
+          flow.holes.pop_back ();
+        }
+      if (!flow.holes.empty ())
+        {
+          flow.holes.back ().last = std::min (flow.holes.back ().last, end);
+        }
+      // the packet size is known now: size the buffer once
+      flow.data.reserve (end);
+    }
+  else if (flow.size != 0 && end > flow.size)
+    {
+      NS_LOG_LOGIC ("Fragment ends at " << end << ", after the last fragment");
+      m_dropped++;
+      return FRAGMENT_DROPPED;
+    }
+
+  if (flow.data.size () < end)
+    {
+      if (flow.data.capacity () < end)
+        {
+          flow.data.reserve (std::min (std::max<uint32_t> (end, flow.data.capacity () * 2), m_maxFlowSize));
+        }
+      flow.data.resize (end);
+    }
+  std::memcpy (&flow.data[offset], payload, size);
+
+  // remove [offset, end) from the holes; the list is sorted and disjoint
+  std::vector<Hole>::iterator hole = flow.holes.begin ();
+  while (hole != flow.holes.end () && hole->last <= offset)
+    {
+      ++hole;
+    }
+  while (hole != flow.holes.end () && hole->first < end)
+    {
+      if (hole->first < offset && hole->last > end)
+        {
+          Hole tail = { end, hole->last };
+          hole->last = offset;
+          flow.holes.insert (hole + 1, tail);
+          break;
+        }
+      if (hole->first < offset)
+        {
+          hole->last = offset;
+          ++hole;
+        }
+      else if (hole->last > end)
+        {
+          hole->first = end;
+          break;
+        }
+      else
+        {
+          hole = flow.holes.erase (hole);
+        }
+    }
+
+  if (flow.holes.empty ())
+    {
+      m_packet.swap (flow.data);
+      m_memory -= footprint;
+      m_flows.erase (inserted.first);
+      m_complete++;
+      return PACKET_COMPLETE;
+    }
+  m_memory += GetFootprint (flow) - footprint;
+  m_peakMemory = std::max (m_peakMemory, m_memory);
+  return FRAGMENT_STORED;
+}
+
+std::vector<uint8_t> const &
+Ipv4Reassembler::GetPacket (void) const
+{
+  return m_packet;
+}
+
+uint32_t
+Ipv4Reassembler::Expire (Time now)
+{
+  uint32_t evicted = 0;
+  while (!m_deadlines.empty () && m_deadlines.front ().first <= now)
+    {
+      FlowMap::iterator it = m_flows.find (m_deadlines.front ().second);
+      // the flow may have completed, and a later one reused its key
+      if (it != m_flows.end () && it->second.deadline == m_deadlines.front ().first)
+        {
+          NS_LOG_LOGIC ("Evicting a flow with " << it->second.holes.size () << " holes");
+          Erase (it);
+          evicted++;
+        }
+      m_deadlines.pop_front ();
+    }
+  m_evicted += evicted;
+  return evicted;
+}
+
+uint32_t
+Ipv4Reassembler::GetFlowCount (void) const
+{
+  return m_flows.size ();
+}
+
+uint64_t
+Ipv4Reassembler::GetMemory (void) const
+{
+  return m_memory;
+}
+
+uint64_t
+Ipv4Reassembler::GetPeakMemory (void) const
+{
+  return m_peakMemory;
+}
+
+uint64_t
+Ipv4Reassembler::GetCompleteCount (void) const
+{
+  return m_complete;
+}
+
+uint64_t
+Ipv4Reassembler::GetEvictedCount (void) const
+{
+  return m_evicted;
+}
+
+uint64_t
+Ipv4Reassembler::GetDroppedCount (void) const
+{
+  return m_dropped;
+}
+
+} // namespace ns3
@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_REASSEMBLER_H
+#define IPV4_REASSEMBLER_H
+
+#include "ns3/nstime.h"
+#include "ipv4-codec-header.h"
+
+#include <deque>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4
+ *
+ * \brief Reassemble IPv4 fragments into packets.
+ *
+ * Fragments are grouped by (source, destination, identification,
+ * protocol). Each group copies the fragment payloads into one contiguous
+ * buffer and tracks the bytes still missing as a sorted list of holes
+ * (\RFC{815}), so overlapping and out-of-order fragments cost a walk over
+ * a few intervals. The buffer grows geometrically until the last fragment
+ * (MF clear) gives the packet size, then it is sized exactly.
+ *
+ * A group whose payload would exceed the per-flow bound is dropped, and a
+ * group still incomplete after the timeout is evicted. Timeouts are a
+ * fixed delay, so the deadlines are kept in arrival order in a FIFO and
+ * eviction never scans the whole table.
+ *
+ * The reassembler works on the header and payload bytes, a Packet user
+ * copies them out with Packet::CopyData.
+ */
+class Ipv4Reassembler
+{
+public:
+  /**
+   * \enum Result
+   * \brief Outcome of Add
+   */
+  enum Result
+    {
+      FRAGMENT_STORED,    //!< the fragment was kept, the packet is still incomplete
+      PACKET_COMPLETE,    //!< the packet is complete, see GetPacket
+      FRAGMENT_DROPPED    //!< the fragment was invalid or its flow went over the bound
+    };
+
+  /**
+   * \brief Constructor.
+   */
+  Ipv4Reassembler ();
+
+  /**
+   * \param timeout how long an incomplete packet is kept after its first fragment
+   */
+  void SetTimeout (Time timeout);
+  /**
+   * \param bytes largest payload reassembled per flow
+   */
+  void SetMaxFlowSize (uint32_t bytes);
+
+  /**
+   * \brief Add a fragment, evicting the flows timed out at now first.
+   * \param header the fragment IPv4 header
+   * \param payload the fragment payload
+   * \param size the payload size, header.GetPayloadSize () for a whole fragment
+   * \param now the current time
+   * \returns the outcome
+   */
+  Result Add (Ipv4CodecHeader const &header, uint8_t const *payload, uint32_t size, Time now);
+  /**
+   * \returns the payload of the last complete packet, until the next call to Add
+   */
+  std::vector<uint8_t> const &GetPacket (void) const;
+  /**
+   * \brief Evict the flows whose timeout expired.
+   * \param now the current time
+   * \returns the number of flows evicted
+   */
+  uint32_t Expire (Time now);
+
+  /**
+   * \returns the number of incomplete packets held
+   */
+  uint32_t GetFlowCount (void) const;
+  /**
+   * \returns the bytes held by incomplete packets
+   */
+  uint64_t GetMemory (void) const;
+  /**
+   * \returns the largest GetMemory value seen
+   */
+  uint64_t GetPeakMemory (void) const;
+  /**
+   * \returns the number of packets reassembled
+   */
+  uint64_t GetCompleteCount (void) const;
+  /**
+   * \returns the number of flows evicted on timeout
+   */
+  uint64_t GetEvictedCount (void) const;
+  /**
+   * \returns the number of fragments dropped
+   */
+  uint64_t GetDroppedCount (void) const;
+
+private:
+  /**
+   * \brief Fragment group key.
+   */
+  struct FlowKey
+  {
+    uint64_t addresses;  //!< source and destination
+    uint32_t idProtocol; //!< identification and protocol
+    /**
+     * \param o the other key
+     * \returns true if the keys are equal
+     */
+    bool operator== (FlowKey const &o) const
+    {
+      return addresses == o.addresses && idProtocol == o.idProtocol;
+    }
+  };
+  /**
+   * \brief FlowKey hash.
+   */
+  struct FlowKeyHash
+  {
+    /**
+     * \param key the key
+     * \returns the hash of the key
+     */
+    size_t operator() (FlowKey const &key) const
+    {
+      uint64_t h = (key.addresses ^ (static_cast<uint64_t> (key.idProtocol) << 17)) * 0x9e3779b97f4a7c15ULL;
+      return h ^ (h >> 29);
+    }
+  };
+  /**
+   * \brief Missing bytes [first, last).
+   */
+  struct Hole
+  {
+    uint32_t first; //!< first missing byte
+    uint32_t last;  //!< one past the last missing byte
+  };
+  /**
+   * \brief An incomplete packet.
+   */
+  struct Flow
+  {
+    std::vector<uint8_t> data; //!< payload received so far
+    std::vector<Hole> holes;   //!< missing bytes, sorted
+    uint32_t size;             //!< payload size, 0 until the last fragment arrives
+    Time deadline;             //!< eviction time
+  };
+  /// Flow table.
+  typedef std::unordered_map<FlowKey, Flow, FlowKeyHash> FlowMap;
+
+  /**
+   * \param flow a flow
+   * \returns the bytes it holds
+   */
+  static uint64_t GetFootprint (Flow const &flow);
+  /**
+   * \brief Forget a flow.
+   * \param it the flow
+   */
+  void Erase (FlowMap::iterator it);
+
+  Time m_timeout; //!< reassembly timeout
+  uint32_t m_maxFlowSize; //!< per-flow payload bound
+  FlowMap m_flows; //!< incomplete packets
+  std::deque<std::pair<Time, FlowKey> > m_deadlines; //!< flow deadlines, in arrival order
+  std::vector<uint8_t> m_packet; //!< last complete payload
+  uint64_t m_memory; //!< bytes held by m_flows
+  uint64_t m_peakMemory; //!< largest m_memory
+  uint64_t m_complete; //!< packets reassembled
+  uint64_t m_evicted; //!< flows evicted
+  uint64_t m_dropped; //!< fragments dropped
+};
+
+} // namespace ns3
+
+#endif /* IPV4_REASSEMBLER_H */
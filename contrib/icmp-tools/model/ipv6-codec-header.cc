@@ -0,0 +1,306 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2007-2008 Louis Pasteur University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Sebastien Vincent <vincent@clarinet.u-strasbg.fr>
+ */
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/header.h"
+
+#include "ns3/address-utils.h"
+#include "ipv6-codec-header.h"
+#include "header-log.h"
+#include "header-format.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv6CodecHeader");
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv6CodecHeader);
+
+namespace {
+
+/// Name of the DSCP codepoints that DscpType does not define.
+const char g_unrecognizedDscp[] = "Unrecognized DSCP";
+
+/// DSCP names, indexed by codepoint.
+const char *const g_dscpNames[64] = {
+  "Default", g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp,
+  g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp,
+  "CS1", g_unrecognizedDscp, "AF11", g_unrecognizedDscp,
+  "AF12", g_unrecognizedDscp, "AF13", g_unrecognizedDscp,
+  "CS2", g_unrecognizedDscp, "AF21", g_unrecognizedDscp,
+  "AF22", g_unrecognizedDscp, "AF23", g_unrecognizedDscp,
+  "CS3", g_unrecognizedDscp, "AF31", g_unrecognizedDscp,
+  "AF32", g_unrecognizedDscp, "AF33", g_unrecognizedDscp,
+  "CS4", g_unrecognizedDscp, "AF41", g_unrecognizedDscp,
+  "AF42", g_unrecognizedDscp, "AF43", g_unrecognizedDscp,
+  "CS5", g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp,
+  g_unrecognizedDscp, g_unrecognizedDscp, "EF", g_unrecognizedDscp,
+  "CS6", g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp,
+  g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp,
+  "CS7", g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp,
+  g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp, g_unrecognizedDscp
+};
+
+/// ECN names, indexed by codepoint.
+const char *const g_ecnNames[4] = { "Not-ECT", "ECT (1)", "ECT (0)", "CE" };
+
+} // anonymous namespace
+
+Ipv6CodecHeader::Ipv6CodecHeader ()
+  : m_trafficClass (0),
+    m_flowLabel (1),
+    m_payloadLength (0),
+    m_nextHeader (0),
+    m_hopLimit (0),
+    m_sourceAddress (),
+    m_destinationAddress ()
+{
+  // Ipv6Address () is the unspecified address "::", no need to parse it
+}
+
+void Ipv6CodecHeader::SetTrafficClass (uint8_t traffic)
+{
+  m_trafficClass = traffic;
+}
+
+uint8_t Ipv6CodecHeader::GetTrafficClass () const
+{
+  return m_trafficClass;
+}
+
+void Ipv6CodecHeader::SetFlowLabel (uint32_t flow)
+{
+  m_flowLabel = flow;
+}
+
+uint32_t Ipv6CodecHeader::GetFlowLabel () const
+{
+  return m_flowLabel;
+}
+
+void Ipv6CodecHeader::SetPayloadLength (uint16_t len)
+{
+  m_payloadLength = len;
+}
+
+uint16_t Ipv6CodecHeader::GetPayloadLength () const
+{
+  return m_payloadLength;
+}
+
+void Ipv6CodecHeader::SetNextHeader (uint8_t next)
+{
+  m_nextHeader = next;
+}
+
+uint8_t Ipv6CodecHeader::GetNextHeader () const
+{
+  return m_nextHeader;
+}
+
+void Ipv6CodecHeader::SetHopLimit (uint8_t limit)
+{
+  m_hopLimit = limit;
+}
+
+uint8_t Ipv6CodecHeader::GetHopLimit () const
+{
+  return m_hopLimit;
+}
+
+void Ipv6CodecHeader::SetSourceAddress (Ipv6Address src)
+{
+  m_sourceAddress = src;
+}
+
+Ipv6Address Ipv6CodecHeader::GetSourceAddress () const
+{
+  return m_sourceAddress;
+}
+
+void Ipv6CodecHeader::SetDestinationAddress (Ipv6Address dst)
+{
+  m_destinationAddress = dst;
+}
+
+Ipv6Address Ipv6CodecHeader::GetDestinationAddress () const
+{
+  return m_destinationAddress;
+}
+
+Ipv6CodecHeader::ValidationResult Ipv6CodecHeader::Validate (uint8_t const *data, uint32_t size, uint32_t packetSize)
+{
+  NS_HEADER_LOG_FUNCTION (static_cast<void const *> (data) << size << packetSize);
+  NS_ASSERT_MSG (size <= packetSize, "more header bytes than packet bytes");
+  if (size == 0)
+    {
+      return VALIDATE_TRUNCATED;
+    }
+  if ((data[0] >> 4) != 6)
+    {
+      return VALIDATE_BAD_VERSION;
+    }
+  if (size < 10 * 4)
+    {
+      return VALIDATE_TRUNCATED;
+    }
+  uint32_t payloadLength = (data[4] << 8) | data[5];
+  if (10 * 4 + payloadLength > packetSize)
+    {
+      return VALIDATE_BAD_LENGTH;
+    }
+  return VALIDATE_OK;
+}
+
+char const *Ipv6CodecHeader::GetValidationName (ValidationResult result)
+{
+  static char const *const names[] = { "OK", "truncated", "bad version", "bad length" };
+  return static_cast<uint32_t> (result) < sizeof (names) / sizeof (names[0]) ? names[result] : "unknown";
+}
+
+TypeId Ipv6CodecHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv6CodecHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<Ipv6CodecHeader> ()
+  ;
+  return tid;
+}
+
+TypeId Ipv6CodecHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void Ipv6CodecHeader::Print (std::ostream& os) const
+{
+  HeaderFormatter text;
+  text.Append ("(Version 6 \n")
+    .Append ("Traffic class 0x").AppendHex (m_trafficClass).Append (" \n")
+    .Append ("DSCP ").Append (GetDscpName (GetDscp ())).Append (" \n")
+    .Append ("Flow Label 0x").AppendHex (m_flowLabel).Append (" \n")
+    .Append ("Payload Length ").AppendDecimal (m_payloadLength).Append (" \n")
+    .Append ("Next Header ").AppendDecimal (m_nextHeader).Append (" \n")
+    .Append ("Hop Limit ").AppendDecimal (m_hopLimit).Append (" )\n");
+  text.WriteTo (os);
+  // Ipv6Address has its own compressed notation
+  os << m_sourceAddress << " > " << m_destinationAddress
+     << " \n";
+}
+
+uint32_t Ipv6CodecHeader::GetSerializedSize () const
+{
+  return 10 * 4;
+}
+
+void Ipv6CodecHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  uint32_t vTcFl = 0; /* version, Traffic Class and Flow Label fields */
+
+  vTcFl = (6 << 28) | (m_trafficClass << 20) | (m_flowLabel);
+
+  i.WriteHtonU32 (vTcFl);
+  i.WriteHtonU16 (m_payloadLength);
+  i.WriteU8 (m_nextHeader);
+  i.WriteU8 (m_hopLimit);
+
+  WriteTo (i, m_sourceAddress);
+  WriteTo (i, m_destinationAddress);
+}
+
+uint32_t Ipv6CodecHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint32_t vTcFl = 0;
+
+  vTcFl = i.ReadNtohU32 ();
+  if ((vTcFl >> 28) != 6)
+    {
+      NS_LOG_WARN ("Trying to decode a non-IPv6 header, refusing to do it.");
+      return 0;
+    }
+
+  m_trafficClass = (uint8_t)((vTcFl >> 20) & 0x000000ff);
+  m_flowLabel = vTcFl & 0x000fffff;
+  m_payloadLength = i.ReadNtohU16 ();
+  m_nextHeader = i.ReadU8 ();
+  m_hopLimit = i.ReadU8 ();
+
+  ReadFrom (i, m_sourceAddress);
+  ReadFrom (i, m_destinationAddress);
+
+  return GetSerializedSize ();
+}
+
+void Ipv6CodecHeader::SetDscp (DscpType dscp)
+{
+  NS_HEADER_LOG_FUNCTION (this << dscp);
+  m_trafficClass &= 0x3; // Clear out the DSCP part, retain 2 bits of ECN
+  m_trafficClass |= (dscp << 2);
+}
+
+void Ipv6CodecHeader::SetEcn (EcnType ecn)
+{
+  NS_HEADER_LOG_FUNCTION (this << ecn);
+  m_trafficClass &= 0xFC; // Clear out the ECN part, retain 6 bits of DSCP
+  m_trafficClass |= ecn;
+}
+
+Ipv6CodecHeader::DscpType Ipv6CodecHeader::GetDscp (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  // Extract only first 6 bits of TOS byte, i.e 0xFC
+  return DscpType ((m_trafficClass & 0xFC) >> 2);
+}
+
+std::string Ipv6CodecHeader::DscpTypeToString (DscpType dscp) const
+{
+  NS_HEADER_LOG_FUNCTION (this << dscp);
+  return GetDscpName (dscp);
+}
+
+char const *Ipv6CodecHeader::GetDscpName (DscpType dscp)
+{
+  return static_cast<uint32_t> (dscp) < 64 ? g_dscpNames[dscp] : g_unrecognizedDscp;
+}
+
+Ipv6CodecHeader::EcnType
+Ipv6CodecHeader::GetEcn (void) const
+{
+  NS_HEADER_LOG_FUNCTION (this);
+  // Extract only last 2 bits of Traffic Class byte, i.e 0x3
+  return EcnType (m_trafficClass & 0x3);
+}
+
+std::string Ipv6CodecHeader::EcnTypeToString (EcnType ecn) const
+{
+  NS_HEADER_LOG_FUNCTION (this << ecn);
+  return GetEcnName (ecn);
+}
+
+char const *Ipv6CodecHeader::GetEcnName (EcnType ecn)
+{
+  return static_cast<uint32_t> (ecn) < 4 ? g_ecnNames[ecn] : "Unknown ECN codepoint";
+}
+
+} /* namespace ns3 */
+
@@ -0,0 +1,214 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ipv6-extension-chain.h"
+#include "header-log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv6ExtensionChain");
+
+namespace {
+
+/// Next Header values of the extensions the walker steps over
+enum ExtensionType
+{
+  HOP_BY_HOP = 0,
+  ROUTING = 43,
+  FRAGMENT = 44,
+  AUTHENTICATION = 51,
+  DESTINATION = 60
+};
+
+/**
+ * Bit n is set when Next Header value n is an extension the walker steps
+ * over: Hop-by-Hop (0), Routing (43), Fragment (44), Authentication (51)
+ * and Destination Options (60).
+ */
+const uint32_t g_extensionMask[8] = { 0x00000001, 0x10081800, 0, 0, 0, 0, 0, 0 };
+
+} // anonymous namespace
+
+Ipv6ExtensionChain::Ipv6ExtensionChain ()
+  : m_status (CHAIN_MALFORMED),
+    m_protocol (0),
+    m_offset (0),
+    m_count (0),
+    m_fragment (false),
+    m_moreFragments (false),
+    m_fragmentOffset (0),
+    m_identification (0),
+    m_routing (false),
+    m_segmentsLeft (0)
+{
+}
+
+bool
+Ipv6ExtensionChain::IsExtension (uint8_t nextHeader)
+{
+  return (g_extensionMask[nextHeader >> 5] >> (nextHeader & 0x1f)) & 1;
+}
+
+Ipv6ExtensionChain::Status
+Ipv6ExtensionChain::Walk (uint8_t const *data, uint32_t size)
+{
+  NS_HEADER_LOG_FUNCTION (this << static_cast<void const *> (data) << size);
+  *this = Ipv6ExtensionChain ();
+
+  if (size < 40)
+    {
+      m_status = CHAIN_TRUNCATED;
+      return m_status;
+    }
+  if ((data[0] >> 4) != 6)
+    {
+      NS_LOG_WARN ("Trying to walk a non-IPv6 packet");
+      m_status = CHAIN_MALFORMED;
+      return m_status;
+    }
+
+  uint8_t next = data[6];
+  uint32_t offset = 40;
+  // no extension: the loop body never runs
+  while (IsExtension (next))
+    {
+      if (m_count == MAX_EXTENSIONS)
+        {
+          m_status = CHAIN_TOO_LONG;
+          return m_status;
+        }
+      if (next == HOP_BY_HOP && m_count != 0)
+        {
+          NS_LOG_WARN ("Hop-by-Hop header not right after the IPv6 header");
+          m_status = CHAIN_MALFORMED;
+          return m_status;
+        }
+      // every extension header is at least 8 bytes long
+      if (offset + 8 > size)
+        {
+          m_status = CHAIN_TRUNCATED;
+          return m_status;
+        }
+
+      uint8_t const *ext = data + offset;
+      uint32_t length;
+      switch (next)
+        {
+        case FRAGMENT:
+          length = 8;
+          m_fragment = true;
+          m_fragmentOffset = ((ext[2] << 8) | ext[3]) & 0xfff8;
+          m_moreFragments = ext[3] & 0x01;
+          m_identification = (static_cast<uint32_t> (ext[4]) << 24) | (ext[5] << 16)
+            | (ext[6] << 8) | ext[7];
+          break;
+        case AUTHENTICATION:
+          // AH counts 32-bit words, minus 2 (RFC 4302)
+          length = (ext[1] + 2) * 4;
+          break;
+        case ROUTING:
+          m_routing = true;
+          m_segmentsLeft = ext[3];
+          length = (ext[1] + 1) * 8;
+          break;
+        default:
+          length = (ext[1] + 1) * 8;
+          break;
+        }
+      next = ext[0];
+      offset += length;
+      m_count++;
+
+      if (m_fragment && m_fragmentOffset != 0)
+        {
+          // only the first fragment carries the rest of the chain
+          break;
+        }
+    }
+
+  if (offset > size)
+    {
+      m_status = CHAIN_TRUNCATED;
+      return m_status;
+    }
+  m_protocol = next;
+  m_offset = offset;
+  m_status = CHAIN_OK;
+  return m_status;
+}
+
+Ipv6ExtensionChain::Status
+Ipv6ExtensionChain::GetStatus (void) const
+{
+  return m_status;
+}
+
+uint8_t
+Ipv6ExtensionChain::GetProtocol (void) const
+{
+  return m_protocol;
+}
+
+uint32_t
+Ipv6ExtensionChain::GetUpperLayerOffset (void) const
+{
+  return m_offset;
+}
+
+uint32_t
+Ipv6ExtensionChain::GetExtensionCount (void) const
+{
+  return m_count;
+}
+
+bool
+Ipv6ExtensionChain::IsFragment (void) const
+{
+  return m_fragment;
+}
+
+uint16_t
+Ipv6ExtensionChain::GetFragmentOffset (void) const
+{
+  return m_fragmentOffset;
+}
+
+bool
+Ipv6ExtensionChain::IsLastFragment (void) const
+{
+  return !m_moreFragments;
+}
+
+uint32_t
+Ipv6ExtensionChain::GetIdentification (void) const
+{
+  return m_identification;
+}
+
+bool
+Ipv6ExtensionChain::HasRouting (void) const
+{
+  return m_routing;
+}
+
+uint8_t
+Ipv6ExtensionChain::GetSegmentsLeft (void) const
+{
+  return m_segmentsLeft;
+}
+
+} // namespace ns3
@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV6_EXTENSION_CHAIN_H
+#define IPV6_EXTENSION_CHAIN_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv6
+ *
+ * \brief Single-pass walker over the IPv6 extension header chain.
+ *
+ * Starting from the fixed header, Walk follows the Next Header fields
+ * through Hop-by-Hop, Routing, Fragment, Destination Options and
+ * Authentication headers, and stops at the first upper-layer protocol.
+ * It reads the two length bytes of each extension and never builds an
+ * extension header object. When the fixed header is directly followed by
+ * an upper-layer protocol, Walk costs a table lookup.
+ *
+ * A packet's bytes are usually obtained with Packet::CopyData into a stack
+ * array of WINDOW bytes, which holds typical chains:
+ *
+ * \code
+ *   uint8_t bytes[Ipv6ExtensionChain::WINDOW];
+ *   Ipv6ExtensionChain chain;
+ *   if (chain.Walk (bytes, p->CopyData (bytes, sizeof (bytes))) == Ipv6ExtensionChain::CHAIN_OK
+ *       && chain.GetProtocol () == Ipv6Header::IPV6_ICMPV6)
+ *     {
+ *       p->RemoveAtStart (chain.GetUpperLayerOffset ());
+ *       ...
+ *     }
+ * \endcode
+ */
+class Ipv6ExtensionChain
+{
+public:
+  /// Suggested number of leading packet bytes to hand to Walk.
+  static const uint32_t WINDOW = 256;
+  /// Longest chain walked before giving up.
+  static const uint32_t MAX_EXTENSIONS = 16;
+
+  /**
+   * \enum Status
+   * \brief Outcome of a walk.
+   */
+  enum Status
+    {
+      CHAIN_OK,         //!< the upper-layer protocol was found
+      CHAIN_TRUNCATED,  //!< the chain runs past the bytes given to Walk
+      CHAIN_MALFORMED,  //!< not IPv6, or a Hop-by-Hop header out of place
+      CHAIN_TOO_LONG    //!< more than MAX_EXTENSIONS extension headers
+    };
+
+  /**
+   * \brief Constructor.
+   */
+  Ipv6ExtensionChain ();
+
+  /**
+   * \brief Walk the chain of a serialized IPv6 packet.
+   * \param data the first byte of the fixed IPv6 header
+   * \param size number of bytes available at data
+   * \returns the outcome of the walk
+   */
+  Status Walk (uint8_t const *data, uint32_t size);
+
+  /**
+   * \param nextHeader a Next Header value
+   * \returns true if the value is an extension header this walker steps over
+   */
+  static bool IsExtension (uint8_t nextHeader);
+
+  /**
+   * \returns the outcome of the last walk
+   */
+  Status GetStatus (void) const;
+  /**
+   * \brief Get the upper-layer protocol.
+   *
+   * This is also the protocol carried by a non-first fragment, whose
+   * upper-layer header lives in the first fragment.
+   *
+   * \returns the Next Header value that ended the chain
+   */
+  uint8_t GetProtocol (void) const;
+  /**
+   * \returns the offset of the upper-layer header from the start of the IPv6 header
+   */
+  uint32_t GetUpperLayerOffset (void) const;
+  /**
+   * \returns the number of extension headers walked
+   */
+  uint32_t GetExtensionCount (void) const;
+  /**
+   * \returns true if the chain has a Fragment header
+   */
+  bool IsFragment (void) const;
+  /**
+   * \returns the fragment offset in bytes, 0 without Fragment header
+   */
+  uint16_t GetFragmentOffset (void) const;
+  /**
+   * \returns true unless a Fragment header has the M flag set
+   */
+  bool IsLastFragment (void) const;
+  /**
+   * \returns the Fragment header identification, 0 without Fragment header
+   */
+  uint32_t GetIdentification (void) const;
+  /**
+   * \returns true if the chain has a Routing header
+   */
+  bool HasRouting (void) const;
+  /**
+   * \returns the Segments Left field of the Routing header, 0 without Routing header
+   */
+  uint8_t GetSegmentsLeft (void) const;
+
+private:
+  Status m_status; //!< outcome of the last walk
+  uint8_t m_protocol; //!< upper-layer protocol
+  uint32_t m_offset; //!< offset of the upper-layer header
+  uint32_t m_count; //!< number of extension headers
+  bool m_fragment; //!< true if there is a Fragment header
+  bool m_moreFragments; //!< M flag of the Fragment header
+  uint16_t m_fragmentOffset; //!< fragment offset in bytes
+  uint32_t m_identification; //!< Fragment header identification
+  bool m_routing; //!< true if there is a Routing header
+  uint8_t m_segmentsLeft; //!< Segments Left of the Routing header
+};
+
+} // namespace ns3
+
+#endif /* IPV6_EXTENSION_CHAIN_H */
@@ -0,0 +1,175 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV6_HEADER_VIEW_H
+#define IPV6_HEADER_VIEW_H
+
+#include <stdint.h>
+#include "ns3/assert.h"
+#include "ns3/ipv6-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv6
+ *
+ * \brief Read-only view of a serialized IPv6 header.
+ *
+ * Unlike Ipv6CodecHeader::Deserialize, which copies both 16-byte addresses into
+ * the header object, the view keeps a pointer to the wire bytes and decodes
+ * a field only when its getter is called. Checking the next header costs a
+ * single byte load.
+ *
+ * The view does not own the bytes. A packet's bytes are usually obtained
+ * with Packet::CopyData into a stack array of SIZE bytes:
+ *
+ * \code
+ *   uint8_t bytes[Ipv6HeaderView::SIZE];
+ *   Ipv6HeaderView ipv6 (bytes, p->CopyData (bytes, sizeof (bytes)));
+ *   if (ipv6.IsValid () && ipv6.GetNextHeader () == Ipv6Header::IPV6_ICMPV6)
+ *     {
+ *       p->RemoveAtStart (Ipv6HeaderView::SIZE);
+ *       ...
+ *     }
+ * \endcode
+ *
+ * Getters other than IsValid and GetVersion must only be called on a valid view.
+ */
+class Ipv6HeaderView
+{
+public:
+  /// Size of the fixed IPv6 header.
+  static const uint32_t SIZE = 40;
+
+  /**
+   * \brief Construct an empty (invalid) view.
+   */
+  Ipv6HeaderView ()
+    : m_data (0),
+      m_size (0)
+  {
+  }
+  /**
+   * \brief Construct a view over serialized bytes.
+   * \param data the first byte of the header
+   * \param size number of bytes available at data
+   */
+  Ipv6HeaderView (uint8_t const *data, uint32_t size)
+    : m_data (data),
+      m_size (size)
+  {
+  }
+
+  /**
+   * \returns true if the bytes hold a complete IPv6 header with version 6
+   */
+  bool IsValid (void) const
+  {
+    return m_size >= SIZE && (m_data[0] >> 4) == 6;
+  }
+  /**
+   * \returns the version field, 0 if the view is empty
+   */
+  uint8_t GetVersion (void) const
+  {
+    return m_size ? m_data[0] >> 4 : 0;
+  }
+  /**
+   * \returns the traffic class field
+   */
+  uint8_t GetTrafficClass (void) const
+  {
+    return (Read16 (0) >> 4) & 0xff;
+  }
+  /**
+   * \returns the 20-bit flow label
+   */
+  uint32_t GetFlowLabel (void) const
+  {
+    return ((Read8 (1) & 0x0f) << 16) | Read16 (2);
+  }
+  /**
+   * \returns the payload length field
+   */
+  uint16_t GetPayloadLength (void) const
+  {
+    return Read16 (4);
+  }
+  /**
+   * \returns the next header field
+   */
+  uint8_t GetNextHeader (void) const
+  {
+    return Read8 (6);
+  }
+  /**
+   * \returns the hop limit field
+   */
+  uint8_t GetHopLimit (void) const
+  {
+    return Read8 (7);
+  }
+  /**
+   * \returns the source address
+   */
+  Ipv6Address GetSourceAddress (void) const
+  {
+    NS_ASSERT_MSG (m_size >= 24, "read past the end of the IPv6 header view");
+    return Ipv6Address::Deserialize (m_data + 8);
+  }
+  /**
+   * \returns the destination address
+   */
+  Ipv6Address GetDestinationAddress (void) const
+  {
+    NS_ASSERT_MSG (m_size >= SIZE, "read past the end of the IPv6 header view");
+    return Ipv6Address::Deserialize (m_data + 24);
+  }
+  /**
+   * \returns the first byte of the header
+   */
+  uint8_t const * GetData (void) const
+  {
+    return m_data;
+  }
+
+private:
+  /**
+   * \param offset byte offset in the header
+   * \returns the byte at offset
+   */
+  uint8_t Read8 (uint32_t offset) const
+  {
+    NS_ASSERT_MSG (offset < m_size, "read past the end of the IPv6 header view");
+    return m_data[offset];
+  }
+  /**
+   * \param offset byte offset in the header
+   * \returns the network order 16-bit word at offset, in host order
+   */
+  uint16_t Read16 (uint32_t offset) const
+  {
+    NS_ASSERT_MSG (offset + 2 <= m_size, "read past the end of the IPv6 header view");
+    return (m_data[offset] << 8) | m_data[offset + 1];
+  }
+
+  uint8_t const *m_data; //!< first byte of the header
+  uint32_t m_size; //!< number of bytes available at m_data
+};
+
+} // namespace ns3
+
+#endif /* IPV6_HEADER_VIEW_H */
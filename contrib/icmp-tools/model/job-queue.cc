@@ -0,0 +1,135 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+#include "job-queue.h"
+
+#include <new>
+#include <sys/mman.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("JobQueue");
+
+namespace {
+
+/**
+ * \param begin first job of a block
+ * \param end past the last job of the block
+ * \returns the block as one word
+ */
+uint64_t
+MakeBlock (uint64_t begin, uint64_t end)
+{
+  return (begin << 32) | end;
+}
+
+} // anonymous namespace
+
+JobQueue::JobQueue (uint32_t jobs, uint32_t workers)
+  : m_workers (workers),
+    m_steals (0),
+    m_blocks (0)
+{
+  NS_LOG_FUNCTION (this << jobs << workers);
+  NS_ABORT_MSG_UNLESS (workers > 0, "A job queue needs a worker");
+  void *data = mmap (0, (1 + workers) * sizeof (std::atomic<uint64_t>), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  NS_ABORT_MSG_IF (data == MAP_FAILED, "Cannot map a job queue of " << workers << " workers");
+  m_steals = new (data) std::atomic<uint64_t> (0);
+  NS_ABORT_MSG_UNLESS (m_steals->is_lock_free (), "64-bit atomics are not lock-free, they can't be shared by processes");
+  m_blocks = m_steals + 1;
+  for (uint32_t w = 0; w < workers; w++)
+    {
+      uint64_t begin = static_cast<uint64_t> (jobs) * w / workers;
+      uint64_t end = static_cast<uint64_t> (jobs) * (w + 1) / workers;
+      new (&m_blocks[w]) std::atomic<uint64_t> (MakeBlock (begin, end));
+    }
+}
+
+JobQueue::~JobQueue ()
+{
+  NS_LOG_FUNCTION (this);
+  munmap (m_steals, (1 + m_workers) * sizeof (std::atomic<uint64_t>));
+}
+
+bool
+JobQueue::Take (uint32_t worker, uint32_t &job)
+{
+  NS_ASSERT (worker < m_workers);
+  std::atomic<uint64_t> &block = m_blocks[worker];
+  uint64_t value = block.load ();
+  while ((value >> 32) < (value & 0xffffffff))
+    {
+      // thieves shrink the end, so the front is claimed with a CAS too
+      if (block.compare_exchange_weak (value, value + (uint64_t (1) << 32)))
+        {
+          job = value >> 32;
+          return true;
+        }
+    }
+  return Steal (worker, job);
+}
+
+bool
+JobQueue::Steal (uint32_t worker, uint32_t &job)
+{
+  while (true)
+    {
+      uint32_t victim = m_workers;
+      uint64_t value = 0;
+      uint64_t most = 0;
+      for (uint32_t w = 0; w < m_workers; w++)
+        {
+          uint64_t v = m_blocks[w].load ();
+          uint64_t left = (v & 0xffffffff) - (v >> 32);
+          if (left > most)
+            {
+              victim = w;
+              value = v;
+              most = left;
+            }
+        }
+      if (victim == m_workers)
+        {
+          return false;
+        }
+      uint64_t begin = value >> 32;
+      uint64_t end = value & 0xffffffff;
+      uint64_t middle = end - (most + 1) / 2;
+      // a job once taken never becomes free again, so no ABA on the block
+      if (!m_blocks[victim].compare_exchange_strong (value, MakeBlock (begin, middle)))
+        {
+          continue;
+        }
+      (*m_steals)++;
+      NS_LOG_LOGIC ("worker " << worker << " stole jobs " << middle << " to " << end << " of worker " << victim);
+      // nobody changes an empty block, this worker owns it again
+      m_blocks[worker].store (MakeBlock (middle + 1, end));
+      job = middle;
+      return true;
+    }
+}
+
+uint64_t
+JobQueue::GetSteals (void) const
+{
+  return m_steals->load ();
+}
+
+} // namespace ns3
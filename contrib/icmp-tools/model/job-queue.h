@@ -0,0 +1,88 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef JOB_QUEUE_H
+#define JOB_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+namespace ns3 {
+
+/**
+ * \brief Work-stealing queue of job indices, shared by forked worker processes.
+ *
+ * The jobs 0 to N - 1 are dealt to the workers in contiguous blocks, one
+ * per worker, so neighbouring jobs (the runs of one case) stay with one
+ * worker. A worker takes its jobs from the front of its block; once its
+ * block is empty it steals the back half of the fullest block left, and
+ * goes on from there. Workers that finish early keep the others' tails
+ * busy, without any process handing the jobs out.
+ *
+ * Each block is a single 64-bit word, begin and end, in a shared
+ * anonymous mapping: taking and stealing are compare-and-swaps on it, so
+ * the queue works across fork. Create the queue before forking the
+ * workers; every job is taken exactly once.
+ */
+class JobQueue
+{
+public:
+  /**
+   * \brief Deal the jobs to the workers.
+   * \param jobs number of jobs
+   * \param workers number of workers, at least 1
+   */
+  JobQueue (uint32_t jobs, uint32_t workers);
+  /**
+   * \brief Destructor, unmaps the queue in this process.
+   */
+  ~JobQueue ();
+
+  /**
+   * \brief Take the next job of a worker, stealing one if its block is empty.
+   * \param worker the worker, below the number of workers
+   * \param job the job taken
+   * \returns false once every job has been taken
+   */
+  bool Take (uint32_t worker, uint32_t &job);
+
+  /**
+   * \returns the number of steals so far, by all workers
+   */
+  uint64_t GetSteals (void) const;
+
+private:
+  /// Disallow copying, the mapping is owned.
+  JobQueue (JobQueue const &);
+  /// Disallow assignment, the mapping is owned.
+  JobQueue & operator = (JobQueue const &);
+
+  /**
+   * \brief Move the back half of the fullest block to an empty one.
+   * \param worker the worker whose block is empty
+   * \param job the first stolen job, taken by the worker
+   * \returns false if every block is empty
+   */
+  bool Steal (uint32_t worker, uint32_t &job);
+
+  uint32_t m_workers;             //!< number of workers
+  std::atomic<uint64_t> *m_steals; //!< steals so far, at the start of the shared mapping
+  std::atomic<uint64_t> *m_blocks; //!< per worker, begin << 32 | end, in the shared mapping
+};
+
+} // namespace ns3
+
+#endif /* JOB_QUEUE_H */
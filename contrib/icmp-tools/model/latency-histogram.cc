@@ -0,0 +1,233 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "latency-histogram.h"
+
+#include <cmath>
+#include <string>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LatencyHistogram");
+
+LatencyHistogram::LatencyHistogram (uint32_t precision)
+  : m_precision (precision),
+    m_counts ((1u << precision) + (64 - precision) * (1u << (precision - 1)), 0),
+    m_count (0),
+    m_min (0),
+    m_max (0),
+    m_sum (0)
+{
+  NS_LOG_FUNCTION (this << precision);
+  NS_ASSERT_MSG (precision >= 2 && precision <= 16, "Precision of " << precision << " bits");
+}
+
+uint32_t
+LatencyHistogram::GetIndex (uint64_t value) const
+{
+  if (value < (1u << m_precision))
+    {
+      return value;
+    }
+  // shift the value down to precision bits; each shift is a half-range of buckets
+  uint32_t shift = 64 - __builtin_clzll (value) - m_precision;
+  return (shift << (m_precision - 1)) + (value >> shift);
+}
+
+uint64_t
+LatencyHistogram::GetHighest (uint32_t index) const
+{
+  if (index < (1u << m_precision))
+    {
+      return index;
+    }
+  uint32_t half = 1u << (m_precision - 1);
+  uint32_t shift = index / half - 1;
+  uint64_t mantissa = index - shift * half;
+  return ((mantissa + 1) << shift) - 1;
+}
+
+void
+LatencyHistogram::Record (Time latency)
+{
+  int64_t steps = latency.GetTimeStep ();
+  RecordValue (steps > 0 ? steps : 0);
+}
+
+void
+LatencyHistogram::RecordValue (uint64_t value, uint64_t count)
+{
+  if (count == 0)
+    {
+      return;
+    }
+  m_counts[GetIndex (value)] += count;
+  if (m_count == 0 || value < m_min)
+    {
+      m_min = value;
+    }
+  if (value > m_max)
+    {
+      m_max = value;
+    }
+  m_count += count;
+  m_sum += value * count;
+}
+
+void
+LatencyHistogram::Merge (LatencyHistogram const &other)
+{
+  NS_ASSERT_MSG (other.m_precision == m_precision,
+                 "Merging a " << other.m_precision << "-bit histogram into a " << m_precision << "-bit one");
+  if (other.m_count == 0)
+    {
+      return;
+    }
+  for (uint32_t k = 0; k < m_counts.size (); k++)
+    {
+      m_counts[k] += other.m_counts[k];
+    }
+  if (m_count == 0 || other.m_min < m_min)
+    {
+      m_min = other.m_min;
+    }
+  if (other.m_max > m_max)
+    {
+      m_max = other.m_max;
+    }
+  m_count += other.m_count;
+  m_sum += other.m_sum;
+}
+
+void
+LatencyHistogram::Clear (void)
+{
+  m_counts.assign (m_counts.size (), 0);
+  m_count = 0;
+  m_min = 0;
+  m_max = 0;
+  m_sum = 0;
+}
+
+uint64_t
+LatencyHistogram::GetCount (void) const
+{
+  return m_count;
+}
+
+Time
+LatencyHistogram::GetMin (void) const
+{
+  return TimeStep (m_min);
+}
+
+Time
+LatencyHistogram::GetMax (void) const
+{
+  return TimeStep (m_max);
+}
+
+Time
+LatencyHistogram::GetMean (void) const
+{
+  return m_count ? TimeStep (m_sum / m_count) : Time (0);
+}
+
+Time
+LatencyHistogram::GetPercentile (double percentile) const
+{
+  if (m_count == 0)
+    {
+      return Time (0);
+    }
+  // the rank of the sample the percentile names, from 1 to the count
+  uint64_t rank = static_cast<uint64_t> (std::ceil (percentile / 100 * m_count));
+  rank = rank < 1 ? 1 : rank > m_count ? m_count : rank;
+  uint64_t seen = 0;
+  for (uint32_t k = 0; k < m_counts.size (); k++)
+    {
+      seen += m_counts[k];
+      if (seen >= rank)
+        {
+          uint64_t highest = GetHighest (k);
+          return TimeStep (highest < m_max ? highest : m_max);
+        }
+    }
+  return TimeStep (m_max);
+}
+
+void
+LatencyHistogram::Serialize (std::ostream &os) const
+{
+  uint32_t used = 0;
+  for (uint32_t k = 0; k < m_counts.size (); k++)
+    {
+      used += m_counts[k] != 0;
+    }
+  os << "hdr " << m_precision << " " << m_count << " " << m_min << " " << m_max << " " << m_sum << " " << used;
+  for (uint32_t k = 0; k < m_counts.size (); k++)
+    {
+      if (m_counts[k] != 0)
+        {
+          os << " " << k << ":" << m_counts[k];
+        }
+    }
+}
+
+bool
+LatencyHistogram::Deserialize (std::istream &is)
+{
+  std::string tag;
+  uint32_t precision;
+  uint64_t count;
+  uint64_t min;
+  uint64_t max;
+  uint64_t sum;
+  uint32_t used;
+  if (!(is >> tag >> precision >> count >> min >> max >> sum >> used) || tag != "hdr"
+      || precision < 2 || precision > 16)
+    {
+      return false;
+    }
+  LatencyHistogram histogram (precision);
+  uint64_t total = 0;
+  for (uint32_t k = 0; k < used; k++)
+    {
+      uint32_t index;
+      char colon;
+      uint64_t n;
+      if (!(is >> index >> colon >> n) || colon != ':' || index >= histogram.m_counts.size ())
+        {
+          return false;
+        }
+      histogram.m_counts[index] += n;
+      total += n;
+    }
+  if (total != count)
+    {
+      return false;
+    }
+  histogram.m_count = count;
+  histogram.m_min = min;
+  histogram.m_max = max;
+  histogram.m_sum = sum;
+  *this = histogram;
+  return true;
+}
+
+} // namespace ns3
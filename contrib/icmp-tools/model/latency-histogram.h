@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Log-bucketed latency histogram, in the manner of HdrHistogram.
+ *
+ * Values are time steps (nanoseconds by default). Values below
+ * 2^precision each get their own bucket; above that, every power of two
+ * is split into 2^(precision - 1) buckets of equal width, so a value is
+ * known to within 2^-(precision - 1) of itself whatever its magnitude,
+ * from a nanosecond to the full 64-bit range. Memory is fixed by the
+ * precision: 3776 counters, about 30 KiB, with the default 7 bits.
+ *
+ * Two histograms of the same precision merge by adding their counters,
+ * which loses nothing: runs and worker processes record separately and
+ * merge afterwards. Serialize writes the non-empty buckets on one text
+ * line, Deserialize reads it back, for merging across processes.
+ */
+class LatencyHistogram
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param precision bits of the bucket index below each power of two, 2 to 16
+   */
+  LatencyHistogram (uint32_t precision = 7);
+
+  /**
+   * \brief Record a latency.
+   * \param latency the latency, negative values count as 0
+   */
+  void Record (Time latency);
+  /**
+   * \brief Record a value a number of times.
+   * \param value the value, in time steps
+   * \param count how many times it was seen
+   */
+  void RecordValue (uint64_t value, uint64_t count = 1);
+  /**
+   * \brief Add the samples of another histogram to this one.
+   * \param other a histogram of the same precision
+   */
+  void Merge (LatencyHistogram const &other);
+  /**
+   * \brief Forget every sample.
+   */
+  void Clear (void);
+
+  /**
+   * \returns the number of samples
+   */
+  uint64_t GetCount (void) const;
+  /**
+   * \returns the smallest sample, exact; 0 without samples
+   */
+  Time GetMin (void) const;
+  /**
+   * \returns the largest sample, exact; 0 without samples
+   */
+  Time GetMax (void) const;
+  /**
+   * \returns the mean of the samples, exact; 0 without samples
+   */
+  Time GetMean (void) const;
+  /**
+   * \param percentile the percentile, from 0 to 100
+   * \returns the largest value of the bucket the percentile falls into,
+   * never above GetMax; 0 without samples
+   */
+  Time GetPercentile (double percentile) const;
+
+  /**
+   * \brief Write the histogram on one line, non-empty buckets only.
+   * \param os the output stream
+   */
+  void Serialize (std::ostream &os) const;
+  /**
+   * \brief Replace the histogram with one written by Serialize.
+   * \param is the input stream, positioned at the start of the histogram
+   * \returns false if the text is not a serialized histogram
+   */
+  bool Deserialize (std::istream &is);
+
+private:
+  /**
+   * \param value a value
+   * \returns the bucket of value
+   */
+  uint32_t GetIndex (uint64_t value) const;
+  /**
+   * \param index a bucket
+   * \returns the largest value of the bucket
+   */
+  uint64_t GetHighest (uint32_t index) const;
+
+  uint32_t m_precision;           //!< bits of the index below each power of two
+  std::vector<uint64_t> m_counts; //!< samples per bucket
+  uint64_t m_count;               //!< samples
+  uint64_t m_min;                 //!< smallest sample
+  uint64_t m_max;                 //!< largest sample
+  uint64_t m_sum;                 //!< sum of the samples, wrapping past 2^64
+};
+
+} // namespace ns3
+
+#endif /* LATENCY_HISTOGRAM_H */
@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
+#include "lossy-channel.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LossyChannel");
+
+NS_OBJECT_ENSURE_REGISTERED (LossyChannel);
+
+TypeId
+LossyChannel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LossyChannel")
+    .SetParent<SimpleChannel> ()
+    .SetGroupName ("Network")
+    .AddConstructor<LossyChannel> ()
+    .AddAttribute ("LossRate", "The probability of dropping each packet sent.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&LossyChannel::m_lossRate),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("Jitter", "The largest delay added to the channel Delay; each packet gets a uniform draw up to it.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&LossyChannel::m_jitter),
+                   MakeTimeChecker ())
+    .AddTraceSource ("Drop", "A packet has been lost on the channel.",
+                     MakeTraceSourceAccessor (&LossyChannel::m_dropTrace),
+                     "ns3::Packet::TracedCallback")
+  ;
+  return tid;
+}
+
+LossyChannel::LossyChannel ()
+  : m_lossRate (0),
+    m_jitter (Seconds (0)),
+    m_loss (CreateObject<UniformRandomVariable> ()),
+    m_delay (CreateObject<UniformRandomVariable> ()),
+    m_dropped (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LossyChannel::Send (Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
+                    Ptr<SimpleNetDevice> sender)
+{
+  NS_LOG_FUNCTION (this << p << protocol << to << from << sender);
+  if (m_lossRate > 0 && m_loss->GetValue () < m_lossRate)
+    {
+      NS_LOG_LOGIC ("dropping " << p);
+      m_dropped++;
+      m_dropTrace (p);
+      return;
+    }
+  if (m_jitter.IsStrictlyPositive ())
+    {
+      Time jitter = Seconds (m_delay->GetValue (0, m_jitter.GetSeconds ()));
+      Simulator::Schedule (jitter, &LossyChannel::Deliver, this, p, protocol, to, from, sender);
+      return;
+    }
+  SimpleChannel::Send (p, protocol, to, from, sender);
+}
+
+void
+LossyChannel::Deliver (Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
+                       Ptr<SimpleNetDevice> sender)
+{
+  SimpleChannel::Send (p, protocol, to, from, sender);
+}
+
+int64_t
+LossyChannel::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_loss->SetStream (stream);
+  m_delay->SetStream (stream + 1);
+  return 2;
+}
+
+uint64_t
+LossyChannel::GetDropped (void) const
+{
+  return m_dropped;
+}
+
+} // namespace ns3
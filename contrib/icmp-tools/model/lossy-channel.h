@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LOSSY_CHANNEL_H
+#define LOSSY_CHANNEL_H
+
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/traced-callback.h"
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \brief A SimpleChannel that loses packets and delays them by a random jitter.
+ *
+ * Each packet sent is dropped with probability LossRate; the others get
+ * a delay drawn uniformly between 0 and Jitter on top of the fixed Delay
+ * of the SimpleChannel, so jittered packets may overtake one another.
+ * On a point-to-point link a packet has a single receiver, and the loss
+ * is the loss of the link. Dropped packets go to the Drop trace.
+ *
+ * With no loss and no jitter the channel behaves as a SimpleChannel and
+ * draws no random numbers. Its streams come from the global RNG seed and
+ * run, or from AssignStreams.
+ */
+class LossyChannel : public SimpleChannel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  LossyChannel ();
+
+  /**
+   * \brief Drop the packet, or deliver it after the channel delay and a jitter.
+   * \param p the packet
+   * \param protocol the protocol number
+   * \param to the destination address
+   * \param from the source address
+   * \param sender the sending device
+   */
+  virtual void Send (Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
+                     Ptr<SimpleNetDevice> sender);
+
+  /**
+   * \brief Assign fixed random variable streams.
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * \returns the number of packets dropped
+   */
+  uint64_t GetDropped (void) const;
+
+private:
+  /**
+   * \brief Hand a packet to the SimpleChannel, once jittered.
+   * \param p the packet
+   * \param protocol the protocol number
+   * \param to the destination address
+   * \param from the source address
+   * \param sender the sending device
+   */
+  void Deliver (Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
+                Ptr<SimpleNetDevice> sender);
+
+  double m_lossRate;                   //!< probability of dropping a packet
+  Time m_jitter;                       //!< largest extra delay
+  Ptr<UniformRandomVariable> m_loss;   //!< loss draws
+  Ptr<UniformRandomVariable> m_delay;  //!< jitter draws
+  uint64_t m_dropped;                  //!< packets dropped
+  TracedCallback<Ptr<const Packet> > m_dropTrace; //!< packets dropped
+};
+
+} // namespace ns3
+
+#endif /* LOSSY_CHANNEL_H */
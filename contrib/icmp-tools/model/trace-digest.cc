@@ -0,0 +1,256 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "trace-digest.h"
+
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TraceDigest");
+
+namespace {
+
+const uint64_t PRIME1 = 11400714785074694791ULL; //!< XXH64 prime 1
+const uint64_t PRIME2 = 14029467366897019727ULL; //!< XXH64 prime 2
+const uint64_t PRIME3 = 1609587929392839161ULL;  //!< XXH64 prime 3
+const uint64_t PRIME4 = 9650029242287828579ULL;  //!< XXH64 prime 4
+const uint64_t PRIME5 = 2870177450012600261ULL;  //!< XXH64 prime 5
+
+/**
+ * \param x a value
+ * \param r the rotation, 1 to 63
+ * \returns x rotated left by r bits
+ */
+uint64_t
+RotateLeft (uint64_t x, uint32_t r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+/**
+ * \param p 8 bytes
+ * \returns the bytes as a little-endian integer
+ */
+uint64_t
+Read64 (uint8_t const *p)
+{
+  uint64_t value = 0;
+  for (uint32_t k = 0; k < 8; k++)
+    {
+      value |= static_cast<uint64_t> (p[k]) << (8 * k);
+    }
+  return value;
+}
+
+/**
+ * \param p 4 bytes
+ * \returns the bytes as a little-endian integer
+ */
+uint64_t
+Read32 (uint8_t const *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint64_t> (p[3]) << 24);
+}
+
+/**
+ * \param acc an accumulator
+ * \param input 8 bytes of input
+ * \returns the accumulator with the input folded in
+ */
+uint64_t
+Round (uint64_t acc, uint64_t input)
+{
+  return RotateLeft (acc + input * PRIME2, 31) * PRIME1;
+}
+
+/**
+ * \param hash the hash so far
+ * \param acc an accumulator
+ * \returns the hash with the accumulator merged in
+ */
+uint64_t
+MergeRound (uint64_t hash, uint64_t acc)
+{
+  return (hash ^ Round (0, acc)) * PRIME1 + PRIME4;
+}
+
+} // anonymous namespace
+
+TraceDigest::Sink::Sink (TraceDigest *digest)
+  : m_digest (digest)
+{
+}
+
+std::streamsize
+TraceDigest::Sink::xsputn (char const *s, std::streamsize n)
+{
+  m_digest->Update (s, n);
+  return n;
+}
+
+TraceDigest::Sink::int_type
+TraceDigest::Sink::overflow (int_type c)
+{
+  if (!traits_type::eq_int_type (c, traits_type::eof ()))
+    {
+      char byte = traits_type::to_char_type (c);
+      m_digest->Update (&byte, 1);
+    }
+  return traits_type::not_eof (c);
+}
+
+TraceDigest::TraceDigest (uint64_t seed)
+  : m_seed (seed),
+    m_sink (this),
+    m_stream (&m_sink)
+{
+  NS_LOG_FUNCTION (this << seed);
+  Reset ();
+}
+
+void
+TraceDigest::Reset (void)
+{
+  m_acc[0] = m_seed + PRIME1 + PRIME2;
+  m_acc[1] = m_seed + PRIME2;
+  m_acc[2] = m_seed;
+  m_acc[3] = m_seed - PRIME1;
+  m_filled = 0;
+  m_length = 0;
+  m_packets = 0;
+}
+
+void
+TraceDigest::Consume (uint8_t const *stripe)
+{
+  for (uint32_t lane = 0; lane < 4; lane++)
+    {
+      m_acc[lane] = Round (m_acc[lane], Read64 (stripe + 8 * lane));
+    }
+}
+
+void
+TraceDigest::Update (void const *data, uint32_t size)
+{
+  uint8_t const *p = static_cast<uint8_t const *> (data);
+  m_length += size;
+  if (m_filled + size < sizeof (m_stripe))
+    {
+      std::memcpy (m_stripe + m_filled, p, size);
+      m_filled += size;
+      return;
+    }
+  if (m_filled > 0)
+    {
+      uint32_t fill = sizeof (m_stripe) - m_filled;
+      std::memcpy (m_stripe + m_filled, p, fill);
+      Consume (m_stripe);
+      p += fill;
+      size -= fill;
+      m_filled = 0;
+    }
+  for (; size >= sizeof (m_stripe); p += sizeof (m_stripe), size -= sizeof (m_stripe))
+    {
+      Consume (p);
+    }
+  std::memcpy (m_stripe, p, size);
+  m_filled = size;
+}
+
+void
+TraceDigest::UpdateU64 (uint64_t value)
+{
+  uint8_t bytes[8];
+  for (uint32_t k = 0; k < 8; k++)
+    {
+      bytes[k] = value >> (8 * k);
+    }
+  Update (bytes, sizeof (bytes));
+}
+
+void
+TraceDigest::AddPacket (Time time, uint32_t node, Ptr<const Packet> p)
+{
+  UpdateU64 (time.GetTimeStep ());
+  // node and size share one word: the size delimits the bytes that follow
+  UpdateU64 ((static_cast<uint64_t> (p->GetSize ()) << 32) | node);
+  p->CopyData (&m_stream, p->GetSize ());
+  m_packets++;
+}
+
+uint64_t
+TraceDigest::GetDigest (void) const
+{
+  uint64_t hash;
+  if (m_length >= sizeof (m_stripe))
+    {
+      hash = RotateLeft (m_acc[0], 1) + RotateLeft (m_acc[1], 7) + RotateLeft (m_acc[2], 12) + RotateLeft (m_acc[3], 18);
+      for (uint32_t lane = 0; lane < 4; lane++)
+        {
+          hash = MergeRound (hash, m_acc[lane]);
+        }
+    }
+  else
+    {
+      hash = m_seed + PRIME5;
+    }
+  hash += m_length;
+
+  uint8_t const *p = m_stripe;
+  uint8_t const *end = m_stripe + m_filled;
+  for (; p + 8 <= end; p += 8)
+    {
+      hash = RotateLeft (hash ^ Round (0, Read64 (p)), 27) * PRIME1 + PRIME4;
+    }
+  if (p + 4 <= end)
+    {
+      hash = RotateLeft (hash ^ (Read32 (p) * PRIME1), 23) * PRIME2 + PRIME3;
+      p += 4;
+    }
+  for (; p < end; p++)
+    {
+      hash = RotateLeft (hash ^ (*p * PRIME5), 11) * PRIME1;
+    }
+
+  hash ^= hash >> 33;
+  hash *= PRIME2;
+  hash ^= hash >> 29;
+  hash *= PRIME3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+uint64_t
+TraceDigest::GetPackets (void) const
+{
+  return m_packets;
+}
+
+std::string
+TraceDigest::ToString (uint64_t digest)
+{
+  static char const digits[] = "0123456789abcdef";
+  std::string text (16, '0');
+  for (uint32_t k = 0; k < 16; k++)
+    {
+      text[15 - k] = digits[(digest >> (4 * k)) & 0xf];
+    }
+  return text;
+}
+
+} // namespace ns3
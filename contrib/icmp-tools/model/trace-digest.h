@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_DIGEST_H
+#define TRACE_DIGEST_H
+
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+
+#include <stdint.h>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \brief Streaming XXH64 digest of a packet trace.
+ *
+ * AddPacket hashes the time, the node and the serialized bytes of a
+ * packet; the digest of a whole scenario then identifies its trace in 8
+ * bytes, whatever its length, and two runs delivered the same packets at
+ * the same times exactly when their digests match (barring a 64-bit
+ * collision). The packet bytes stream from the packet buffers into the
+ * hash through Packet::CopyData (std::ostream *, ...), with no copy.
+ *
+ * The hash is XXH64 as published, byte for byte: Update over a byte
+ * string gives the reference XXH64 of that string. Integers are hashed
+ * little-endian, so digests agree across hosts.
+ */
+class TraceDigest
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param seed the hash seed
+   */
+  TraceDigest (uint64_t seed = 0);
+
+  /**
+   * \brief Start over, as if just constructed.
+   */
+  void Reset (void);
+  /**
+   * \brief Hash bytes.
+   * \param data the bytes
+   * \param size number of bytes
+   */
+  void Update (void const *data, uint32_t size);
+  /**
+   * \brief Hash a delivered packet.
+   * \param time when it was delivered
+   * \param node where it was delivered
+   * \param p the packet
+   */
+  void AddPacket (Time time, uint32_t node, Ptr<const Packet> p);
+
+  /**
+   * \returns the digest of everything hashed so far; hashing can go on
+   */
+  uint64_t GetDigest (void) const;
+  /**
+   * \returns the number of packets hashed
+   */
+  uint64_t GetPackets (void) const;
+
+  /**
+   * \param digest a digest
+   * \returns the digest as 16 hexadecimal digits
+   */
+  static std::string ToString (uint64_t digest);
+
+private:
+  /**
+   * \brief Hash a 64-bit integer, little-endian.
+   * \param value the integer
+   */
+  void UpdateU64 (uint64_t value);
+  /**
+   * \brief Fold a 32-byte stripe into the accumulators.
+   * \param stripe the stripe
+   */
+  void Consume (uint8_t const *stripe);
+
+  /**
+   * \brief Stream buffer feeding what is written to it into the digest.
+   */
+  class Sink : public std::streambuf
+  {
+  public:
+    /**
+     * \param digest the digest to feed
+     */
+    Sink (TraceDigest *digest);
+
+  protected:
+    virtual std::streamsize xsputn (char const *s, std::streamsize n);
+    virtual int_type overflow (int_type c);
+
+  private:
+    TraceDigest *m_digest; //!< the digest fed
+  };
+
+  uint64_t m_seed;       //!< hash seed
+  uint64_t m_acc[4];     //!< stripe accumulators
+  uint8_t m_stripe[32];  //!< bytes of the stripe being filled
+  uint32_t m_filled;     //!< bytes in m_stripe
+  uint64_t m_length;     //!< bytes hashed
+  uint64_t m_packets;    //!< packets hashed
+  Sink m_sink;           //!< byte sink of m_stream
+  std::ostream m_stream; //!< stream Packet::CopyData writes to
+};
+
+} // namespace ns3
+
+#endif /* TRACE_DIGEST_H */
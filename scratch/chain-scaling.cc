@@ -0,0 +1,442 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Time Exceeded scaling over long chains.
+ *
+ * For each chain length, node 0 sends echo requests with every TTL
+ * (hop limit) to the far end of a chain of N routers, over IPv4 and IPv6
+ * raw sockets, so each router answers with a Time Exceeded and the far
+ * end with an echo reply. Every length reports the wall time of the
+ * topology setup, of the routes and of the probes, the events processed
+ * and the memory, so the growth of each part with N can be read off the
+ * table. Each length runs in its own child process so that its peak
+ * memory is its own.
+ *
+ * The TTL field is 8 bits: chains longer than 254 routers are probed up
+ * to TTL 255 only, the routers beyond that are still built and routed.
+ * Routes connect node 0 with every other node only (O(N) routes); with
+ * --routing=all every node reaches every link, through global routing on
+ * IPv4, which is O(N^2) and meant for short chains.
+ *
+ * --capture writes every packet crossing the chain to <prefix>-<N>.pcapng,
+ * or one <prefix>-<N>-<link> file per link, and reports the time spent
+ * capturing as a share of the probe wall time.
+ *
+ * Usage: ./waf --run "chain-scaling --routers=2,10,100,1000,10000"
+ *        ./waf --run "chain-scaling --routers=10,100,1000 --routing=all --probes=3"
+ *        ./waf --run "chain-scaling --routers=100 --family=v6 --fork=false"
+ *        ./waf --run "chain-scaling --routers=10,1000 --capture=chain --snapLength=128"
+ *        ./waf --run "chain-scaling --routers=100 --capture=chain --captureFormat=pcap --merged=false"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/icmpv4.h"
+#include "ns3/icmpv6-header.h"
+#include "ns3/uinteger.h"
+#include "ns3/icmp-topology.h"
+#include "ns3/link-capture.h"
+#include "ns3/ipv4-header-view.h"
+#include "ns3/ipv6-extension-chain.h"
+#include "ns3/ipv6-header.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("ChainScaling");
+
+namespace {
+
+/// Largest TTL or hop limit.
+const uint32_t MAX_TTL = 255;
+
+/**
+ * \brief What to capture of the links, if anything.
+ */
+struct CaptureSettings
+{
+  std::string prefix;         //!< capture file prefix, empty for no capture
+  LinkCapture::Format format; //!< file format
+  uint32_t snapLength;        //!< bytes captured per packet
+  bool merged;                //!< one file for the whole chain, rather than one per link
+};
+
+/**
+ * \returns the resident set size of the process in kilobytes
+ */
+long
+GetRssKb (void)
+{
+  long pages = 0;
+  long resident = 0;
+  FILE *statm = fopen ("/proc/self/statm", "r");
+  if (statm != 0)
+    {
+      if (fscanf (statm, "%ld %ld", &pages, &resident) != 2)
+        {
+          resident = 0;
+        }
+      fclose (statm);
+    }
+  return resident * (sysconf (_SC_PAGESIZE) / 1024);
+}
+
+/**
+ * \returns the peak resident set size of the process in kilobytes
+ */
+long
+GetMaxRssKb (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+/**
+ * \brief Replies received by the probing node.
+ */
+struct ProbeReplies
+{
+  uint32_t timeExceeded; //!< Time Exceeded messages
+  uint32_t echoReplies;  //!< echo replies
+
+  ProbeReplies ()
+    : timeExceeded (0),
+      echoReplies (0)
+  {
+  }
+
+  /**
+   * \brief Receive callback of the IPv4 raw socket.
+   * \param socket the socket
+   */
+  void
+  ReceiveV4 (Ptr<Socket> socket)
+  {
+    Ptr<Packet> p;
+    while ((p = socket->Recv ()))
+      {
+        uint8_t bytes[Ipv4HeaderView::MAX_SIZE + 1];
+        uint32_t size = p->CopyData (bytes, sizeof (bytes));
+        Ipv4HeaderView ipv4 (bytes, size);
+        if (!ipv4.IsValid () || ipv4.GetProtocol () != 1 || size <= ipv4.GetHeaderSize ())
+          {
+            continue;
+          }
+        uint8_t type = bytes[ipv4.GetHeaderSize ()];
+        timeExceeded += type == Icmpv4Header::ICMPV4_TIME_EXCEEDED;
+        echoReplies += type == Icmpv4Header::ICMPV4_ECHO_REPLY;
+      }
+  }
+
+  /**
+   * \brief Receive callback of the IPv6 raw socket.
+   * \param socket the socket
+   */
+  void
+  ReceiveV6 (Ptr<Socket> socket)
+  {
+    Ptr<Packet> p;
+    while ((p = socket->Recv ()))
+      {
+        uint8_t bytes[Ipv6ExtensionChain::WINDOW];
+        uint32_t size = p->CopyData (bytes, sizeof (bytes));
+        Ipv6ExtensionChain ipv6;
+        if (ipv6.Walk (bytes, size) != Ipv6ExtensionChain::CHAIN_OK
+            || ipv6.GetProtocol () != Ipv6Header::IPV6_ICMPV6 || size <= ipv6.GetUpperLayerOffset ())
+          {
+            continue;
+          }
+        uint8_t type = bytes[ipv6.GetUpperLayerOffset ()];
+        timeExceeded += type == Icmpv6Header::ICMPV6_ERROR_TIME_EXCEEDED;
+        echoReplies += type == Icmpv6Header::ICMPV6_ECHO_REPLY;
+      }
+  }
+};
+
+/**
+ * \brief Send echo requests with every TTL over IPv4.
+ * \param socket the raw ICMP socket
+ * \param dst the destination
+ * \param maxTtl the largest TTL
+ * \param probes requests per TTL
+ */
+void
+SendProbesV4 (Ptr<Socket> socket, Ipv4Address dst, uint32_t maxTtl, uint32_t probes)
+{
+  for (uint32_t ttl = 1; ttl <= maxTtl; ttl++)
+    {
+      socket->SetIpTtl (ttl);
+      for (uint32_t k = 0; k < probes; k++)
+        {
+          Ptr<Packet> p = Create<Packet> ();
+          Icmpv4Echo echo;
+          echo.SetIdentifier (5);
+          echo.SetSequenceNumber (ttl * probes + k);
+          p->AddHeader (echo);
+          Icmpv4Header header;
+          header.SetType (Icmpv4Header::ICMPV4_ECHO);
+          header.SetCode (0);
+          p->AddHeader (header);
+          NS_ABORT_MSG_UNLESS (socket->SendTo (p, 0, InetSocketAddress (dst, 0)) == static_cast<int> (p->GetSize ()),
+                               "Failed to send the IPv4 probe with TTL " << ttl);
+        }
+    }
+}
+
+/**
+ * \brief Send echo requests with every hop limit over IPv6.
+ * \param socket the raw ICMPv6 socket
+ * \param dst the destination
+ * \param maxTtl the largest hop limit
+ * \param probes requests per hop limit
+ */
+void
+SendProbesV6 (Ptr<Socket> socket, Ipv6Address dst, uint32_t maxTtl, uint32_t probes)
+{
+  for (uint32_t ttl = 1; ttl <= maxTtl; ttl++)
+    {
+      socket->SetIpv6HopLimit (ttl);
+      for (uint32_t k = 0; k < probes; k++)
+        {
+          Ptr<Packet> p = Create<Packet> ();
+          Icmpv6Echo echo (1);
+          echo.SetId (5);
+          echo.SetSeq (ttl * probes + k);
+          p->AddHeader (echo);
+          NS_ABORT_MSG_UNLESS (socket->SendTo (p, 0, Inet6SocketAddress (dst, 0)) == static_cast<int> (p->GetSize ()),
+                               "Failed to send the IPv6 probe with hop limit " << ttl);
+        }
+    }
+}
+
+/**
+ * \brief Build a chain, probe it and print one row of the report.
+ * \param routers the number of routers between the two ends
+ * \param probes requests per TTL
+ * \param routing the routes to install
+ * \param v4 true to probe over IPv4
+ * \param v6 true to probe over IPv6
+ * \param settings what to capture of the links
+ * \returns true if every expected reply came back
+ */
+bool
+RunChain (uint32_t routers, uint32_t probes, IcmpTopology::Routing routing, bool v4, bool v6,
+          CaptureSettings const &settings)
+{
+  long baseRss = GetRssKb ();
+  uint32_t maxTtl = std::min (routers + 1, MAX_TTL);
+
+  // every probe of the burst may wait on the same unresolved neighbor
+  Config::SetDefault ("ns3::ArpCache::PendingQueueSize", UintegerValue (maxTtl * probes));
+  Config::SetDefault ("ns3::NdiscCache::UnresolvedQueueSize", UintegerValue (maxTtl * probes));
+  // addresses are usable at once, so the events counted are the probes'
+  Config::SetDefault ("ns3::Icmpv6L4Protocol::DAD", BooleanValue (false));
+  // the answers cross the chain back: with the default TTL of 64, those
+  // from more than 64 hops away would expire on the way
+  Config::SetDefault ("ns3::Ipv4L3Protocol::DefaultTtl", UintegerValue (MAX_TTL));
+  Config::SetDefault ("ns3::Ipv6L3Protocol::DefaultHopLimit", UintegerValue (MAX_TTL));
+
+  IcmpTopology topology (IcmpTopology::CHAIN, routers + 2);
+  topology.SetRouting (routing);
+  topology.Build ();
+  long topologyRss = GetRssKb () - baseRss;
+  uint32_t last = topology.GetNLinks () - 1;
+
+  LinkCapture capture (settings.format, settings.snapLength);
+  if (!settings.prefix.empty ())
+    {
+      std::string extension = settings.format == LinkCapture::PCAP ? ".pcap" : ".pcapng";
+      for (uint32_t j = 0; j <= last; j++)
+        {
+          std::ostringstream file;
+          file << settings.prefix << "-" << routers;
+          if (!settings.merged)
+            {
+              file << "-" << j;
+            }
+          capture.AddLink (topology.GetLink (j), file.str () + extension, "link" + std::to_string (j));
+        }
+    }
+
+  ProbeReplies repliesV4;
+  ProbeReplies repliesV6;
+  uint32_t context = topology.GetNode (0)->GetId ();
+  if (v4)
+    {
+      Ptr<Socket> socket = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv4RawSocketFactory"));
+      socket->SetAttribute ("Protocol", UintegerValue (1)); // ICMP protocol
+      NS_ABORT_MSG_UNLESS (socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 0)) == 0,
+                           "Failed to bind the ICMP socket");
+      socket->SetRecvCallback (MakeCallback (&ProbeReplies::ReceiveV4, &repliesV4));
+      Simulator::ScheduleWithContext (context, Seconds (0), &SendProbesV4, socket,
+                                      topology.GetIpv4Address (last, 1), maxTtl, probes);
+    }
+  if (v6)
+    {
+      Ptr<Socket> socket = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv6RawSocketFactory"));
+      socket->SetAttribute ("Protocol", UintegerValue (Ipv6Header::IPV6_ICMPV6));
+      NS_ABORT_MSG_UNLESS (socket->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), 0)) == 0,
+                           "Failed to bind the ICMPv6 socket");
+      socket->SetRecvCallback (MakeCallback (&ProbeReplies::ReceiveV6, &repliesV6));
+      Simulator::ScheduleWithContext (context, Seconds (0), &SendProbesV6, socket,
+                                      topology.GetIpv6Address (last, 1), maxTtl, probes);
+    }
+
+  uint64_t events = Simulator::GetEventCount ();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  capture.Close ();
+  double probeSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  events = Simulator::GetEventCount () - events;
+  Simulator::Destroy ();
+
+  uint32_t expectedTimeExceeded = std::min (routers, maxTtl) * probes;
+  uint32_t expectedEchoReplies = maxTtl > routers ? probes : 0;
+  bool complete = true;
+  std::ostringstream replies;
+  if (v4)
+    {
+      replies << " v4 " << repliesV4.timeExceeded << "+" << repliesV4.echoReplies;
+      complete = complete && repliesV4.timeExceeded == expectedTimeExceeded
+        && repliesV4.echoReplies == expectedEchoReplies;
+    }
+  if (v6)
+    {
+      replies << " v6 " << repliesV6.timeExceeded << "+" << repliesV6.echoReplies;
+      complete = complete && repliesV6.timeExceeded == expectedTimeExceeded
+        && repliesV6.echoReplies == expectedEchoReplies;
+    }
+
+  uint32_t nodes = routers + 2;
+  std::cout << std::setw (8) << routers << std::fixed << std::setprecision (3)
+            << std::setw (10) << topology.GetSetupSeconds ()
+            << std::setw (10) << topology.GetRoutingSeconds ()
+            << std::setw (10) << probeSeconds
+            << std::setw (12) << events
+            << std::setprecision (0) << std::setw (12) << (probeSeconds > 0 ? events / probeSeconds : 0)
+            << std::setprecision (1) << std::setw (10) << topologyRss / 1024.0
+            << std::setw (10) << GetMaxRssKb () / 1024.0
+            << std::setw (9) << static_cast<double> (topologyRss) / nodes
+            << "  " << maxTtl << " TTLs," << replies.str ()
+            << (complete ? "" : "  (expected " + std::to_string (expectedTimeExceeded) + "+"
+                + std::to_string (expectedEchoReplies) + ")") << std::endl;
+  if (!settings.prefix.empty ())
+    {
+      std::cout << std::setw (8) << "" << "  capture: " << capture.GetPackets () << " packets, "
+                << std::setprecision (1) << capture.GetBytes () / 1048576.0 << " MiB in " << capture.GetFiles ()
+                << " file(s), " << std::setprecision (3) << capture.GetSeconds () << " s, "
+                << std::setprecision (1) << (probeSeconds > 0 ? 100 * capture.GetSeconds () / probeSeconds : 0)
+                << "% of the probe wall time" << std::endl;
+    }
+  return complete;
+}
+
+} // unnamed namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::string routerList = "2,10,100,1000,10000";
+  uint32_t probes = 1;
+  std::string routingName = "first";
+  std::string family = "both";
+  bool separate = true;
+  CaptureSettings settings;
+  std::string formatName = "pcapng";
+  settings.snapLength = 65535;
+  settings.merged = true;
+
+  CommandLine cmd;
+  cmd.AddValue ("routers", "Comma-separated chain lengths, in routers between the two ends", routerList);
+  cmd.AddValue ("probes", "Echo requests per TTL", probes);
+  cmd.AddValue ("routing", "Routes to install: first (node 0 to all) or all (all pairs)", routingName);
+  cmd.AddValue ("family", "Probe over v4, v6 or both", family);
+  cmd.AddValue ("fork", "Run each chain length in its own process", separate);
+  cmd.AddValue ("capture", "Capture every link to files with this prefix, empty for no capture", settings.prefix);
+  cmd.AddValue ("captureFormat", "Capture file format: pcap or pcapng", formatName);
+  cmd.AddValue ("snapLength", "Bytes captured per packet, Ethernet header included", settings.snapLength);
+  cmd.AddValue ("merged", "Capture a chain to one file, rather than one file per link", settings.merged);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_UNLESS (routingName == "first" || routingName == "all", "Unknown routing " << routingName);
+  NS_ABORT_MSG_UNLESS (family == "v4" || family == "v6" || family == "both", "Unknown family " << family);
+  NS_ABORT_MSG_UNLESS (probes > 0, "At least one probe per TTL");
+  NS_ABORT_MSG_UNLESS (formatName == "pcap" || formatName == "pcapng", "Unknown capture format " << formatName);
+  settings.format = formatName == "pcap" ? LinkCapture::PCAP : LinkCapture::PCAPNG;
+  IcmpTopology::Routing routing = routingName == "all" ? IcmpTopology::ALL_PAIRS : IcmpTopology::FROM_FIRST;
+  bool v4 = family != "v6";
+  bool v6 = family != "v4";
+
+  std::vector<uint32_t> lengths;
+  std::istringstream list (routerList);
+  std::string item;
+  while (std::getline (list, item, ','))
+    {
+      uint32_t routers = std::stoul (item);
+      NS_ABORT_MSG_UNLESS (routers >= 1 && routers <= 65533, "Chain of " << routers << " routers");
+      lengths.push_back (routers);
+    }
+
+  std::cout << "Time Exceeded chain scaling, " << probes << " probe(s) per TTL, routing "
+            << routingName << ", " << family << std::endl;
+  std::cout << std::setw (8) << "routers" << std::setw (10) << "setup s" << std::setw (10) << "routes s"
+            << std::setw (10) << "probe s" << std::setw (12) << "events" << std::setw (12) << "events/s"
+            << std::setw (10) << "topo MiB" << std::setw (10) << "peak MiB" << std::setw (9) << "KiB/node"
+            << "  replies (Time Exceeded+echo)" << std::endl;
+
+  bool complete = true;
+  for (uint32_t k = 0; k < lengths.size (); k++)
+    {
+      if (!separate)
+        {
+          complete = RunChain (lengths[k], probes, routing, v4, v6, settings) && complete;
+          continue;
+        }
+      std::cout.flush ();
+      pid_t pid = fork ();
+      NS_ABORT_MSG_UNLESS (pid >= 0, "fork failed");
+      if (pid == 0)
+        {
+          bool ok = RunChain (lengths[k], probes, routing, v4, v6, settings);
+          std::cout.flush ();
+          _exit (ok ? 0 : 1);
+        }
+      int status = 0;
+      waitpid (pid, &status, 0);
+      if (WIFSIGNALED (status))
+        {
+          std::cout << std::setw (8) << lengths[k] << "  killed by signal " << WTERMSIG (status) << std::endl;
+        }
+      complete = complete && WIFEXITED (status) && WEXITSTATUS (status) == 0;
+    }
+  return complete ? 0 : 1;
+}
@@ -0,0 +1,320 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Fragment reassembly stress test.
+ *
+ * Node 0 sends large ICMP echo requests to node 1 over a SimpleNetDevice
+ * link with a small MTU, so each echo leaves as dozens of fragments. The
+ * fragments reaching node 1 are fed to an Ipv4Reassembler as they arrive
+ * and captured; the capture is then replayed in order, last fragment
+ * first and shuffled across packets to time the reassembler alone.
+ *
+ * Usage: ./waf --run "fragment-stress --packets=1000 --size=65507 --mtu=576"
+ *        ./waf --run "fragment-stress --packets=200 --rounds=50 --seed=2"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/mac48-address.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/icmpv4.h"
+#include "ns3/socket.h"
+#include "ns3/uinteger.h"
+#include "ns3/ipv4-codec-header.h"
+#include "ns3/ipv4-reassembler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("FragmentStress");
+
+namespace {
+
+/**
+ * \brief Wall clock in nanoseconds.
+ * \returns a monotonic timestamp in nanoseconds
+ */
+uint64_t
+NowNs (void)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+           (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+/**
+ * \returns the peak resident set size of the process in kilobytes
+ */
+long
+GetMaxRssKb (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+/**
+ * \brief A fragment seen by the receiver.
+ */
+struct Fragment
+{
+  Ipv4CodecHeader header; //!< the fragment header
+  uint32_t offset;   //!< first payload byte in FragmentCapture::payloads
+  uint32_t size;     //!< payload size
+  Time time;         //!< arrival time
+};
+
+/**
+ * \brief Fragments seen by the receiver, reassembled as they arrive.
+ *
+ * The payloads of all fragments share one buffer so the capture of a
+ * few thousand 64 KiB echoes stays a handful of allocations.
+ */
+struct FragmentCapture
+{
+  std::vector<Fragment> fragments; //!< fragment headers, in arrival order
+  std::vector<uint8_t> payloads; //!< fragment payloads, back to back
+  Ipv4Reassembler reassembler; //!< live reassembly
+  uint32_t echoSize; //!< expected reassembled ICMP size
+
+  /**
+   * \brief Protocol handler of the receiving device.
+   * \param device the receiving device
+   * \param packet the received frame payload
+   * \param protocol the frame protocol
+   * \param from the sender address
+   * \param to the destination address
+   * \param type the packet type
+   */
+  void
+  Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+           const Address &from, const Address &to, NetDevice::PacketType type)
+  {
+    Fragment fragment;
+    Ptr<Packet> copy = packet->Copy ();
+    copy->RemoveHeader (fragment.header);
+    fragment.offset = payloads.size ();
+    fragment.size = copy->GetSize ();
+    fragment.time = Simulator::Now ();
+    payloads.resize (payloads.size () + fragment.size);
+    copy->CopyData (&payloads[fragment.offset], fragment.size);
+    fragments.push_back (fragment);
+
+    if (reassembler.Add (fragment.header, &payloads[fragment.offset], fragment.size, fragment.time)
+        == Ipv4Reassembler::PACKET_COMPLETE)
+      {
+        NS_ABORT_MSG_UNLESS (reassembler.GetPacket ().size () == echoSize,
+                             "Reassembled " << reassembler.GetPacket ().size () << " bytes, sent " << echoSize);
+      }
+  }
+};
+
+/**
+ * \brief Send one echo request.
+ * \param socket the raw ICMP socket
+ * \param dst the destination
+ * \param sequence the echo sequence number
+ * \param data the echo data size
+ */
+void
+SendEcho (Ptr<Socket> socket, Ipv4Address dst, uint16_t sequence, uint32_t data)
+{
+  Ptr<Packet> p = Create<Packet> ();
+  Icmpv4Echo echo;
+  echo.SetIdentifier (5);
+  echo.SetSequenceNumber (sequence);
+  echo.SetData (Create<Packet> (data));
+  p->AddHeader (echo);
+
+  Icmpv4Header header;
+  header.SetType (Icmpv4Header::ICMPV4_ECHO);
+  header.SetCode (0);
+  p->AddHeader (header);
+
+  NS_ABORT_MSG_UNLESS (socket->SendTo (p, 0, InetSocketAddress (dst, 0)) == static_cast<int> (p->GetSize ()),
+                       "Failed to send echo " << sequence);
+}
+
+/**
+ * \brief Time the reassembly of captured fragments.
+ * \param name the replay order, for the report
+ * \param capture the captured fragments
+ * \param order the fragments to feed, as indices into capture.fragments
+ * \param packets the number of packets the fragments make
+ * \param rounds the number of passes over the fragments
+ */
+void
+Replay (char const *name, FragmentCapture const &capture, std::vector<uint32_t> const &order,
+        uint32_t packets, uint32_t rounds)
+{
+  uint64_t bytes = 0;
+  uint64_t elapsed = 0;
+  uint64_t peak = 0;
+  for (uint32_t round = 0; round < rounds; round++)
+    {
+      // each round starts from an empty table, as a fresh receiver would
+      Ipv4Reassembler reassembler;
+      uint64_t start = NowNs ();
+      for (uint32_t i = 0; i < order.size (); i++)
+        {
+          Fragment const &f = capture.fragments[order[i]];
+          if (reassembler.Add (f.header, &capture.payloads[f.offset], f.size, f.time)
+              == Ipv4Reassembler::PACKET_COMPLETE)
+            {
+              bytes += reassembler.GetPacket ().size ();
+            }
+        }
+      elapsed += NowNs () - start;
+      NS_ABORT_MSG_UNLESS (reassembler.GetCompleteCount () == packets,
+                           name << ": reassembled " << reassembler.GetCompleteCount () << " of " << packets);
+      peak = std::max (peak, reassembler.GetPeakMemory ());
+    }
+
+  double seconds = elapsed / 1e9;
+  std::cout << std::left << std::setw (10) << name << std::right << std::fixed << std::setprecision (0)
+            << std::setw (12) << packets * rounds / seconds << " packets/s"
+            << std::setw (10) << bytes / seconds / 1e6 << " MB/s"
+            << std::setw (12) << order.size () * rounds / seconds << " fragments/s"
+            << "   peak " << std::setprecision (1) << peak / 1024.0 << " KiB" << std::endl;
+}
+
+} // unnamed namespace
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t packets = 1000;
+  uint32_t size = 65507;
+  uint32_t mtu = 576;
+  uint32_t rounds = 20;
+  uint32_t seed = 1;
+
+  CommandLine cmd;
+  cmd.AddValue ("packets", "Number of echo requests sent", packets);
+  cmd.AddValue ("size", "Echo data bytes, at most 65507", size);
+  cmd.AddValue ("mtu", "MTU of the link", mtu);
+  cmd.AddValue ("rounds", "Replays of the captured fragments per order", rounds);
+  cmd.AddValue ("seed", "Seed of the shuffled replay", seed);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_UNLESS (size <= 65507, "An echo of " << size << " data bytes does not fit an IPv4 packet");
+  NS_ABORT_MSG_UNLESS (packets <= 65536, "Echoes beyond 65536 would reuse IPv4 identifications");
+
+  NodeContainer n;
+  n.Create (2);
+
+  InternetStackHelper internet;
+  internet.Install (n);
+
+  Ptr<SimpleNetDevice> txDev = CreateObject<SimpleNetDevice> ();
+  Ptr<SimpleNetDevice> rxDev = CreateObject<SimpleNetDevice> ();
+  txDev->SetAddress (Mac48Address::Allocate ());
+  rxDev->SetAddress (Mac48Address::Allocate ());
+  txDev->SetMtu (mtu);
+  rxDev->SetMtu (mtu);
+  n.Get (0)->AddDevice (txDev);
+  n.Get (1)->AddDevice (rxDev);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  txDev->SetChannel (channel);
+  rxDev->SetChannel (channel);
+  NetDeviceContainer d;
+  d.Add (txDev);
+  d.Add (rxDev);
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.252");
+  Ipv4InterfaceContainer i = ipv4.Assign (d);
+
+  FragmentCapture capture;
+  capture.echoSize = size + 8;
+  capture.fragments.reserve (static_cast<uint64_t> (packets) * (size / ((mtu - 20) & ~7u) + 1));
+  capture.payloads.reserve (static_cast<uint64_t> (packets) * capture.echoSize);
+  n.Get (1)->RegisterProtocolHandler (MakeCallback (&FragmentCapture::Receive, &capture),
+                                      0x0800, rxDev, false);
+
+  Ptr<Socket> socket = Socket::CreateSocket (n.Get (0), TypeId::LookupByName ("ns3::Ipv4RawSocketFactory"));
+  socket->SetAttribute ("Protocol", UintegerValue (1)); // ICMP protocol
+  NS_ABORT_MSG_UNLESS (socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 0)) == 0,
+                       "Failed to bind the ICMP socket");
+  for (uint32_t seq = 0; seq < packets; seq++)
+    {
+      Simulator::ScheduleWithContext (n.Get (0)->GetId (), MilliSeconds (seq),
+                                      &SendEcho, socket, i.GetAddress (1, 0), seq, size);
+    }
+
+  uint64_t start = NowNs ();
+  Simulator::Run ();
+  uint64_t elapsed = NowNs () - start;
+  Simulator::Destroy ();
+
+  Ipv4Reassembler const &live = capture.reassembler;
+  NS_ABORT_MSG_UNLESS (live.GetCompleteCount () == packets,
+                       "Reassembled " << live.GetCompleteCount () << " of " << packets << " echoes");
+
+  std::cout << "Fragment reassembly: " << packets << " echoes of " << capture.echoSize
+            << " bytes, MTU " << mtu << ", " << capture.fragments.size () << " fragments" << std::endl;
+  std::cout << "simulation " << std::fixed << std::setprecision (3) << elapsed / 1e9 << " s, "
+            << std::setprecision (0) << packets / (elapsed / 1e9) << " packets/s, reassembler peak "
+            << std::setprecision (1) << live.GetPeakMemory () / 1024.0 << " KiB, "
+            << live.GetDroppedCount () << " dropped" << std::endl;
+
+  std::vector<uint32_t> order (capture.fragments.size ());
+  for (uint32_t k = 0; k < order.size (); k++)
+    {
+      order[k] = k;
+    }
+  Replay ("in-order", capture, order, packets, rounds);
+
+  // the same packets, each with its last fragment first so the buffer is sized at once
+  std::vector<uint32_t> reversed;
+  reversed.reserve (order.size ());
+  uint32_t first = 0;
+  for (uint32_t k = 0; k < order.size (); k++)
+    {
+      if (capture.fragments[k].header.IsLastFragment ())
+        {
+          for (uint32_t j = k + 1; j-- > first; )
+            {
+              reversed.push_back (j);
+            }
+          first = k + 1;
+        }
+    }
+  Replay ("reversed", capture, reversed, packets, rounds);
+
+  // every packet in flight at once: the table and the memory bound at their worst
+  std::mt19937 rng (seed);
+  std::shuffle (order.begin (), order.end (), rng);
+  Replay ("shuffled", capture, order, packets, rounds);
+
+  std::cout << "process peak RSS " << GetMaxRssKb () / 1024.0 << " MiB" << std::endl;
+  return 0;
+}
@@ -0,0 +1,1924 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Microbenchmarks for the IPv4/IPv6 header codecs in this directory.
+ *
+ * Usage: ./waf --run "header-bench --bench=forward --hops=64 --packets=100000"
+ *        ./waf --run "header-bench --bench=checksum"
+ *        ./waf --run "header-bench --bench=view --packets=1000000"
+ *        ./waf --run "header-bench --bench=options --packets=1000000"
+ *        ./waf --run "header-bench --bench=extensions --packets=1000000"
+ *        ./waf --run "header-bench --bench=compact --packets=1000000"
+ *        ./waf --run "header-bench --bench=accessors --packets=10000000"
+ *        ./waf --run "header-bench --bench=construct --packets=1000000"
+ *        ./waf --run "header-bench --bench=batch --packets=1000000"
+ *        ./waf --run "header-bench --bench=codec --packets=1000000 --seed=1 --json=codec.json"
+ *        ./waf --run "header-bench --bench=dump --packets=1000000"
+ *        ./waf --run "header-bench --bench=validate --packets=1000000"
+ *        ./waf --run "header-bench --bench=flowkey --packets=1000000"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/buffer.h"
+#include "ns3/ipv4-codec-header.h"
+#include "ns3/ipv4-compact-header.h"
+#include "ns3/ipv6-codec-header.h"
+#include "ns3/ipv4-header-view.h"
+#include "ns3/ipv6-header-view.h"
+#include "ns3/ipv6-extension-chain.h"
+#include "ns3/ip-header-batch.h"
+#include "ns3/ip-flow-key.h"
+#include "ns3/header-trace.h"
+#include "ns3/ip-checksum.h"
+#include "ns3/header-log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("HeaderBench");
+
+namespace {
+
+/// Results are folded into this so the compiler can't drop the work.
+volatile uint32_t g_sink;
+
+/**
+ * \brief Wall clock in nanoseconds.
+ * \returns a monotonic timestamp in nanoseconds
+ */
+uint64_t
+NowNs (void)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+           (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+/**
+ * \brief Build the header a router would receive.
+ * \param incremental whether the header uses the incremental checksum mode
+ * \returns a 20-byte header with a good checksum
+ */
+Ipv4CodecHeader
+MakeForwardedHeader (bool incremental)
+{
+  Ipv4CodecHeader h;
+  if (incremental)
+    {
+      h.EnableIncrementalChecksum ();
+    }
+  else
+    {
+      h.EnableChecksum ();
+    }
+  h.SetSource (Ipv4Address ("10.0.0.1"));
+  h.SetDestination (Ipv4Address ("10.0.1.2"));
+  h.SetProtocol (1);
+  h.SetPayloadSize (64);
+  h.SetIdentification (0x1234);
+  h.SetTtl (255);
+  return h;
+}
+
+/**
+ * \brief Forward packets along a router chain.
+ *
+ * Each hop does what Ipv4L3Protocol::IpForward does to the header:
+ * deserialize it, decrement the TTL and serialize it back.
+ *
+ * \param hops number of routers in the chain
+ * \param packets number of packets sent through the chain
+ * \param incremental use the RFC 1624 incremental checksum mode
+ * \returns nanoseconds per hop
+ */
+double
+BenchForwarding (uint32_t hops, uint32_t packets, bool incremental)
+{
+  Buffer buffer;
+  buffer.AddAtStart (20);
+
+  uint64_t start = NowNs ();
+  for (uint32_t p = 0; p < packets; p++)
+    {
+      MakeForwardedHeader (incremental).Serialize (buffer.Begin ());
+      for (uint32_t hop = 0; hop < hops; hop++)
+        {
+          Ipv4CodecHeader h;
+          if (incremental)
+            {
+              h.EnableIncrementalChecksum ();
+            }
+          else
+            {
+              h.EnableChecksum ();
+            }
+          h.Deserialize (buffer.Begin ());
+          NS_ABORT_MSG_UNLESS (h.IsChecksumOk (), "bad checksum at hop " << hop);
+          // chains longer than 255 hops would expire the packet
+          h.SetTtl (h.GetTtl () > 1 ? h.GetTtl () - 1 : 255);
+          h.Serialize (buffer.Begin ());
+        }
+      g_sink = g_sink + buffer.Begin ().ReadU16 ();
+    }
+  uint64_t elapsed = NowNs () - start;
+  return static_cast<double> (elapsed) / (static_cast<double> (packets) * hops);
+}
+
+/**
+ * \brief Print the forwarding benchmark, full versus incremental checksum.
+ * \param hops number of routers in the chain
+ * \param packets number of packets sent through the chain
+ */
+void
+RunForwarding (uint32_t hops, uint32_t packets)
+{
+  double full = BenchForwarding (hops, packets, false);
+  double incremental = BenchForwarding (hops, packets, true);
+
+  std::cout << std::fixed << std::setprecision (2)
+            << "forwarding, " << hops << " hops, " << packets << " packets\n"
+            << "  full checksum        " << full << " ns/hop\n"
+            << "  incremental checksum " << incremental << " ns/hop\n"
+            << "  speedup              " << full / incremental << "x" << std::endl;
+}
+
+/**
+ * \brief Checksum a payload over and over.
+ * \param buffer the payload, also read through Buffer::Iterator
+ * \param bytes total number of bytes to checksum
+ * \param kernel the IpChecksum kernel, or -1 for Buffer::Iterator::CalculateIpChecksum
+ *        and -2 for IpChecksum over a Buffer::Iterator
+ * \param expected the checksum every run must return
+ * \returns throughput in GB/s
+ */
+double
+BenchChecksum (Buffer const &buffer, uint64_t bytes, int kernel, uint16_t expected)
+{
+  uint32_t size = buffer.GetSize ();
+  std::vector<uint8_t> flat (size);
+  buffer.CopyData (&flat[0], size);
+  uint64_t rounds = bytes / size + 1;
+
+  uint64_t start = NowNs ();
+  for (uint64_t r = 0; r < rounds; r++)
+    {
+      uint16_t checksum;
+      if (kernel == -1)
+        {
+          checksum = buffer.Begin ().CalculateIpChecksum (size);
+        }
+      else if (kernel == -2)
+        {
+          checksum = IpChecksum::Calculate (buffer.Begin (), size);
+        }
+      else
+        {
+          checksum = IpChecksum::Calculate (&flat[0], size, 0, IpChecksum::Kernel (kernel));
+        }
+      NS_ABORT_MSG_UNLESS (checksum == expected, "checksum mismatch for " << size << " bytes");
+      g_sink = g_sink + checksum;
+    }
+  uint64_t elapsed = NowNs () - start;
+  return static_cast<double> (rounds * size) / elapsed;
+}
+
+/**
+ * \brief Print the checksum throughput for ICMP echo payload sizes.
+ * \param megabytes amount of data checksummed per size and kernel
+ */
+void
+RunChecksum (uint32_t megabytes)
+{
+  std::cout << "checksum throughput (GB/s), best kernel: "
+            << IpChecksum::GetKernelName (IpChecksum::AUTO) << "\n"
+            << std::setw (8) << "bytes" << std::setw (10) << "iterator"
+            << std::setw (10) << "chunked" << std::setw (10) << "scalar"
+            << std::setw (10) << "sse2" << std::setw (10) << "avx2" << "\n";
+  std::cout << std::fixed << std::setprecision (2);
+
+  // 1 KiB to 64 KiB; the IP checksum covers at most 65535 bytes
+  const uint32_t sizes[] = { 1024, 2048, 4096, 8192, 16384, 32768, 65535 };
+  uint32_t rng = 12345;
+  for (uint32_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+    {
+      uint32_t bytes = sizes[s];
+      Buffer buffer;
+      buffer.AddAtStart (bytes);
+      Buffer::Iterator it = buffer.Begin ();
+      for (uint32_t k = 0; k < bytes; k++)
+        {
+          rng = rng * 1103515245 + 12345;
+          it.WriteU8 (rng >> 16);
+        }
+      uint16_t expected = buffer.Begin ().CalculateIpChecksum (bytes);
+      uint64_t total = static_cast<uint64_t> (megabytes) << 20;
+
+      std::cout << std::setw (8) << bytes
+                << std::setw (10) << BenchChecksum (buffer, total, -1, expected)
+                << std::setw (10) << BenchChecksum (buffer, total, -2, expected);
+      const IpChecksum::Kernel kernels[] = { IpChecksum::SCALAR, IpChecksum::SSE2, IpChecksum::AVX2 };
+      for (uint32_t k = 0; k < 3; k++)
+        {
+          if (IpChecksum::IsSupported (kernels[k]))
+            {
+              std::cout << std::setw (10) << BenchChecksum (buffer, total, kernels[k], expected);
+            }
+          else
+            {
+              std::cout << std::setw (10) << "-";
+            }
+        }
+      std::cout << std::endl;
+    }
+}
+
+/**
+ * \brief Serialize a trace of back-to-back IPv4 and IPv6 headers.
+ *
+ * Protocols cycle through ICMP, TCP and UDP so that classification has
+ * something to count.
+ *
+ * \param count number of headers of each family
+ * \param v4 buffer receiving count 20-byte IPv4 headers
+ * \param v6 buffer receiving count 40-byte IPv6 headers
+ */
+void
+MakeHeaderTrace (uint32_t count, Buffer &v4, Buffer &v6)
+{
+  const uint8_t protocols[] = { 1, 6, 17 };
+  v4.AddAtStart (count * 20);
+  v6.AddAtStart (count * 40);
+  Buffer::Iterator i4 = v4.Begin ();
+  Buffer::Iterator i6 = v6.Begin ();
+  for (uint32_t k = 0; k < count; k++)
+    {
+      Ipv4CodecHeader h4;
+      h4.SetSource (Ipv4Address (0x0a000000 + k));
+      h4.SetDestination (Ipv4Address ("10.0.1.2"));
+      h4.SetProtocol (protocols[k % 3]);
+      h4.SetTtl (64);
+      h4.SetPayloadSize (64);
+      h4.Serialize (i4);
+      i4.Next (20);
+
+      Ipv6CodecHeader h6;
+      h6.SetNextHeader (k % 3 ? protocols[k % 3] : Ipv6CodecHeader::IPV6_ICMPV6);
+      h6.SetHopLimit (64);
+      h6.SetPayloadLength (64);
+      h6.Serialize (i6);
+      i6.Next (40);
+    }
+}
+
+/**
+ * \brief Classify a header trace by protocol, with full deserialization or views.
+ * \param v4 back-to-back IPv4 headers
+ * \param v6 back-to-back IPv6 headers
+ * \param count number of headers of each family
+ * \param rounds number of passes over the trace
+ * \param view use Ipv4HeaderView / Ipv6HeaderView instead of Deserialize
+ * \returns nanoseconds per header
+ */
+double
+BenchClassify (Buffer const &v4, Buffer const &v6, uint32_t count, uint32_t rounds, bool view)
+{
+  uint8_t const *d4 = v4.PeekData ();
+  uint8_t const *d6 = v6.PeekData ();
+  uint32_t icmp = 0;
+
+  uint64_t start = NowNs ();
+  for (uint32_t r = 0; r < rounds; r++)
+    {
+      Buffer::Iterator i4 = v4.Begin ();
+      Buffer::Iterator i6 = v6.Begin ();
+      for (uint32_t k = 0; k < count; k++)
+        {
+          if (view)
+            {
+              icmp += Ipv4HeaderView (d4 + 20 * k, 20).GetProtocol () == 1;
+              icmp += Ipv6HeaderView (d6 + 40 * k, 40).GetNextHeader () == Ipv6CodecHeader::IPV6_ICMPV6;
+            }
+          else
+            {
+              Ipv4CodecHeader h4;
+              i4.Next (h4.Deserialize (i4));
+              icmp += h4.GetProtocol () == 1;
+              Ipv6CodecHeader h6;
+              i6.Next (h6.Deserialize (i6));
+              icmp += h6.GetNextHeader () == Ipv6CodecHeader::IPV6_ICMPV6;
+            }
+        }
+    }
+  uint64_t elapsed = NowNs () - start;
+  NS_ABORT_MSG_UNLESS (icmp == rounds * 2 * ((count + 2) / 3), "misclassified headers");
+  g_sink = g_sink + icmp;
+  return static_cast<double> (elapsed) / (2.0 * rounds * count);
+}
+
+/**
+ * \brief Print the protocol classification cost, Deserialize versus views.
+ * \param packets number of headers classified per family
+ */
+void
+RunView (uint32_t packets)
+{
+  // a trace small enough to stay in cache, replayed until packets are classified
+  uint32_t count = 4096;
+  uint32_t rounds = packets / count + 1;
+  Buffer v4;
+  Buffer v6;
+  MakeHeaderTrace (count, v4, v6);
+
+  double full = BenchClassify (v4, v6, count, rounds, false);
+  double view = BenchClassify (v4, v6, count, rounds, true);
+
+  std::cout << std::fixed << std::setprecision (2)
+            << "classify by protocol, " << rounds * count << " IPv4 + IPv6 headers\n"
+            << "  Deserialize          " << full << " ns/header\n"
+            << "  header view          " << view << " ns/header\n"
+            << "  speedup              " << full / view << "x" << std::endl;
+}
+
+/**
+ * \brief Serialize and deserialize a header over and over.
+ * \param header the header to round-trip
+ * \param packets number of round trips
+ * \returns nanoseconds per round trip
+ */
+double
+BenchRoundTrip (Ipv4CodecHeader const &header, uint32_t packets)
+{
+  Buffer buffer;
+  buffer.AddAtStart (header.GetSerializedSize ());
+
+  uint64_t start = NowNs ();
+  for (uint32_t p = 0; p < packets; p++)
+    {
+      header.Serialize (buffer.Begin ());
+      Ipv4CodecHeader h;
+      h.EnableChecksum ();
+      NS_ABORT_MSG_UNLESS (h.Deserialize (buffer.Begin ()) == header.GetSerializedSize (),
+                           "header size changed in the round trip");
+      g_sink = g_sink + h.IsChecksumOk ();
+    }
+  uint64_t elapsed = NowNs () - start;
+  return static_cast<double> (elapsed) / packets;
+}
+
+/**
+ * \brief Round-trip a header whose option area starts with End of Option List.
+ *
+ * Such a header keeps no option bytes but has an IHL of 6. Serialize must
+ * still write all 24 bytes, and the checksum must cover them, whether it
+ * is recomputed or patched incrementally after a TTL decrement.
+ */
+void
+CheckEolOptions (void)
+{
+  Buffer buffer;
+  buffer.AddAtStart (24);
+  MakeForwardedHeader (false).Serialize (buffer.Begin ());
+  Buffer::Iterator i = buffer.Begin ();
+  i.WriteU8 ((4 << 4) | 6);
+  i.Next (9);
+  i.WriteU16 (0);
+  i.Next (8);
+  i.WriteU8 (0, 4); // End of Option List, then padding
+  i = buffer.Begin ();
+  i.Next (10);
+  i.WriteU16 (IpChecksum::Calculate (buffer.Begin (), 24));
+
+  for (int incremental = 0; incremental < 2; incremental++)
+    {
+      Ipv4CodecHeader h;
+      if (incremental)
+        {
+          h.EnableIncrementalChecksum ();
+        }
+      else
+        {
+          h.EnableChecksum ();
+        }
+      NS_ABORT_MSG_UNLESS (h.Deserialize (buffer.Begin ()) == 24 && h.IsChecksumOk (),
+                           "EOL-first options do not deserialize");
+      h.SetTtl (h.GetTtl () - 1);
+
+      Buffer out;
+      out.AddAtStart (24);
+      out.Begin ().WriteU8 (0xff, 24); // Serialize must overwrite every byte
+      h.Serialize (out.Begin ());
+      Ipv4CodecHeader back;
+      back.EnableChecksum ();
+      NS_ABORT_MSG_UNLESS (back.Deserialize (out.Begin ()) == 24 && back.IsChecksumOk (),
+                           "EOL-first options: bad checksum after the round trip");
+      NS_ABORT_MSG_UNLESS (std::memcmp (out.PeekData () + 20, buffer.PeekData () + 20, 4) == 0,
+                           "EOL-first options: option area not zero-filled");
+    }
+}
+
+/**
+ * \brief Print the round-trip cost of IPv4 headers with and without options.
+ * \param packets number of round trips per header
+ */
+void
+RunOptions (uint32_t packets)
+{
+  CheckEolOptions ();
+
+  Ipv4CodecHeader plain = MakeForwardedHeader (false);
+
+  Ipv4CodecHeader recordRoute = MakeForwardedHeader (false);
+  recordRoute.AddRecordRouteOption (9);
+  recordRoute.RecordRoute (Ipv4Address ("10.0.0.1"));
+
+  Ipv4CodecHeader timestamp = MakeForwardedHeader (false);
+  timestamp.AddRouterAlertOption ();
+  timestamp.AddTimestampOption (4, Ipv4CodecHeader::TIMESTAMP_AND_ADDRESS);
+  timestamp.RecordTimestamp (Ipv4Address ("10.0.0.1"), 1000);
+
+  std::cout << std::fixed << std::setprecision (2)
+            << "serialize + deserialize round trip, " << packets << " packets\n"
+            << "  " << plain.GetSerializedSize () << " bytes, no options          "
+            << BenchRoundTrip (plain, packets) << " ns\n"
+            << "  " << recordRoute.GetSerializedSize () << " bytes, record route        "
+            << BenchRoundTrip (recordRoute, packets) << " ns\n"
+            << "  " << timestamp.GetSerializedSize () << " bytes, alert + timestamp   "
+            << BenchRoundTrip (timestamp, packets) << " ns" << std::endl;
+}
+
+/**
+ * \brief Serialize an IPv6 packet whose extension headers end with ICMPv6.
+ * \param types Next Header values of the extension headers, in order
+ * \param sizes sizes in bytes of the extension headers, multiples of 8
+ * \param count number of extension headers
+ * \returns the IPv6 header, extension headers and an 8-byte ICMPv6 echo
+ */
+std::vector<uint8_t>
+MakeExtensionChain (uint8_t const *types, uint32_t const *sizes, uint32_t count)
+{
+  std::vector<uint8_t> bytes (40);
+  Ipv6CodecHeader h;
+  h.SetNextHeader (count ? types[0] : Ipv6CodecHeader::IPV6_ICMPV6);
+  h.SetHopLimit (64);
+  Buffer buffer;
+  buffer.AddAtStart (40);
+  h.Serialize (buffer.Begin ());
+  buffer.CopyData (&bytes[0], 40);
+
+  for (uint32_t k = 0; k < count; k++)
+    {
+      std::vector<uint8_t> ext (sizes[k], 0);
+      ext[0] = k + 1 < count ? types[k + 1] : Ipv6CodecHeader::IPV6_ICMPV6;
+      if (types[k] == Ipv6CodecHeader::IPV6_EXT_AUTHENTIFICATION)
+        {
+          ext[1] = sizes[k] / 4 - 2;
+        }
+      else if (types[k] != Ipv6CodecHeader::IPV6_EXT_FRAGMENTATION)
+        {
+          ext[1] = sizes[k] / 8 - 1;
+        }
+      if (types[k] == Ipv6CodecHeader::IPV6_EXT_ROUTING)
+        {
+          ext[2] = 4; // segment routing header
+          ext[3] = (sizes[k] - 8) / 16; // segments left
+        }
+      if (types[k] == Ipv6CodecHeader::IPV6_EXT_FRAGMENTATION)
+        {
+          ext[3] = 1; // first fragment, more to come
+          ext[7] = 42; // identification
+        }
+      bytes.insert (bytes.end (), ext.begin (), ext.end ());
+    }
+  const uint8_t echo[8] = { 128, 0, 0, 0, 0xb1, 0xed, 0, 1 };
+  bytes.insert (bytes.end (), echo, echo + 8);
+  return bytes;
+}
+
+/**
+ * \brief Print the cost of walking realistic IPv6 extension header chains.
+ * \param packets number of walks per chain
+ */
+void
+RunExtensions (uint32_t packets)
+{
+  const uint8_t hbh = Ipv6CodecHeader::IPV6_EXT_HOP_BY_HOP;
+  const uint8_t dst = Ipv6CodecHeader::IPV6_EXT_DESTINATION;
+  const uint8_t rt = Ipv6CodecHeader::IPV6_EXT_ROUTING;
+  const uint8_t frag = Ipv6CodecHeader::IPV6_EXT_FRAGMENTATION;
+  const uint8_t ah = Ipv6CodecHeader::IPV6_EXT_AUTHENTIFICATION;
+
+  const uint8_t alertTypes[] = { hbh };
+  const uint32_t alertSizes[] = { 8 };
+  const uint8_t srTypes[] = { dst, rt, frag };
+  const uint32_t srSizes[] = { 8, 40, 8 };
+  const uint8_t fullTypes[] = { hbh, dst, rt, frag, ah, dst };
+  const uint32_t fullSizes[] = { 8, 16, 24, 8, 16, 8 };
+
+  struct Case
+  {
+    const char *name;
+    std::vector<uint8_t> bytes;
+    uint32_t extensions;
+  } cases[] = {
+    { "no extension", MakeExtensionChain (0, 0, 0), 0 },
+    { "hop-by-hop", MakeExtensionChain (alertTypes, alertSizes, 1), 1 },
+    { "dest + routing + fragment", MakeExtensionChain (srTypes, srSizes, 3), 3 },
+    { "hbh + dst + rt + frag + ah + dst", MakeExtensionChain (fullTypes, fullSizes, 6), 6 },
+  };
+
+  std::cout << std::fixed << std::setprecision (2)
+            << "extension header chain walk, " << packets << " packets\n";
+  for (uint32_t c = 0; c < sizeof (cases) / sizeof (cases[0]); c++)
+    {
+      std::vector<uint8_t> const &bytes = cases[c].bytes;
+      uint32_t expectedOffset = bytes.size () - 8;
+      uint64_t start = NowNs ();
+      for (uint32_t p = 0; p < packets; p++)
+        {
+          Ipv6ExtensionChain chain;
+          chain.Walk (&bytes[0], bytes.size ());
+          NS_ABORT_MSG_UNLESS (chain.GetStatus () == Ipv6ExtensionChain::CHAIN_OK
+                               && chain.GetProtocol () == Ipv6CodecHeader::IPV6_ICMPV6
+                               && chain.GetUpperLayerOffset () == expectedOffset
+                               && chain.GetExtensionCount () == cases[c].extensions,
+                               "wrong walk of " << cases[c].name);
+          g_sink = g_sink + chain.GetUpperLayerOffset ();
+        }
+      uint64_t elapsed = NowNs () - start;
+      std::cout << "  " << std::left << std::setw (34) << cases[c].name << std::right
+                << std::setw (4) << expectedOffset << " bytes  "
+                << static_cast<double> (elapsed) / packets << " ns" << std::endl;
+    }
+}
+
+/**
+ * \brief Serialize the same header over and over.
+ * \param header the header to serialize
+ * \param packets number of calls
+ * \returns nanoseconds per Serialize
+ */
+template <typename T>
+double
+BenchSerialize (T const &header, uint32_t packets)
+{
+  Buffer buffer;
+  buffer.AddAtStart (header.GetSerializedSize ());
+
+  uint64_t start = NowNs ();
+  for (uint32_t p = 0; p < packets; p++)
+    {
+      header.Serialize (buffer.Begin ());
+      g_sink = g_sink + *buffer.PeekData ();
+    }
+  uint64_t elapsed = NowNs () - start;
+  return static_cast<double> (elapsed) / packets;
+}
+
+/**
+ * \brief Deserialize the same bytes over and over.
+ * \param buffer the serialized header
+ * \param packets number of calls
+ * \param checksum true to verify the checksum
+ * \returns nanoseconds per Deserialize
+ */
+template <typename T>
+double
+BenchDeserialize (Buffer const &buffer, uint32_t packets, bool checksum)
+{
+  T h;
+  if (checksum)
+    {
+      h.EnableChecksum ();
+    }
+
+  uint64_t start = NowNs ();
+  for (uint32_t p = 0; p < packets; p++)
+    {
+      NS_ABORT_MSG_UNLESS (h.Deserialize (buffer.Begin ()) == 20, "truncated header");
+      NS_ABORT_MSG_UNLESS (h.IsChecksumOk (), "bad checksum");
+      g_sink = g_sink + h.GetTtl ();
+    }
+  uint64_t elapsed = NowNs () - start;
+  return static_cast<double> (elapsed) / packets;
+}
+
+/**
+ * \brief Print the size and codec cost of Ipv4CodecHeader against Ipv4CompactHeader.
+ * \param packets number of calls per measurement
+ */
+void
+RunCompact (uint32_t packets)
+{
+  Ipv4CodecHeader header = MakeForwardedHeader (false);
+  Buffer buffer;
+  buffer.AddAtStart (header.GetSerializedSize ());
+  header.Serialize (buffer.Begin ());
+
+  Ipv4CompactHeader compact;
+  compact.EnableChecksum ();
+  NS_ABORT_MSG_UNLESS (compact.Deserialize (buffer.Begin ()) == 20, "truncated header");
+  Buffer compactBuffer;
+  compactBuffer.AddAtStart (compact.GetSerializedSize ());
+  compact.Serialize (compactBuffer.Begin ());
+  NS_ABORT_MSG_UNLESS (std::memcmp (buffer.PeekData (), compactBuffer.PeekData (), 20) == 0,
+                       "Ipv4CompactHeader does not serialize like Ipv4CodecHeader");
+
+  std::cout << std::fixed << std::setprecision (2)
+            << "IPv4 header storage and codec, " << packets << " packets\n"
+            << "                      bytes   serialize   deserialize   deserialize+checksum\n"
+            << "  Ipv4CodecHeader   " << std::setw (7) << sizeof (Ipv4CodecHeader)
+            << std::setw (9) << BenchSerialize (header, packets) << " ns"
+            << std::setw (11) << BenchDeserialize<Ipv4CodecHeader> (buffer, packets, false) << " ns"
+            << std::setw (20) << BenchDeserialize<Ipv4CodecHeader> (buffer, packets, true) << " ns\n"
+            << "  Ipv4CompactHeader " << std::setw (7) << sizeof (Ipv4CompactHeader)
+            << std::setw (9) << BenchSerialize (compact, packets) << " ns"
+            << std::setw (11) << BenchDeserialize<Ipv4CompactHeader> (buffer, packets, false) << " ns"
+            << std::setw (20) << BenchDeserialize<Ipv4CompactHeader> (buffer, packets, true) << " ns"
+            << std::endl;
+}
+
+/**
+ * \brief Call the Ipv4CodecHeader setters over and over.
+ * \param header the header to modify
+ * \param packets number of rounds of 6 setters
+ * \returns nanoseconds per setter call
+ */
+template <typename T>
+double
+BenchSetters (T &header, uint32_t packets)
+{
+  uint64_t start = NowNs ();
+  for (uint32_t p = 0; p < packets; p++)
+    {
+      header.SetTtl (p);
+      header.SetProtocol (p >> 8);
+      header.SetPayloadSize (p);
+      header.SetIdentification (p >> 16);
+      header.SetSource (Ipv4Address (p));
+      header.SetDestination (Ipv4Address (~p));
+    }
+  uint64_t elapsed = NowNs () - start;
+  return static_cast<double> (elapsed) / packets / 6;
+}
+
+/**
+ * \brief Call the Ipv4CodecHeader getters over and over.
+ * \param header the header to read
+ * \param packets number of rounds of 6 getters
+ * \returns nanoseconds per getter call
+ */
+template <typename T>
+double
+BenchGetters (T const &header, uint32_t packets)
+{
+  uint32_t sum = 0;
+  uint64_t start = NowNs ();
+  for (uint32_t p = 0; p < packets; p++)
+    {
+      sum += header.GetTtl ();
+      sum += header.GetProtocol ();
+      sum += header.GetPayloadSize ();
+      sum += header.GetIdentification ();
+      sum += header.GetSource ().Get ();
+      sum += header.GetDestination ().Get ();
+    }
+  uint64_t elapsed = NowNs () - start;
+  g_sink = g_sink + sum;
+  return static_cast<double> (elapsed) / packets / 6;
+}
+
+/**
+ * \brief Print the cost of one getter or setter call in this build.
+ *
+ * Run it from a logging build and from a hot-path build (see header-log.h)
+ * to compare the two.
+ *
+ * \param packets number of rounds of 6 calls
+ */
+void
+RunAccessors (uint32_t packets)
+{
+#ifdef NS3_LOG_ENABLE
+  char const *logging = "enabled";
+#else
+  char const *logging = "disabled";
+#endif
+#ifdef NS3_HEADER_HOT_PATH
+  char const *hotPath = "on";
+#else
+  char const *hotPath = "off";
+#endif
+
+  Ipv4CodecHeader header = MakeForwardedHeader (false);
+  Ipv4CompactHeader compact;
+
+  std::cout << std::fixed << std::setprecision (2)
+            << "header accessors, " << packets * 6 << " calls, logging " << logging
+            << ", hot path " << hotPath << "\n"
+            << "                       getter    setter\n"
+            << "  Ipv4CodecHeader   " << std::setw (9) << BenchGetters (header, packets) << " ns"
+            << std::setw (7) << BenchSetters (header, packets) << " ns\n"
+            << "  Ipv4CompactHeader " << std::setw (9) << BenchGetters (compact, packets) << " ns"
+            << std::setw (7) << BenchSetters (compact, packets) << " ns" << std::endl;
+}
+
+/**
+ * \brief Construct Ipv6CodecHeader objects, optionally deserializing into them.
+ *
+ * This is what every RemoveHeader of an Ipv6CodecHeader does.
+ *
+ * \param buffer a serialized IPv6 header, or an empty buffer to only construct
+ * \param packets number of headers
+ * \param parse true to also parse "::" twice per header, as the
+ *        constructor used to
+ * \returns headers per second
+ */
+double
+BenchIpv6Construct (Buffer const &buffer, uint32_t packets, bool parse)
+{
+  bool deserialize = buffer.GetSize () != 0;
+
+  uint64_t start = NowNs ();
+  for (uint32_t p = 0; p < packets; p++)
+    {
+      Ipv6CodecHeader h;
+      if (parse)
+        {
+          h.SetSourceAddress (Ipv6Address ("::"));
+          h.SetDestinationAddress (Ipv6Address ("::"));
+        }
+      if (deserialize)
+        {
+          NS_ABORT_MSG_UNLESS (h.Deserialize (buffer.Begin ()) == 40, "truncated header");
+        }
+      g_sink = g_sink + h.GetHopLimit ();
+    }
+  uint64_t elapsed = NowNs () - start;
+  return packets * 1e9 / elapsed;
+}
+
+/**
+ * \brief Print the Ipv6CodecHeader construction throughput with and without
+ *        parsing the unspecified address.
+ * \param packets number of headers per measurement
+ */
+void
+RunConstruct (uint32_t packets)
+{
+  NS_ABORT_MSG_UNLESS (Ipv6CodecHeader ().GetSourceAddress () == Ipv6Address ("::")
+                       && Ipv6CodecHeader ().GetDestinationAddress () == Ipv6Address ("::"),
+                       "Ipv6CodecHeader does not start with unspecified addresses");
+
+  Ipv6CodecHeader header;
+  header.SetPayloadLength (64);
+  header.SetNextHeader (Ipv6CodecHeader::IPV6_ICMPV6);
+  header.SetHopLimit (64);
+  header.SetSourceAddress (Ipv6Address ("2001:db8::1"));
+  header.SetDestinationAddress (Ipv6Address ("2001:db8::2"));
+  Buffer buffer;
+  buffer.AddAtStart (header.GetSerializedSize ());
+  header.Serialize (buffer.Begin ());
+  Buffer empty;
+
+  std::cout << std::fixed << std::setprecision (2)
+            << "Ipv6CodecHeader construction, " << packets << " headers, Mheaders/s\n"
+            << "                          parse \"::\"   no parsing\n"
+            << "  construct             " << std::setw (11) << BenchIpv6Construct (empty, packets, true) / 1e6
+            << std::setw (13) << BenchIpv6Construct (empty, packets, false) / 1e6 << "\n"
+            << "  construct + deserialize" << std::setw (10) << BenchIpv6Construct (buffer, packets, true) / 1e6
+            << std::setw (13) << BenchIpv6Construct (buffer, packets, false) / 1e6 << std::endl;
+}
+
+/// Headers decoded per Ipv4HeaderBatch / Ipv6HeaderBatch burst.
+const uint32_t BATCH_BURST = 256;
+
+/**
+ * \brief Statistics gathered over a header trace.
+ */
+struct TraceStats
+{
+  uint64_t bytes;          //!< sum of the lengths of the valid headers
+  uint64_t hops;           //!< sum of the TTLs or hop limits of the valid headers
+  uint32_t protocols[256]; //!< valid headers per protocol
+  uint32_t errors;         //!< invalid headers
+};
+
+/**
+ * \brief Gather TraceStats over IPv4 headers, one Ipv4CodecHeader at a time or
+ *        with Ipv4HeaderBatch.
+ * \param trace back-to-back 20-byte IPv4 headers
+ * \param count number of headers
+ * \param batch use Ipv4HeaderBatch
+ * \param stats receives the statistics
+ * \returns nanoseconds per header
+ */
+double
+BenchIpv4Stats (Buffer const &trace, uint32_t count, bool batch, TraceStats &stats)
+{
+  stats = TraceStats ();
+  uint64_t start = NowNs ();
+  if (batch)
+    {
+      Ipv4HeaderBatch decoder;
+      uint8_t const *data = trace.PeekData ();
+      for (uint32_t first = 0; first < count; first += BATCH_BURST)
+        {
+          uint32_t n = std::min (BATCH_BURST, count - first);
+          stats.errors += n - decoder.Decode (data + first * 20, n, 20);
+          std::vector<uint16_t> const &length = decoder.GetLengths ();
+          std::vector<uint8_t> const &ttl = decoder.GetTtls ();
+          std::vector<uint8_t> const &protocol = decoder.GetProtocols ();
+          std::vector<uint8_t> const &error = decoder.GetErrors ();
+          for (uint32_t k = 0; k < n; k++)
+            {
+              // invalid headers have zero fields, only the protocol count needs the flag
+              stats.bytes += length[k];
+              stats.hops += ttl[k];
+              stats.protocols[protocol[k]] += error[k] == 0;
+            }
+        }
+    }
+  else
+    {
+      Buffer::Iterator i = trace.Begin ();
+      for (uint32_t k = 0; k < count; k++, i.Next (20))
+        {
+          Ipv4CodecHeader h;
+          if (h.Deserialize (i) == 0)
+            {
+              stats.errors++;
+              continue;
+            }
+          stats.bytes += h.GetPayloadSize () + h.GetSerializedSize ();
+          stats.hops += h.GetTtl ();
+          stats.protocols[h.GetProtocol ()]++;
+        }
+    }
+  uint64_t elapsed = NowNs () - start;
+  return static_cast<double> (elapsed) / count;
+}
+
+/**
+ * \brief Gather TraceStats over IPv6 headers, one Ipv6CodecHeader at a time or
+ *        with Ipv6HeaderBatch.
+ * \param trace back-to-back 40-byte IPv6 headers
+ * \param count number of headers
+ * \param batch use Ipv6HeaderBatch
+ * \param stats receives the statistics
+ * \returns nanoseconds per header
+ */
+double
+BenchIpv6Stats (Buffer const &trace, uint32_t count, bool batch, TraceStats &stats)
+{
+  stats = TraceStats ();
+  uint64_t start = NowNs ();
+  if (batch)
+    {
+      Ipv6HeaderBatch decoder;
+      uint8_t const *data = trace.PeekData ();
+      for (uint32_t first = 0; first < count; first += BATCH_BURST)
+        {
+          uint32_t n = std::min (BATCH_BURST, count - first);
+          stats.errors += n - decoder.Decode (data + first * 40, n, 40);
+          std::vector<uint16_t> const &length = decoder.GetLengths ();
+          std::vector<uint8_t> const &hopLimit = decoder.GetHopLimits ();
+          std::vector<uint8_t> const &nextHeader = decoder.GetNextHeaders ();
+          std::vector<uint8_t> const &error = decoder.GetErrors ();
+          for (uint32_t k = 0; k < n; k++)
+            {
+              stats.bytes += length[k];
+              stats.hops += hopLimit[k];
+              stats.protocols[nextHeader[k]] += error[k] == 0;
+            }
+        }
+    }
+  else
+    {
+      Buffer::Iterator i = trace.Begin ();
+      for (uint32_t k = 0; k < count; k++, i.Next (40))
+        {
+          Ipv6CodecHeader h;
+          if (h.Deserialize (i) == 0)
+            {
+              stats.errors++;
+              continue;
+            }
+          stats.bytes += h.GetPayloadLength ();
+          stats.hops += h.GetHopLimit ();
+          stats.protocols[h.GetNextHeader ()]++;
+        }
+    }
+  uint64_t elapsed = NowNs () - start;
+  return static_cast<double> (elapsed) / count;
+}
+
+/**
+ * \brief Break the version of one header in every 97.
+ * \param trace back-to-back headers
+ * \param count number of headers
+ * \param size size of each header
+ * \returns a copy of the trace with broken headers
+ */
+Buffer
+CorruptTrace (Buffer const &trace, uint32_t count, uint32_t size)
+{
+  std::vector<uint8_t> bytes (trace.PeekData (), trace.PeekData () + count * size);
+  for (uint32_t k = 0; k < count; k += 97)
+    {
+      bytes[k * size] ^= 0x20;
+    }
+  Buffer corrupted;
+  corrupted.AddAtStart (bytes.size ());
+  corrupted.Begin ().Write (bytes.data (), bytes.size ());
+  return corrupted;
+}
+
+/**
+ * \brief Print the cost of per-protocol statistics over a trace, per-object
+ *        Deserialize versus batched column decode.
+ * \param packets number of headers per family
+ */
+void
+RunBatch (uint32_t packets)
+{
+  Buffer v4;
+  Buffer v6;
+  MakeHeaderTrace (packets, v4, v6);
+  v4 = CorruptTrace (v4, packets, 20);
+  v6 = CorruptTrace (v6, packets, 40);
+
+  TraceStats object;
+  TraceStats batch;
+  double v4Object = BenchIpv4Stats (v4, packets, false, object);
+  double v4Batch = BenchIpv4Stats (v4, packets, true, batch);
+  NS_ABORT_MSG_UNLESS (std::memcmp (&object, &batch, sizeof (object)) == 0
+                       && object.errors == (packets + 96) / 97,
+                       "Ipv4HeaderBatch disagrees with Ipv4CodecHeader");
+  double v6Object = BenchIpv6Stats (v6, packets, false, object);
+  double v6Batch = BenchIpv6Stats (v6, packets, true, batch);
+  NS_ABORT_MSG_UNLESS (std::memcmp (&object, &batch, sizeof (object)) == 0
+                       && object.errors == (packets + 96) / 97,
+                       "Ipv6HeaderBatch disagrees with Ipv6CodecHeader");
+
+  std::cout << std::fixed << std::setprecision (2)
+            << "trace statistics, " << packets << " headers per family, 1 in 97 invalid, "
+            << BATCH_BURST << "-header bursts\n"
+            << "         Deserialize        batch\n"
+            << "  IPv4" << std::setw (12) << v4Object << " ns" << std::setw (10) << v4Batch << " ns"
+            << std::setw (8) << v4Object / v4Batch << "x\n"
+            << "  IPv6" << std::setw (12) << v6Object << " ns" << std::setw (10) << v6Batch << " ns"
+            << std::setw (8) << v6Object / v6Batch << "x" << std::endl;
+}
+
+/// Number of distinct random headers the codec suite cycles through, a power of 2.
+const uint32_t CODEC_POOL = 1024;
+
+/// The DiffServ codepoints defined by Ipv4CodecHeader::DscpType and Ipv6CodecHeader::DscpType.
+const uint8_t CODEC_DSCP[] = { 0x00, 0x08, 0x0A, 0x0C, 0x0E, 0x10, 0x12, 0x14, 0x16, 0x18, 0x1A,
+                               0x1C, 0x1E, 0x20, 0x22, 0x24, 0x26, 0x28, 0x2E, 0x30, 0x38 };
+
+/**
+ * \brief Headers with random fields, and their serialized form.
+ */
+struct CodecPool
+{
+  std::vector<Ipv4CodecHeader> v4;         //!< IPv4 headers, checksum disabled
+  std::vector<Ipv4CodecHeader> v4Checksum; //!< the same headers, checksum enabled
+  std::vector<Ipv6CodecHeader> v6;         //!< IPv6 headers
+  Buffer v4Bytes;                     //!< v4 serialized back-to-back, with checksums
+  Buffer v6Bytes;                     //!< v6 serialized back-to-back
+};
+
+/**
+ * \brief Fill a CodecPool from a seeded generator.
+ *
+ * Only raw std::mt19937 output is used, its sequence is fixed by the
+ * standard, so a seed gives the same headers on every platform.
+ *
+ * \param seed the generator seed
+ * \param pool the pool to fill
+ */
+void
+MakeCodecPool (uint32_t seed, CodecPool &pool)
+{
+  std::mt19937 rng (seed);
+  pool.v4Bytes.AddAtStart (CODEC_POOL * 20);
+  pool.v6Bytes.AddAtStart (CODEC_POOL * 40);
+  Buffer::Iterator i4 = pool.v4Bytes.Begin ();
+  Buffer::Iterator i6 = pool.v6Bytes.Begin ();
+  for (uint32_t k = 0; k < CODEC_POOL; k++)
+    {
+      uint32_t r = rng ();
+      Ipv4CodecHeader h4;
+      h4.SetDscp (Ipv4CodecHeader::DscpType (CODEC_DSCP[r % sizeof (CODEC_DSCP)]));
+      h4.SetEcn (Ipv4CodecHeader::EcnType ((r >> 8) & 0x3));
+      h4.SetTtl (r >> 16);
+      h4.SetProtocol (r >> 24);
+      r = rng ();
+      h4.SetPayloadSize (r % 1481);
+      h4.SetIdentification (r >> 16);
+      if (r & 0x800)
+        {
+          h4.SetDontFragment ();
+        }
+      h4.SetSource (Ipv4Address (rng ()));
+      h4.SetDestination (Ipv4Address (rng ()));
+      pool.v4.push_back (h4);
+      h4.EnableChecksum ();
+      pool.v4Checksum.push_back (h4);
+      h4.Serialize (i4);
+      i4.Next (20);
+
+      r = rng ();
+      Ipv6CodecHeader h6;
+      h6.SetDscp (Ipv6CodecHeader::DscpType (CODEC_DSCP[r % sizeof (CODEC_DSCP)]));
+      h6.SetEcn (Ipv6CodecHeader::EcnType ((r >> 8) & 0x3));
+      h6.SetHopLimit (r >> 16);
+      h6.SetNextHeader (r >> 24);
+      r = rng ();
+      h6.SetPayloadLength (r % 1461);
+      h6.SetFlowLabel (rng () & 0xfffff);
+      uint8_t address[16];
+      for (uint32_t b = 0; b < 16; b++)
+        {
+          address[b] = rng ();
+        }
+      h6.SetSourceAddress (Ipv6Address (address));
+      for (uint32_t b = 0; b < 16; b++)
+        {
+          address[b] = rng ();
+        }
+      h6.SetDestinationAddress (Ipv6Address (address));
+      pool.v6.push_back (h6);
+      h6.Serialize (i6);
+      i6.Next (40);
+    }
+}
+
+/**
+ * \brief One measurement of the codec suite.
+ */
+struct CodecResult
+{
+  std::string name; //!< operation name, family/operation
+  double nsPerOp;   //!< nanoseconds per operation
+};
+
+/**
+ * \brief Time an operation after a warm-up.
+ * \param name the operation name
+ * \param warmup number of untimed calls
+ * \param packets number of timed calls
+ * \param op the operation, called with the call number
+ * \returns the measurement
+ */
+template <typename F>
+CodecResult
+MeasureCodec (std::string const &name, uint32_t warmup, uint32_t packets, F op)
+{
+  for (uint32_t k = 0; k < warmup; k++)
+    {
+      op (k);
+    }
+  uint64_t start = NowNs ();
+  for (uint32_t k = 0; k < packets; k++)
+    {
+      op (k);
+    }
+  uint64_t elapsed = NowNs () - start;
+  CodecResult result;
+  result.name = name;
+  result.nsPerOp = static_cast<double> (elapsed) / packets;
+  return result;
+}
+
+/**
+ * \brief Measure every Ipv4CodecHeader and Ipv6CodecHeader operation.
+ * \param pool the headers to cycle through
+ * \param warmup number of untimed calls per operation
+ * \param packets number of timed calls per operation
+ * \returns the measurements
+ */
+std::vector<CodecResult>
+BenchCodec (CodecPool const &pool, uint32_t warmup, uint32_t packets)
+{
+  const uint32_t mask = CODEC_POOL - 1;
+  std::vector<CodecResult> results;
+  Buffer out;
+  out.AddAtStart (60);
+  std::ostringstream os;
+
+  results.push_back (MeasureCodec ("ipv4/construct", warmup, packets, [&] (uint32_t k) {
+    Ipv4CodecHeader h;
+    g_sink = g_sink + h.GetTtl () + k;
+  }));
+  results.push_back (MeasureCodec ("ipv4/serialize", warmup, packets, [&] (uint32_t k) {
+    pool.v4[k & mask].Serialize (out.Begin ());
+    g_sink = g_sink + *out.PeekData ();
+  }));
+  results.push_back (MeasureCodec ("ipv4/serialize+checksum", warmup, packets, [&] (uint32_t k) {
+    pool.v4Checksum[k & mask].Serialize (out.Begin ());
+    g_sink = g_sink + *out.PeekData ();
+  }));
+  results.push_back (MeasureCodec ("ipv4/deserialize", warmup, packets, [&] (uint32_t k) {
+    Buffer::Iterator i = pool.v4Bytes.Begin ();
+    i.Next ((k & mask) * 20);
+    Ipv4CodecHeader h;
+    g_sink = g_sink + h.Deserialize (i);
+  }));
+  results.push_back (MeasureCodec ("ipv4/deserialize+checksum", warmup, packets, [&] (uint32_t k) {
+    Buffer::Iterator i = pool.v4Bytes.Begin ();
+    i.Next ((k & mask) * 20);
+    Ipv4CodecHeader h;
+    h.EnableChecksum ();
+    g_sink = g_sink + h.Deserialize (i);
+    NS_ABORT_MSG_UNLESS (h.IsChecksumOk (), "bad checksum in the codec pool");
+  }));
+  results.push_back (MeasureCodec ("ipv4/print", warmup, packets, [&] (uint32_t k) {
+    os.str ("");
+    pool.v4[k & mask].Print (os);
+    g_sink = g_sink + os.tellp ();
+  }));
+  results.push_back (MeasureCodec ("ipv4/dscp-to-string", warmup, packets, [&] (uint32_t k) {
+    Ipv4CodecHeader const &h = pool.v4[k & mask];
+    g_sink = g_sink + h.DscpTypeToString (h.GetDscp ()).size ();
+  }));
+  results.push_back (MeasureCodec ("ipv4/ecn-to-string", warmup, packets, [&] (uint32_t k) {
+    Ipv4CodecHeader const &h = pool.v4[k & mask];
+    g_sink = g_sink + h.EcnTypeToString (h.GetEcn ()).size ();
+  }));
+
+  results.push_back (MeasureCodec ("ipv6/construct", warmup, packets, [&] (uint32_t k) {
+    Ipv6CodecHeader h;
+    g_sink = g_sink + h.GetHopLimit () + k;
+  }));
+  results.push_back (MeasureCodec ("ipv6/serialize", warmup, packets, [&] (uint32_t k) {
+    pool.v6[k & mask].Serialize (out.Begin ());
+    g_sink = g_sink + *out.PeekData ();
+  }));
+  results.push_back (MeasureCodec ("ipv6/deserialize", warmup, packets, [&] (uint32_t k) {
+    Buffer::Iterator i = pool.v6Bytes.Begin ();
+    i.Next ((k & mask) * 40);
+    Ipv6CodecHeader h;
+    g_sink = g_sink + h.Deserialize (i);
+  }));
+  results.push_back (MeasureCodec ("ipv6/print", warmup, packets, [&] (uint32_t k) {
+    os.str ("");
+    pool.v6[k & mask].Print (os);
+    g_sink = g_sink + os.tellp ();
+  }));
+  results.push_back (MeasureCodec ("ipv6/dscp-to-string", warmup, packets, [&] (uint32_t k) {
+    Ipv6CodecHeader const &h = pool.v6[k & mask];
+    g_sink = g_sink + h.DscpTypeToString (h.GetDscp ()).size ();
+  }));
+  results.push_back (MeasureCodec ("ipv6/ecn-to-string", warmup, packets, [&] (uint32_t k) {
+    Ipv6CodecHeader const &h = pool.v6[k & mask];
+    g_sink = g_sink + h.EcnTypeToString (h.GetEcn ()).size ();
+  }));
+  return results;
+}
+
+/**
+ * \brief Run the codec suite, print a table and optionally write JSON.
+ * \param packets number of timed calls per operation
+ * \param warmup number of untimed calls per operation
+ * \param seed seed of the random header fields
+ * \param json file receiving the results as JSON, none if empty
+ */
+void
+RunCodec (uint32_t packets, uint32_t warmup, uint32_t seed, std::string const &json)
+{
+  CodecPool pool;
+  MakeCodecPool (seed, pool);
+  std::vector<CodecResult> results = BenchCodec (pool, warmup, packets);
+
+  std::cout << std::fixed << std::setprecision (2)
+            << "header codec suite, seed " << seed << ", " << packets << " calls after "
+            << warmup << " warm-up calls\n"
+            << "  operation                       ns/op      Mpps\n";
+  for (std::vector<CodecResult>::const_iterator r = results.begin (); r != results.end (); r++)
+    {
+      std::cout << "  " << std::left << std::setw (28) << r->name << std::right
+                << std::setw (8) << r->nsPerOp << std::setw (10) << 1e3 / r->nsPerOp << "\n";
+    }
+  std::cout << std::flush;
+
+  if (json.empty ())
+    {
+      return;
+    }
+  std::ofstream file (json.c_str ());
+  NS_ABORT_MSG_UNLESS (file, "cannot open " << json);
+  file << std::setprecision (3) << std::fixed
+       << "{\n"
+       << "  \"benchmark\": \"header-codec\",\n"
+       << "  \"seed\": " << seed << ",\n"
+       << "  \"packets\": " << packets << ",\n"
+       << "  \"warmup\": " << warmup << ",\n"
+       << "  \"results\": [\n";
+  for (std::vector<CodecResult>::const_iterator r = results.begin (); r != results.end (); r++)
+    {
+      file << "    { \"name\": \"" << r->name << "\", \"ns_per_op\": " << r->nsPerOp
+           << ", \"packets_per_sec\": " << 1e9 / r->nsPerOp << " }"
+           << (r + 1 != results.end () ? ",\n" : "\n");
+    }
+  file << "  ]\n"
+       << "}\n";
+}
+
+/**
+ * \brief Stream buffer that only counts the bytes written to it.
+ */
+class CountingStreamBuf : public std::streambuf
+{
+public:
+  CountingStreamBuf ()
+    : m_bytes (0)
+  {
+  }
+  /// \returns the number of bytes written
+  uint64_t GetBytes (void) const
+  {
+    return m_bytes;
+  }
+protected:
+  virtual int overflow (int c)
+  {
+    m_bytes++;
+    return c;
+  }
+  virtual std::streamsize xsputn (char const *, std::streamsize n)
+  {
+    m_bytes += n;
+    return n;
+  }
+private:
+  uint64_t m_bytes; //!< bytes written
+};
+
+/**
+ * \brief Dump a trace of alternating IPv4 and IPv6 headers, as text or binary.
+ * \param pool the headers to cycle through
+ * \param packets number of headers to dump
+ * \param binary use HeaderTraceWriter instead of Print
+ * \param os the stream receiving the trace
+ * \returns nanoseconds per header
+ */
+double
+BenchDump (CodecPool const &pool, uint32_t packets, bool binary, std::ostream &os)
+{
+  const uint32_t mask = CODEC_POOL - 1;
+  uint64_t start = NowNs ();
+  if (binary)
+    {
+      HeaderTraceWriter writer (os);
+      for (uint32_t k = 0; k < packets; k++)
+        {
+          if (k & 1)
+            {
+              writer.Write (pool.v6[(k >> 1) & mask]);
+            }
+          else
+            {
+              writer.Write (pool.v4[(k >> 1) & mask]);
+            }
+        }
+    }
+  else
+    {
+      for (uint32_t k = 0; k < packets; k++)
+        {
+          if (k & 1)
+            {
+              pool.v6[(k >> 1) & mask].Print (os);
+            }
+          else
+            {
+              pool.v4[(k >> 1) & mask].Print (os);
+            }
+          os << '\n';
+        }
+    }
+  uint64_t elapsed = NowNs () - start;
+  return static_cast<double> (elapsed) / packets;
+}
+
+/**
+ * \brief Print the cost and size of a text dump against a binary dump.
+ * \param packets number of headers dumped
+ * \param seed seed of the random header fields
+ */
+void
+RunDump (uint32_t packets, uint32_t seed)
+{
+  CodecPool pool;
+  MakeCodecPool (seed, pool);
+
+  // a binary trace decodes back to the text dump
+  std::ostringstream text;
+  BenchDump (pool, 2 * CODEC_POOL, false, text);
+  std::stringstream binary;
+  BenchDump (pool, 2 * CODEC_POOL, true, binary);
+  std::ostringstream decoded;
+  HeaderTraceReader reader (binary);
+  while (reader.Next ())
+    {
+      reader.Print (decoded);
+      decoded << '\n';
+    }
+  NS_ABORT_MSG_UNLESS (decoded.str () == text.str (), "binary trace does not decode to the text trace");
+
+  CountingStreamBuf textBuf;
+  std::ostream textStream (&textBuf);
+  double textNs = BenchDump (pool, packets, false, textStream);
+  CountingStreamBuf binaryBuf;
+  std::ostream binaryStream (&binaryBuf);
+  double binaryNs = BenchDump (pool, packets, true, binaryStream);
+
+  std::cout << std::fixed << std::setprecision (2)
+            << "trace dump, " << packets << " headers, IPv4 and IPv6 alternating\n"
+            << "           ns/header   bytes/header\n"
+            << "  Print  " << std::setw (12) << textNs
+            << std::setw (15) << static_cast<double> (textBuf.GetBytes ()) / packets << "\n"
+            << "  binary " << std::setw (12) << binaryNs
+            << std::setw (15) << static_cast<double> (binaryBuf.GetBytes ()) / packets << std::endl;
+}
+
+/// Distance between two headers of the ingress trace, the largest IPv4 header.
+const uint32_t INGRESS_STRIDE = 60;
+
+/**
+ * \brief Headers arriving at an ingress filter, valid or not.
+ */
+struct IngressTrace
+{
+  Buffer v4;                          //!< IPv4 headers, INGRESS_STRIDE bytes apart
+  Buffer v6;                          //!< IPv6 headers, INGRESS_STRIDE bytes apart
+  std::vector<uint32_t> v4PacketSize; //!< size of the packet carrying each IPv4 header
+  std::vector<uint32_t> v6PacketSize; //!< size of the packet carrying each IPv6 header
+};
+
+/**
+ * \brief Build mixed ingress traffic.
+ *
+ * About 60% of the headers are valid. The rest have, in equal shares, a
+ * bad checksum, a bad version, an IHL below 5 or a length longer than
+ * their packet (IPv6 only gets the last two). One valid IPv4 header in
+ * eight carries a Router Alert option.
+ *
+ * \param count number of headers per family
+ * \param seed the generator seed
+ * \param trace the trace to fill
+ */
+void
+MakeIngressTrace (uint32_t count, uint32_t seed, IngressTrace &trace)
+{
+  std::mt19937 rng (seed);
+  trace.v4.AddAtStart (count * INGRESS_STRIDE);
+  trace.v6.AddAtStart (count * INGRESS_STRIDE);
+  trace.v4PacketSize.resize (count);
+  trace.v6PacketSize.resize (count);
+  Buffer::Iterator i4 = trace.v4.Begin ();
+  Buffer::Iterator i6 = trace.v6.Begin ();
+  for (uint32_t k = 0; k < count; k++, i4.Next (INGRESS_STRIDE), i6.Next (INGRESS_STRIDE))
+    {
+      uint32_t r = rng ();
+      uint32_t payload = 8 + r % 1400;
+      uint32_t kind = (r >> 16) % 10;
+
+      Ipv4CodecHeader h4;
+      h4.EnableChecksum ();
+      h4.SetPayloadSize (payload);
+      h4.SetTtl (64);
+      h4.SetProtocol (1);
+      h4.SetSource (Ipv4Address (rng ()));
+      h4.SetDestination (Ipv4Address (rng ()));
+      if ((r >> 8) % 8 == 0)
+        {
+          h4.AddRouterAlertOption ();
+        }
+      h4.Serialize (i4);
+      uint32_t v4PacketSize = payload + h4.GetSerializedSize ();
+
+      Ipv6CodecHeader h6;
+      h6.SetPayloadLength (payload);
+      h6.SetNextHeader (Ipv6CodecHeader::IPV6_ICMPV6);
+      h6.SetHopLimit (64);
+      h6.Serialize (i6);
+      uint32_t v6PacketSize = payload + h6.GetSerializedSize ();
+
+      // corrupt the serialized bytes, as a broken sender would
+      uint8_t *b4 = const_cast<uint8_t *> (trace.v4.PeekData ()) + k * INGRESS_STRIDE;
+      uint8_t *b6 = const_cast<uint8_t *> (trace.v6.PeekData ()) + k * INGRESS_STRIDE;
+      switch (kind)
+        {
+        case 6:
+          b4[8] ^= 0x01; // TTL changed, checksum not updated
+          b6[0] ^= 0x20;
+          break;
+        case 7:
+          b4[0] ^= 0x20;
+          b6[0] ^= 0x20;
+          break;
+        case 8:
+          b4[0] = 0x43;
+          v6PacketSize -= 8;
+          break;
+        case 9:
+          v4PacketSize -= 8;
+          v6PacketSize -= 8;
+          break;
+        default:
+          break;
+        }
+      trace.v4PacketSize[k] = v4PacketSize;
+      trace.v6PacketSize[k] = v6PacketSize;
+    }
+}
+
+/**
+ * \brief Count the headers an ingress filter accepts.
+ * \param trace the headers
+ * \param v6 filter the IPv6 headers instead of the IPv4 ones
+ * \param validate use Validate instead of Deserialize with checksum
+ * \param reasons if validate, receives the number of headers per ValidationResult
+ * \param accepted receives the number of accepted headers
+ * \returns nanoseconds per header
+ */
+double
+BenchIngress (IngressTrace const &trace, bool v6, bool validate,
+              std::vector<uint32_t> &reasons, uint32_t &accepted)
+{
+  std::vector<uint32_t> const &packetSizes = v6 ? trace.v6PacketSize : trace.v4PacketSize;
+  uint32_t count = packetSizes.size ();
+  accepted = 0;
+  reasons.assign (8, 0);
+  uint64_t start = NowNs ();
+  if (validate)
+    {
+      uint8_t const *data = v6 ? trace.v6.PeekData () : trace.v4.PeekData ();
+      for (uint32_t k = 0; k < count; k++)
+        {
+          uint32_t packetSize = packetSizes[k];
+          uint32_t size = std::min (INGRESS_STRIDE, packetSize);
+          if (v6)
+            {
+              reasons[Ipv6CodecHeader::Validate (data + k * INGRESS_STRIDE, size, packetSize)]++;
+            }
+          else
+            {
+              reasons[Ipv4CodecHeader::Validate (data + k * INGRESS_STRIDE, size, packetSize)]++;
+            }
+        }
+      accepted = reasons[0];
+    }
+  else
+    {
+      Buffer::Iterator i = v6 ? trace.v6.Begin () : trace.v4.Begin ();
+      for (uint32_t k = 0; k < count; k++, i.Next (INGRESS_STRIDE))
+        {
+          uint32_t packetSize = packetSizes[k];
+          if (v6)
+            {
+              Ipv6CodecHeader h;
+              uint32_t n = h.Deserialize (i);
+              accepted += n != 0 && n + h.GetPayloadLength () <= packetSize;
+            }
+          else
+            {
+              Ipv4CodecHeader h;
+              h.EnableChecksum ();
+              uint32_t n = h.Deserialize (i);
+              accepted += n != 0 && n + h.GetPayloadSize () <= packetSize && h.IsChecksumOk ();
+            }
+        }
+    }
+  uint64_t elapsed = NowNs () - start;
+  return static_cast<double> (elapsed) / count;
+}
+
+/**
+ * \brief Print the cost of an ingress filter, Deserialize versus Validate.
+ * \param packets number of headers per family
+ * \param seed seed of the traffic mix
+ */
+void
+RunValidate (uint32_t packets, uint32_t seed)
+{
+  IngressTrace trace;
+  MakeIngressTrace (packets, seed, trace);
+
+  std::cout << std::fixed << std::setprecision (2)
+            << "ingress filter, " << packets << " headers per family, ~60% valid\n"
+            << "         Deserialize     Validate   accepted\n";
+  for (uint32_t family = 0; family < 2; family++)
+    {
+      bool v6 = family == 1;
+      std::vector<uint32_t> reasons;
+      uint32_t deserializeAccepted;
+      uint32_t validateAccepted;
+      double deserializeNs = BenchIngress (trace, v6, false, reasons, deserializeAccepted);
+      double validateNs = BenchIngress (trace, v6, true, reasons, validateAccepted);
+      NS_ABORT_MSG_UNLESS (deserializeAccepted == validateAccepted,
+                           "Validate and Deserialize disagree");
+      std::cout << (v6 ? "  IPv6" : "  IPv4") << std::setw (12) << deserializeNs << " ns"
+                << std::setw (10) << validateNs << " ns" << std::setw (11) << validateAccepted << "\n"
+                << "    rejected:";
+      for (uint32_t r = 1; r < reasons.size (); r++)
+        {
+          if (reasons[r] != 0)
+            {
+              std::cout << " " << (v6 ? Ipv6CodecHeader::GetValidationName (Ipv6CodecHeader::ValidationResult (r))
+                                   : Ipv4CodecHeader::GetValidationName (Ipv4CodecHeader::ValidationResult (r)))
+                        << " " << reasons[r];
+            }
+        }
+      std::cout << "\n";
+    }
+  std::cout << std::flush;
+}
+
+/// Distance between two packets of the flow trace.
+const uint32_t FLOW_STRIDE = 64;
+/// Number of distinct flows in the flow trace.
+const uint32_t FLOW_COUNT = 4096;
+/// Number of ECMP next hops the hashes are spread over.
+const uint32_t FLOW_PATHS = 16;
+
+/**
+ * \brief Build a trace of packet heads drawn from FLOW_COUNT flows.
+ *
+ * Each flow is one of: IPv4 TCP, UDP or ICMP echo, IPv6 UDP with a flow
+ * label, ICMPv6 echo, or TCP behind a Hop-by-Hop header. One IPv4 packet
+ * in eight is a non-first fragment. The echo sequence numbers grow along
+ * the trace.
+ *
+ * \param count number of packets
+ * \param seed the generator seed
+ * \param trace receives the packets, FLOW_STRIDE bytes apart
+ */
+void
+MakeFlowTrace (uint32_t count, uint32_t seed, Buffer &trace)
+{
+  std::mt19937 rng (seed);
+  std::vector<uint32_t> flows (FLOW_COUNT * 4);
+  for (uint32_t f = 0; f < flows.size (); f++)
+    {
+      flows[f] = rng ();
+    }
+  trace.AddAtStart (count * FLOW_STRIDE);
+  uint8_t *bytes = const_cast<uint8_t *> (trace.PeekData ());
+  Buffer::Iterator i = trace.Begin ();
+  for (uint32_t k = 0; k < count; k++, i.Next (FLOW_STRIDE))
+    {
+      uint32_t f = rng () % FLOW_COUNT;
+      uint32_t const *flow = &flows[f * 4];
+      uint32_t kind = flow[0] % 6;
+      uint8_t *l4 = bytes + k * FLOW_STRIDE;
+      uint8_t protocol = kind == 0 || kind == 5 ? 6 : kind == 2 ? 1 : kind == 4 ? 58 : 17;
+      if (kind < 3)
+        {
+          Ipv4CodecHeader h;
+          h.SetPayloadSize (1000);
+          h.SetTtl (64);
+          h.SetProtocol (protocol);
+          h.SetIdentification (k);
+          h.SetSource (Ipv4Address (flow[1]));
+          h.SetDestination (Ipv4Address (flow[2]));
+          if (k % 8 == 7)
+            {
+              h.SetFragmentOffset (1480);
+            }
+          h.Serialize (i);
+          l4 += 20;
+        }
+      else
+        {
+          uint8_t address[16];
+          Ipv6CodecHeader h;
+          h.SetPayloadLength (1000);
+          h.SetHopLimit (64);
+          h.SetFlowLabel (kind == 3 ? flow[3] & 0xfffff : 0);
+          h.SetNextHeader (kind == 5 ? 0 : protocol);
+          for (uint32_t b = 0; b < 16; b++)
+            {
+              address[b] = flow[1 + b / 8] >> (b % 4 * 8);
+            }
+          h.SetSourceAddress (Ipv6Address (address));
+          address[15] ^= 1;
+          h.SetDestinationAddress (Ipv6Address (address));
+          h.Serialize (i);
+          l4 += 40;
+          if (kind == 5)
+            {
+              // Hop-by-Hop header padded to 8 bytes with a PadN option
+              uint8_t hopByHop[8] = { protocol, 0, 1, 4, 0, 0, 0, 0 };
+              std::memcpy (l4, hopByHop, 8);
+              l4 += 8;
+            }
+        }
+      if (protocol == 1 || protocol == 58)
+        {
+          l4[0] = protocol == 1 ? 8 : 128;
+          l4[4] = flow[3] >> 8;
+          l4[5] = flow[3];
+          l4[6] = k >> 8;
+          l4[7] = k;
+        }
+      else
+        {
+          l4[0] = flow[3] >> 24;
+          l4[1] = flow[3] >> 16;
+          l4[2] = flow[3] >> 8;
+          l4[3] = flow[3];
+        }
+    }
+}
+
+/**
+ * \brief Build a flow key by hand from the deserialized header objects.
+ * \param i the start of the packet
+ * \param size number of packet bytes at i
+ * \param key receives the key
+ */
+void
+ExtractFlowKeyByHand (Buffer::Iterator i, uint32_t size, IpFlowKey &key)
+{
+  std::memset (&key, 0, sizeof (key));
+  Buffer::Iterator l4 = i;
+  uint32_t available;
+  uint8_t first = i.PeekU8 ();
+  key.version = first >> 4;
+  if (key.version == 4)
+    {
+      Ipv4CodecHeader h;
+      uint32_t n = h.Deserialize (i);
+      h.GetSource ().Serialize (key.source);
+      h.GetDestination ().Serialize (key.destination);
+      key.protocol = h.GetProtocol ();
+      if (!h.IsLastFragment () || h.GetFragmentOffset () != 0)
+        {
+          return;
+        }
+      l4.Next (n);
+      available = size - n;
+    }
+  else
+    {
+      Ipv6CodecHeader h;
+      uint32_t n = h.Deserialize (i);
+      h.GetSourceAddress ().Serialize (key.source);
+      h.GetDestinationAddress ().Serialize (key.destination);
+      key.flowLabel = h.GetFlowLabel ();
+      key.protocol = h.GetNextHeader ();
+      if (Ipv6ExtensionChain::IsExtension (key.protocol))
+        {
+          uint8_t bytes[FLOW_STRIDE];
+          i.Read (bytes, size);
+          Ipv6ExtensionChain chain;
+          chain.Walk (bytes, size);
+          key.protocol = chain.GetProtocol ();
+          n = chain.GetUpperLayerOffset ();
+        }
+      l4.Next (n);
+      available = size - n;
+    }
+  if ((key.protocol == 6 || key.protocol == 17) && available >= 4)
+    {
+      key.sourcePort = l4.ReadNtohU16 ();
+      key.destinationPort = l4.ReadNtohU16 ();
+    }
+  else if ((key.protocol == 1 || key.protocol == 58) && available >= 8)
+    {
+      uint8_t type = l4.ReadU8 ();
+      if (type == 8 || type == 128)
+        {
+          l4.Next (3);
+          key.sourcePort = l4.ReadNtohU16 ();
+          key.sequence = l4.ReadNtohU16 ();
+        }
+    }
+}
+
+/**
+ * \brief Key and hash every packet of the flow trace.
+ * \param trace the packets
+ * \param count number of packets
+ * \param method 0: Deserialize and getters, 1: Extract, 2: Extract and batch Hash
+ * \param hashes receives the hash of each packet
+ * \returns nanoseconds per packet
+ */
+double
+BenchFlowKeys (Buffer const &trace, uint32_t count, uint32_t method, std::vector<uint32_t> &hashes)
+{
+  hashes.resize (count);
+  uint8_t const *data = trace.PeekData ();
+  IpFlowKey keys[BATCH_BURST];
+  uint64_t start = NowNs ();
+  if (method == 0)
+    {
+      Buffer::Iterator i = trace.Begin ();
+      for (uint32_t k = 0; k < count; k++, i.Next (FLOW_STRIDE))
+        {
+          ExtractFlowKeyByHand (i, FLOW_STRIDE, keys[0]);
+          hashes[k] = IpFlowKey::Hash (keys[0]);
+        }
+    }
+  else if (method == 1)
+    {
+      for (uint32_t k = 0; k < count; k++)
+        {
+          IpFlowKey::Extract (data + k * FLOW_STRIDE, FLOW_STRIDE, keys[0]);
+          hashes[k] = IpFlowKey::Hash (keys[0]);
+        }
+    }
+  else
+    {
+      for (uint32_t first = 0; first < count; first += BATCH_BURST)
+        {
+          uint32_t n = std::min (BATCH_BURST, count - first);
+          for (uint32_t k = 0; k < n; k++)
+            {
+              IpFlowKey::Extract (data + (first + k) * FLOW_STRIDE, FLOW_STRIDE, keys[k]);
+            }
+          IpFlowKey::Hash (keys, n, &hashes[first]);
+        }
+    }
+  uint64_t elapsed = NowNs () - start;
+  return static_cast<double> (elapsed) / count;
+}
+
+/**
+ * \brief Print the flow key and hash rate, by hand versus IpFlowKey.
+ * \param packets number of packets in the trace
+ * \param seed seed of the trace
+ */
+void
+RunFlowKey (uint32_t packets, uint32_t seed)
+{
+  Buffer trace;
+  MakeFlowTrace (packets, seed, trace);
+
+  std::vector<uint32_t> byHand;
+  std::vector<uint32_t> extract;
+  std::vector<uint32_t> batch;
+  double byHandNs = BenchFlowKeys (trace, packets, 0, byHand);
+  double extractNs = BenchFlowKeys (trace, packets, 1, extract);
+  double batchNs = BenchFlowKeys (trace, packets, 2, batch);
+  NS_ABORT_MSG_UNLESS (byHand == extract, "IpFlowKey::Extract disagrees with the header getters");
+  NS_ABORT_MSG_UNLESS (extract == batch, "Batch IpFlowKey::Hash disagrees with the single-key one");
+
+  // the hash alone, over a burst of keys already extracted and in cache
+  IpFlowKey keys[BATCH_BURST];
+  uint32_t hashes[BATCH_BURST];
+  uint32_t bursts = std::max<uint32_t> (packets / BATCH_BURST, 1);
+  for (uint32_t k = 0; k < BATCH_BURST; k++)
+    {
+      IpFlowKey::Extract (trace.PeekData () + (k % packets) * FLOW_STRIDE, FLOW_STRIDE, keys[k]);
+    }
+  uint64_t start = NowNs ();
+  for (uint32_t b = 0; b < bursts; b++)
+    {
+      for (uint32_t k = 0; k < BATCH_BURST; k++)
+        {
+          hashes[k] = IpFlowKey::Hash (keys[k], b);
+        }
+      g_sink += hashes[b % BATCH_BURST];
+    }
+  double hashNs = static_cast<double> (NowNs () - start) / (bursts * BATCH_BURST);
+  start = NowNs ();
+  for (uint32_t b = 0; b < bursts; b++)
+    {
+      IpFlowKey::Hash (keys, BATCH_BURST, hashes, b);
+      g_sink += hashes[b % BATCH_BURST];
+    }
+  double hashBatchNs = static_cast<double> (NowNs () - start) / (bursts * BATCH_BURST);
+  for (uint32_t k = 0; k < BATCH_BURST; k++)
+    {
+      NS_ABORT_MSG_UNLESS (hashes[k] == IpFlowKey::Hash (keys[k], bursts - 1),
+                           "Batch IpFlowKey::Hash disagrees with the single-key one");
+    }
+
+  std::vector<uint32_t> paths (FLOW_PATHS, 0);
+  for (uint32_t k = 0; k < packets; k++)
+    {
+      paths[batch[k] % FLOW_PATHS]++;
+    }
+
+  std::cout << std::fixed << std::setprecision (2)
+            << "flow keys, " << packets << " packets of " << FLOW_COUNT << " flows, IPv4 and IPv6\n"
+            << "                        ns/key    Mkeys/s\n"
+            << "  Deserialize + Hash" << std::setw (12) << byHandNs << std::setw (11) << 1e3 / byHandNs << "\n"
+            << "  Extract + Hash    " << std::setw (12) << extractNs << std::setw (11) << 1e3 / extractNs
+            << std::setw (8) << byHandNs / extractNs << "x\n"
+            << "  Extract + batch   " << std::setw (12) << batchNs << std::setw (11) << 1e3 / batchNs
+            << std::setw (8) << byHandNs / batchNs << "x\n"
+            << "  Hash only         " << std::setw (12) << hashNs << std::setw (11) << 1e3 / hashNs << "\n"
+            << "  batch Hash only   " << std::setw (12) << hashBatchNs << std::setw (11) << 1e3 / hashBatchNs
+            << std::setw (8) << hashNs / hashBatchNs << "x\n"
+            << "  " << FLOW_PATHS << "-way ECMP spread: "
+            << *std::min_element (paths.begin (), paths.end ()) << " to "
+            << *std::max_element (paths.begin (), paths.end ()) << " packets per path" << std::endl;
+}
+
+} // anonymous namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::string bench = "all";
+  uint32_t hops = 64;
+  uint32_t packets = 100000;
+  uint32_t megabytes = 256;
+  uint32_t warmup = 10000;
+  uint32_t seed = 1;
+  std::string json;
+
+  CommandLine cmd;
+  cmd.AddValue ("bench", "Benchmark to run: forward, checksum, view, options, extensions, compact, accessors, construct, batch, codec, dump, validate, flowkey or all", bench);
+  cmd.AddValue ("hops", "Number of routers in the forwarding chain", hops);
+  cmd.AddValue ("packets", "Number of packets forwarded along the chain", packets);
+  cmd.AddValue ("megabytes", "Megabytes checksummed per payload size and kernel", megabytes);
+  cmd.AddValue ("warmup", "Untimed calls before each codec measurement", warmup);
+  cmd.AddValue ("seed", "Seed of the random header fields of the codec suite", seed);
+  cmd.AddValue ("json", "File receiving the codec suite results as JSON", json);
+  cmd.Parse (argc, argv);
+
+  if (bench == "forward" || bench == "all")
+    {
+      RunForwarding (hops, packets);
+    }
+  if (bench == "checksum" || bench == "all")
+    {
+      RunChecksum (megabytes);
+    }
+  if (bench == "view" || bench == "all")
+    {
+      RunView (packets);
+    }
+  if (bench == "options" || bench == "all")
+    {
+      RunOptions (packets);
+    }
+  if (bench == "extensions" || bench == "all")
+    {
+      RunExtensions (packets);
+    }
+  if (bench == "compact" || bench == "all")
+    {
+      RunCompact (packets);
+    }
+  if (bench == "accessors" || bench == "all")
+    {
+      RunAccessors (packets);
+    }
+  if (bench == "construct" || bench == "all")
+    {
+      RunConstruct (packets);
+    }
+  if (bench == "batch" || bench == "all")
+    {
+      RunBatch (packets);
+    }
+  if (bench == "codec" || bench == "all")
+    {
+      RunCodec (packets, warmup, seed, json);
+    }
+  if (bench == "dump" || bench == "all")
+    {
+      RunDump (packets, seed);
+    }
+  if (bench == "validate" || bench == "all")
+    {
+      RunValidate (packets, seed);
+    }
+  if (bench == "flowkey" || bench == "all")
+    {
+      RunFlowKey (packets, seed);
+    }
+
+  return 0;
+}
@@ -0,0 +1,335 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * ICMP error flood, with and without an error rate limit.
+ *
+ * Node 0 sends echo requests at a fixed rate whose TTL (hop limit)
+ * expires at the first router of a chain, over IPv4, IPv6 or both, so
+ * that the router answers every one with a Time Exceeded, the way a
+ * probe flood loads the error path of a real router. The flood runs
+ * twice, each time in its own process: with the errors of the router
+ * unlimited, as ns-3 sends them, and limited by an IcmpRateLimit
+ * per-destination token bucket, like Linux icmp_ratelimit. Each row
+ * reports the packets the router handled, the errors it sent and
+ * dropped, the errors per simulated second the source got back, and the
+ * wall-clock events/s and router packets/s the simulation sustained.
+ *
+ * The defaults are those of Linux: a token per 1000 ms, 6 tokens.
+ *
+ * Usage: ./waf --run "icmp-error-flood --count=100000 --rate=100000"
+ *        ./waf --run "icmp-error-flood --interval=1 --burst=50 --family=v6"
+ *        ./waf --run "icmp-error-flood --routers=5 --fork=false"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/icmpv4.h"
+#include "ns3/icmpv6-header.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/uinteger.h"
+#include "ns3/icmp-topology.h"
+#include "ns3/icmp-rate-limit.h"
+#include "ns3/ipv4-header-view.h"
+#include "ns3/ipv6-extension-chain.h"
+#include "ns3/ipv6-header.h"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("IcmpErrorFlood");
+
+namespace {
+
+/**
+ * \brief The flood and the limit under test.
+ */
+struct FloodSettings
+{
+  uint32_t routers;  //!< routers in the chain
+  uint32_t count;    //!< requests per family
+  double rate;       //!< requests per simulated second, per family
+  uint32_t size;     //!< echo data bytes
+  bool v4;           //!< flood over IPv4
+  bool v6;           //!< flood over IPv6
+  bool limit;        //!< limit the errors of the router
+  uint32_t interval; //!< milliseconds per token
+  uint32_t burst;    //!< tokens per bucket
+};
+
+/**
+ * \brief What the source and the router saw.
+ */
+struct FloodCounters
+{
+  uint64_t errors;        //!< Time Exceeded received by the source
+  uint64_t routerPackets; //!< packets the router's IP stacks received
+
+  FloodCounters ()
+    : errors (0),
+      routerPackets (0)
+  {
+  }
+
+  /**
+   * \brief Receive callback of the IPv4 raw socket.
+   * \param socket the socket
+   */
+  void
+  ReceiveV4 (Ptr<Socket> socket)
+  {
+    Ptr<Packet> p;
+    while ((p = socket->Recv ()))
+      {
+        uint8_t bytes[Ipv4HeaderView::MAX_SIZE + 1];
+        uint32_t size = p->CopyData (bytes, sizeof (bytes));
+        Ipv4HeaderView ipv4 (bytes, size);
+        errors += ipv4.IsValid () && ipv4.GetProtocol () == 1 && size > ipv4.GetHeaderSize ()
+          && bytes[ipv4.GetHeaderSize ()] == Icmpv4Header::ICMPV4_TIME_EXCEEDED;
+      }
+  }
+
+  /**
+   * \brief Receive callback of the IPv6 raw socket.
+   * \param socket the socket
+   */
+  void
+  ReceiveV6 (Ptr<Socket> socket)
+  {
+    Ptr<Packet> p;
+    while ((p = socket->Recv ()))
+      {
+        uint8_t bytes[Ipv6ExtensionChain::WINDOW];
+        uint32_t size = p->CopyData (bytes, sizeof (bytes));
+        Ipv6ExtensionChain ipv6;
+        errors += ipv6.Walk (bytes, size) == Ipv6ExtensionChain::CHAIN_OK
+          && ipv6.GetProtocol () == Ipv6Header::IPV6_ICMPV6 && size > ipv6.GetUpperLayerOffset ()
+          && bytes[ipv6.GetUpperLayerOffset ()] == Icmpv6Header::ICMPV6_ERROR_TIME_EXCEEDED;
+      }
+  }
+
+  /**
+   * \brief IPv4 Rx trace sink of the router.
+   * \param p the packet
+   * \param ipv4 the stack
+   * \param interface the interface
+   */
+  void
+  RouterRxV4 (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+  {
+    routerPackets++;
+  }
+
+  /**
+   * \brief IPv6 Rx trace sink of the router.
+   * \param p the packet
+   * \param ipv6 the stack
+   * \param interface the interface
+   */
+  void
+  RouterRxV6 (Ptr<const Packet> p, Ptr<Ipv6> ipv6, uint32_t interface)
+  {
+    routerPackets++;
+  }
+};
+
+/**
+ * \brief Send a copy of a request and schedule the next one.
+ * \param socket the raw socket
+ * \param to the destination
+ * \param request the request
+ * \param left requests left to send, this one included
+ * \param gap time between requests
+ */
+void
+SendRequest (Ptr<Socket> socket, Address to, Ptr<Packet> request, uint32_t left, Time gap)
+{
+  Ptr<Packet> p = request->Copy ();
+  NS_ABORT_MSG_UNLESS (socket->SendTo (p, 0, to) == static_cast<int> (p->GetSize ()), "Failed to send a request");
+  if (left > 1)
+    {
+      Simulator::Schedule (gap, &SendRequest, socket, to, request, left - 1, gap);
+    }
+}
+
+/**
+ * \brief Run the flood and print one row of the report.
+ * \param settings the flood and the limit
+ */
+void
+RunFlood (FloodSettings const &settings)
+{
+  // addresses are usable at once, so the events counted are the flood's
+  Config::SetDefault ("ns3::Icmpv6L4Protocol::DAD", BooleanValue (false));
+
+  IcmpTopology topology (IcmpTopology::CHAIN, settings.routers + 2);
+  topology.SetRouting (IcmpTopology::FROM_FIRST);
+  topology.Build ();
+  // the flood starts before the first neighbor is resolved
+  topology.SetPendingQueueSize (64);
+  uint32_t last = topology.GetNLinks () - 1;
+  Ptr<Node> router = topology.GetNode (1);
+
+  IcmpRateLimit limit (MilliSeconds (settings.interval), settings.burst);
+  if (settings.limit)
+    {
+      limit.Install (router);
+    }
+  FloodCounters counters;
+  router->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext
+    ("Rx", MakeCallback (&FloodCounters::RouterRxV4, &counters));
+  router->GetObject<Ipv6L3Protocol> ()->TraceConnectWithoutContext
+    ("Rx", MakeCallback (&FloodCounters::RouterRxV6, &counters));
+
+  Time gap = Seconds (1 / settings.rate);
+  uint32_t context = topology.GetNode (0)->GetId ();
+  if (settings.v4)
+    {
+      Ptr<Socket> socket = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv4RawSocketFactory"));
+      socket->SetAttribute ("Protocol", UintegerValue (1)); // ICMP protocol
+      NS_ABORT_MSG_UNLESS (socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 0)) == 0,
+                           "Failed to bind the ICMP socket");
+      socket->SetRecvCallback (MakeCallback (&FloodCounters::ReceiveV4, &counters));
+      socket->SetIpTtl (1);
+      Ptr<Packet> request = Create<Packet> (settings.size);
+      Icmpv4Echo echo;
+      echo.SetIdentifier (5);
+      request->AddHeader (echo);
+      Icmpv4Header header;
+      header.SetType (Icmpv4Header::ICMPV4_ECHO);
+      header.SetCode (0);
+      request->AddHeader (header);
+      Simulator::ScheduleWithContext (context, Seconds (0), &SendRequest, socket,
+                                      InetSocketAddress (topology.GetIpv4Address (last, 1), 0),
+                                      request, settings.count, gap);
+    }
+  if (settings.v6)
+    {
+      Ptr<Socket> socket = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv6RawSocketFactory"));
+      socket->SetAttribute ("Protocol", UintegerValue (Ipv6Header::IPV6_ICMPV6));
+      NS_ABORT_MSG_UNLESS (socket->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), 0)) == 0,
+                           "Failed to bind the ICMPv6 socket");
+      socket->SetRecvCallback (MakeCallback (&FloodCounters::ReceiveV6, &counters));
+      socket->SetIpv6HopLimit (1);
+      Ptr<Packet> request = Create<Packet> (settings.size);
+      Icmpv6Echo echo (1);
+      echo.SetId (5);
+      request->AddHeader (echo);
+      Simulator::ScheduleWithContext (context, Seconds (0), &SendRequest, socket,
+                                      Inet6SocketAddress (topology.GetIpv6Address (last, 1), 0),
+                                      request, settings.count, gap);
+    }
+
+  uint64_t events = Simulator::GetEventCount ();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  double wall = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  events = Simulator::GetEventCount () - events;
+  double simulated = Simulator::Now ().GetSeconds ();
+  Simulator::Destroy ();
+
+  std::cout << std::setw (6) << (settings.limit ? "on" : "off")
+            << std::setw (12) << counters.routerPackets
+            << std::setw (12) << counters.errors
+            << std::setw (12) << limit.GetSuppressed ()
+            << std::fixed << std::setprecision (0)
+            << std::setw (12) << (simulated > 0 ? counters.errors / simulated : 0)
+            << std::setprecision (3) << std::setw (10) << wall
+            << std::setw (12) << events
+            << std::setprecision (0) << std::setw (12) << (wall > 0 ? events / wall : 0)
+            << std::setw (14) << (wall > 0 ? counters.routerPackets / wall : 0) << std::endl;
+}
+
+} // unnamed namespace
+
+int
+main (int argc, char *argv[])
+{
+  FloodSettings settings;
+  settings.routers = 1;
+  settings.count = 100000;
+  settings.rate = 100000;
+  settings.size = 56;
+  settings.interval = 1000;
+  settings.burst = 6;
+  std::string family = "both";
+  bool separate = true;
+
+  CommandLine cmd;
+  cmd.AddValue ("routers", "Routers in the chain; the requests expire at the first one", settings.routers);
+  cmd.AddValue ("count", "Echo requests sent per family", settings.count);
+  cmd.AddValue ("rate", "Requests per simulated second, per family", settings.rate);
+  cmd.AddValue ("size", "Echo data bytes", settings.size);
+  cmd.AddValue ("family", "Flood over v4, v6 or both", family);
+  cmd.AddValue ("interval", "Milliseconds for a bucket to earn a token, as net.ipv4.icmp_ratelimit", settings.interval);
+  cmd.AddValue ("burst", "Tokens a bucket holds", settings.burst);
+  cmd.AddValue ("fork", "Run each setting in its own process", separate);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_UNLESS (family == "v4" || family == "v6" || family == "both", "Unknown family " << family);
+  NS_ABORT_MSG_UNLESS (settings.routers >= 1, "The chain needs a router");
+  NS_ABORT_MSG_UNLESS (settings.count > 0 && settings.rate > 0, "The flood needs requests and a rate");
+  NS_ABORT_MSG_UNLESS (settings.burst > 0, "A bucket holds at least one token");
+  settings.v4 = family != "v6";
+  settings.v6 = family != "v4";
+
+  std::cout << "ICMP error flood: " << settings.count << " requests per family at " << settings.rate
+            << " pps, " << family << ", expiring at router 1 of " << settings.routers
+            << "; limit " << settings.burst << " tokens, one per " << settings.interval << " ms" << std::endl;
+  std::cout << std::setw (6) << "limit" << std::setw (12) << "router rx" << std::setw (12) << "errors"
+            << std::setw (12) << "suppressed" << std::setw (12) << "error pps" << std::setw (10) << "wall s"
+            << std::setw (12) << "events" << std::setw (12) << "events/s" << std::setw (14) << "router pkts/s"
+            << std::endl;
+
+  bool complete = true;
+  for (uint32_t limit = 0; limit < 2; limit++)
+    {
+      settings.limit = limit == 1;
+      if (!separate)
+        {
+          RunFlood (settings);
+          continue;
+        }
+      std::cout.flush ();
+      pid_t pid = fork ();
+      NS_ABORT_MSG_UNLESS (pid >= 0, "fork failed");
+      if (pid == 0)
+        {
+          RunFlood (settings);
+          std::cout.flush ();
+          _exit (0);
+        }
+      int status = 0;
+      waitpid (pid, &status, 0);
+      if (WIFSIGNALED (status))
+        {
+          std::cout << std::setw (6) << (settings.limit ? "on" : "off") << "  killed by signal "
+                    << WTERMSIG (status) << std::endl;
+        }
+      complete = complete && WIFEXITED (status) && WEXITSTATUS (status) == 0;
+    }
+  return complete ? 0 : 1;
+}
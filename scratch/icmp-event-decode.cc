@@ -0,0 +1,155 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * ICMP event log decoder.
+ *
+ * Prints the binary event log icmp-test writes with --quiet as the
+ * packet text it prints otherwise, one section per test case run. Runs
+ * whose ring overflowed say how many of their oldest events were lost.
+ *
+ * Usage: ./waf --run "icmp-test --quiet --events=icmp-events.bin"
+ *        ./waf --run "icmp-event-decode --input=icmp-events.bin"
+ *        ./waf --run "icmp-event-decode --input=icmp-events.bin --case=V6"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/icmpv4.h"
+#include "ns3/icmpv6-header.h"
+#include "ns3/icmp-event-log.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("IcmpEventDecode");
+
+namespace {
+
+/**
+ * \brief Decode a sent packet as IcmpEventLog::Print does.
+ * \param family 4 or 6
+ * \param p the packet, starting with the ICMP header
+ * \returns the printed text
+ */
+std::string
+DecodeSent (uint8_t family, Ptr<const Packet> p)
+{
+  IcmpEventLog::Event event;
+  event.time = 0;
+  event.node = 0;
+  event.size = p->GetSize ();
+  event.kind = IcmpEventLog::SENT;
+  event.family = family;
+  event.headSize = p->CopyData (event.head, IcmpEventLog::HEAD_SIZE);
+  event.reserved = 0;
+  std::ostringstream os;
+  IcmpEventLog::Print (event, os);
+  return os.str ();
+}
+
+/**
+ * \brief Check the echo fields decoded from an ICMPv4 and an ICMPv6 echo request.
+ *
+ * Both are built as icmp-test sends them: an Icmpv4Header in front of
+ * an Icmpv4Echo, and an Icmpv6Header in front of an Icmpv6Echo, which
+ * carries its own type, code and checksum. A bare Icmpv6Echo, as the
+ * rate-limit case sends, is checked too.
+ */
+void
+CheckEchoDecode (void)
+{
+  Ptr<Packet> p4 = Create<Packet> (10);
+  Icmpv4Echo echo4;
+  echo4.SetIdentifier (0xB1ED);
+  echo4.SetSequenceNumber (1);
+  p4->AddHeader (echo4);
+  Icmpv4Header header4;
+  header4.SetType (Icmpv4Header::ICMPV4_ECHO);
+  header4.SetCode (0);
+  p4->AddHeader (header4);
+  std::string text = DecodeSent (4, p4);
+  NS_ABORT_MSG_UNLESS (text.find ("ns3::Icmpv4Echo (identifier=45549, sequence=1, data size=10)") != std::string::npos,
+                       "Wrong ICMPv4 echo decode: " << text);
+
+  Ptr<Packet> p6 = Create<Packet> (10);
+  Icmpv6Echo echo6 (1);
+  echo6.SetId (0xB1ED);
+  echo6.SetSeq (1);
+  p6->AddHeader (echo6);
+  Icmpv6Header header6;
+  header6.SetType (Icmpv6Header::ICMPV6_ECHO_REQUEST);
+  header6.SetCode (0);
+  p6->AddHeader (header6);
+  text = DecodeSent (6, p6);
+  NS_ABORT_MSG_UNLESS (text.find ("ns3::Icmpv6Echo (identifier=45549, sequence=1, data size=10)") != std::string::npos,
+                       "Wrong ICMPv6 echo decode: " << text);
+
+  Ptr<Packet> bare = Create<Packet> (10);
+  bare->AddHeader (echo6);
+  text = DecodeSent (6, bare);
+  NS_ABORT_MSG_UNLESS (text.find ("ns3::Icmpv6Echo (identifier=45549, sequence=1, data size=10)") != std::string::npos,
+                       "Wrong bare ICMPv6 echo decode: " << text);
+}
+
+} // anonymous namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::string input = "icmp-events.bin";
+  std::string filter;
+
+  CommandLine cmd;
+  cmd.AddValue ("input", "Event log written by icmp-test --quiet", input);
+  cmd.AddValue ("case", "Print only the runs whose name contains this text", filter);
+  cmd.Parse (argc, argv);
+
+  CheckEchoDecode ();
+
+  std::ifstream is (input.c_str (), std::ios::binary);
+  NS_ABORT_MSG_UNLESS (is, "Cannot open the event log " << input);
+
+  IcmpEventLog::Block block;
+  uint64_t blocks = 0;
+  uint64_t events = 0;
+  while (IcmpEventLog::ReadBlock (is, block))
+    {
+      blocks++;
+      if (block.name.find (filter) == std::string::npos)
+        {
+          continue;
+        }
+      std::cout << "==== " << block.name << ", run " << block.run << std::endl;
+      if (block.recorded > block.events.size ())
+        {
+          std::cout << "(" << block.recorded - block.events.size () << " older events lost, the ring was full)"
+                    << std::endl;
+        }
+      for (uint32_t k = 0; k < block.events.size (); k++)
+        {
+          IcmpEventLog::Print (block.events[k], std::cout);
+          std::cout << std::endl;
+        }
+      events += block.events.size ();
+    }
+  NS_ABORT_MSG_UNLESS (is.eof (), "Malformed event block after " << blocks << " blocks of " << input);
+  std::cout << events << " events printed, " << blocks << " runs in the log" << std::endl;
+  return 0;
+}
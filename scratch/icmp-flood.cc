@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * ICMP echo flood.
+ *
+ * Node 0 floods the last node of a chain with echo requests over a raw
+ * socket, either keeping a window of requests outstanding (like ping -f)
+ * or at a fixed rate, and reports the simulated packet rate the stack
+ * sustains next to the wall-clock cost of simulating it. ns-3 charges no
+ * processing time to the nodes, so the simulated rate is set by the links
+ * and the window alone; the wall-clock events/s and replies/s are the
+ * throughput ceiling of the simulated stack. Links have no data rate
+ * limit and a 10 us delay by default; --dataRate, --delay and --loss
+ * change them.
+ *
+ * Usage: ./waf --run "icmp-flood --count=100000 --outstanding=64"
+ *        ./waf --run "icmp-flood --count=100000 --rate=50000 --dataRate=100Mbps"
+ *        ./waf --run "icmp-flood --nodes=5 --delay=100 --loss=0.01"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/error-model.h"
+#include "ns3/data-rate.h"
+#include "ns3/uinteger.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/icmp-topology.h"
+#include "ns3/icmp-echo-flood.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("IcmpFlood");
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nodes = 2;
+  uint32_t count = 100000;
+  uint32_t outstanding = 64;
+  double rate = 0;
+  uint32_t size = 56;
+  std::string dataRate;
+  uint32_t delay = 10;
+  double loss = 0;
+  uint32_t timeout = 1000;
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "Nodes in the chain, the flood crosses nodes - 2 routers", nodes);
+  cmd.AddValue ("count", "Number of echo requests sent", count);
+  cmd.AddValue ("outstanding", "Requests kept outstanding, window mode", outstanding);
+  cmd.AddValue ("rate", "Requests per simulated second, 0 for window mode", rate);
+  cmd.AddValue ("size", "Echo data bytes", size);
+  cmd.AddValue ("dataRate", "Link data rate, e.g. 1Gbps, empty for infinitely fast links", dataRate);
+  cmd.AddValue ("delay", "Link delay in microseconds", delay);
+  cmd.AddValue ("loss", "Packet error rate of every receiving device", loss);
+  cmd.AddValue ("timeout", "Window slot timeout in milliseconds", timeout);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_UNLESS (nodes >= 2, "The flood needs at least 2 nodes");
+  NS_ABORT_MSG_UNLESS (outstanding > 0 && outstanding < 0x10000, "Window of " << outstanding << " requests");
+  NS_ABORT_MSG_UNLESS (size <= 65507, "An echo of " << size << " data bytes does not fit an IPv4 packet");
+
+  IcmpTopology topology (IcmpTopology::CHAIN, nodes);
+  topology.Build ();
+  for (uint32_t j = 0; j < topology.GetNLinks (); j++)
+    {
+      NetDeviceContainer link = topology.GetLink (j);
+      link.Get (0)->GetChannel ()->SetAttribute ("Delay", TimeValue (MicroSeconds (delay)));
+      for (uint32_t side = 0; side < 2; side++)
+        {
+          Ptr<NetDevice> device = link.Get (side);
+          if (!dataRate.empty ())
+            {
+              device->SetAttribute ("DataRate", DataRateValue (DataRate (dataRate)));
+            }
+          if (loss > 0)
+            {
+              Ptr<RateErrorModel> errors = CreateObject<RateErrorModel> ();
+              errors->SetUnit (RateErrorModel::ERROR_UNIT_PACKET);
+              errors->SetRate (loss);
+              device->SetAttribute ("ReceiveErrorModel", PointerValue (errors));
+            }
+        }
+    }
+
+  Ptr<Socket> socket = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv4RawSocketFactory"));
+  socket->SetAttribute ("Protocol", UintegerValue (1)); // ICMP protocol
+  NS_ABORT_MSG_UNLESS (socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 0)) == 0,
+                       "Failed to bind the ICMP socket");
+
+  IcmpEchoFlood flood (socket, topology.GetIpv4Address (topology.GetNLinks () - 1, 1));
+  flood.SetIdentifier (5);
+  flood.SetDataSize (size);
+  flood.SetTimeout (MilliSeconds (timeout));
+  if (rate > 0)
+    {
+      flood.SetRate (rate);
+    }
+  else
+    {
+      flood.SetOutstanding (outstanding);
+    }
+  flood.Start (count);
+
+  uint64_t events = Simulator::GetEventCount ();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  double wall = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  events = Simulator::GetEventCount () - events;
+
+  double simulated = flood.GetDuration ().GetSeconds ();
+  std::cout << "ICMP echo flood: " << count << " requests of " << size + 8 << " bytes over "
+            << topology.GetNLinks () << " links, ";
+  if (rate > 0)
+    {
+      std::cout << "rate " << rate << " pps" << std::endl;
+    }
+  else
+    {
+      std::cout << outstanding << " outstanding" << std::endl;
+    }
+  std::cout << "sent " << flood.GetSent () << ", received " << flood.GetReceived ()
+            << ", lost " << flood.GetLost () << ", reordered " << flood.GetReordered ()
+            << ", duplicates " << flood.GetDuplicates () << ", timeouts " << flood.GetTimeouts () << std::endl;
+  std::cout << std::fixed << std::setprecision (3)
+            << "rtt min/avg/max " << flood.GetMinRtt ().GetMicroSeconds () / 1e3
+            << "/" << flood.GetMeanRtt ().GetMicroSeconds () / 1e3
+            << "/" << flood.GetMaxRtt ().GetMicroSeconds () / 1e3 << " ms" << std::endl;
+  LatencyHistogram const &rtt = flood.GetRttHistogram ();
+  std::cout << "rtt p50/p99/p99.9 " << rtt.GetPercentile (50).GetMicroSeconds () / 1e3
+            << "/" << rtt.GetPercentile (99).GetMicroSeconds () / 1e3
+            << "/" << rtt.GetPercentile (99.9).GetMicroSeconds () / 1e3 << " ms" << std::endl;
+  std::cout << "simulated " << std::setprecision (6) << simulated << " s, "
+            << std::setprecision (0) << (simulated > 0 ? flood.GetReceived () / simulated : 0)
+            << " replies/s simulated" << std::endl;
+  std::cout << "wall " << std::setprecision (3) << wall << " s, " << std::setprecision (0)
+            << events / wall << " events/s, " << flood.GetReceived () / wall << " replies/s, "
+            << std::setprecision (1) << static_cast<double> (events) / std::max<uint64_t> (flood.GetSent (), 1)
+            << " events per request" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -15,15 +15,263 @@
 #include "ns3/log.h"
 #include "ns3/node.h"
 #include "ns3/internet-stack-helper.h"
+#include "ns3/command-line.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/abort.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/channel-list.h"
+#include "ns3/object-factory.h"
+#include "ns3/double.h"
 
 #include "ns3/test.h"
 
+#include "ns3/ipv4-header-view.h"
+#include "ns3/ipv6-header-view.h"
+#include "ns3/ipv6-extension-chain.h"
+#include "ns3/icmp-topology.h"
+#include "ns3/icmp-traceroute.h"
+#include "ns3/icmp-rate-limit.h"
+#include "ns3/latency-histogram.h"
+#include "ns3/icmp-event-log.h"
+#include "ns3/trace-digest.h"
+#include "ns3/lossy-channel.h"
+#include "ns3/job-queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
 #include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 NS_LOG_COMPONENT_DEFINE ("Icmpv4HeaderTest");
 
 using namespace ns3;
 
+namespace {
+
+/// Marks the send time appended to a probe, echoed back in the reply.
+const uint8_t SEND_STAMP_MAGIC[4] = { 'R', 'T', 'T', 0 };
+/// Bytes of a send stamp: the mark, then the send time in time steps, big-endian.
+const uint32_t SEND_STAMP_SIZE = 12;
+
+/// RTT histograms recorded by this process, per probe destination.
+std::map<std::string, LatencyHistogram> g_rtt;
+
+/// Event log of quiet mode, 0 when the cases print their packets.
+IcmpEventLog *g_events = 0;
+
+/// Makes the link channels of the case running, see SelectLink.
+ObjectFactory g_channel;
+/// Packets the case running sent.
+uint64_t g_sent = 0;
+/// Packets the case running received.
+uint64_t g_received = 0;
+/// Packets the lossy links of the case running dropped.
+uint64_t g_dropped = 0;
+
+/**
+ * \brief Print a packet a case sent or received, or log it in quiet mode.
+ * \param label what precedes the printed packet
+ * \param kind which way the packet went
+ * \param family 4 or 6
+ * \param socket the socket it went through
+ * \param p the packet
+ */
+void
+TracePacket (char const *label, IcmpEventLog::Kind kind, uint8_t family, Ptr<Socket> socket, Ptr<const Packet> p)
+{
+  if (kind == IcmpEventLog::SENT)
+    {
+      g_sent++;
+    }
+  else
+    {
+      g_received++;
+    }
+  if (g_events != 0)
+    {
+      g_events->Record (kind, family, socket->GetNode ()->GetId (), p);
+      return;
+    }
+  printf("%s", label);
+  p->Print(std::cout);
+  printf("\n\n");
+}
+
+/// Digest of the packets delivered in the scenario running.
+TraceDigest g_digest;
+
+/**
+ * \brief Hash every packet the nodes deliver to IP into g_digest, while in scope.
+ *
+ * Hooks the Rx trace of the IPv4 and IPv6 stacks of every node, which
+ * sees each packet a device hands up, IP header included: probes,
+ * replies, errors, forwarded packets and neighbor discovery alike. The
+ * packets a LossyChannel drops never get there; they are counted into
+ * g_dropped instead.
+ */
+class DeliveryDigest
+{
+public:
+  DeliveryDigest ();
+  ~DeliveryDigest ();
+
+private:
+  /**
+   * \brief IPv4 Rx trace sink.
+   * \param p the packet
+   * \param ipv4 the receiving stack
+   * \param interface the receiving interface
+   */
+  static void DeliverV4 (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+  /**
+   * \brief IPv6 Rx trace sink.
+   * \param p the packet
+   * \param ipv6 the receiving stack
+   * \param interface the receiving interface
+   */
+  static void DeliverV6 (Ptr<const Packet> p, Ptr<Ipv6> ipv6, uint32_t interface);
+  /**
+   * \brief LossyChannel Drop trace sink.
+   * \param p the packet dropped
+   */
+  static void Drop (Ptr<const Packet> p);
+
+  NodeContainer m_nodes; //!< the nodes hooked
+};
+
+DeliveryDigest::DeliveryDigest ()
+  : m_nodes (NodeContainer::GetGlobal ())
+{
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = m_nodes.Get (i)->GetObject<Ipv4L3Protocol> ();
+      Ptr<Ipv6L3Protocol> ipv6 = m_nodes.Get (i)->GetObject<Ipv6L3Protocol> ();
+      if (ipv4 != 0)
+        {
+          ipv4->TraceConnectWithoutContext ("Rx", MakeCallback (&DeliveryDigest::DeliverV4));
+        }
+      if (ipv6 != 0)
+        {
+          ipv6->TraceConnectWithoutContext ("Rx", MakeCallback (&DeliveryDigest::DeliverV6));
+        }
+    }
+  for (uint32_t i = 0; i < ChannelList::GetNChannels (); i++)
+    {
+      Ptr<LossyChannel> channel = DynamicCast<LossyChannel> (ChannelList::GetChannel (i));
+      if (channel != 0)
+        {
+          channel->TraceConnectWithoutContext ("Drop", MakeCallback (&DeliveryDigest::Drop));
+        }
+    }
+}
+
+DeliveryDigest::~DeliveryDigest ()
+{
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = m_nodes.Get (i)->GetObject<Ipv4L3Protocol> ();
+      Ptr<Ipv6L3Protocol> ipv6 = m_nodes.Get (i)->GetObject<Ipv6L3Protocol> ();
+      if (ipv4 != 0)
+        {
+          ipv4->TraceDisconnectWithoutContext ("Rx", MakeCallback (&DeliveryDigest::DeliverV4));
+        }
+      if (ipv6 != 0)
+        {
+          ipv6->TraceDisconnectWithoutContext ("Rx", MakeCallback (&DeliveryDigest::DeliverV6));
+        }
+    }
+  for (uint32_t i = 0; i < ChannelList::GetNChannels (); i++)
+    {
+      Ptr<LossyChannel> channel = DynamicCast<LossyChannel> (ChannelList::GetChannel (i));
+      if (channel != 0)
+        {
+          channel->TraceDisconnectWithoutContext ("Drop", MakeCallback (&DeliveryDigest::Drop));
+        }
+    }
+}
+
+void
+DeliveryDigest::DeliverV4 (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  g_digest.AddPacket (Simulator::Now (), ipv4->GetObject<Node> ()->GetId (), p);
+}
+
+void
+DeliveryDigest::DeliverV6 (Ptr<const Packet> p, Ptr<Ipv6> ipv6, uint32_t interface)
+{
+  g_digest.AddPacket (Simulator::Now (), ipv6->GetObject<Node> ()->GetId (), p);
+}
+
+void
+DeliveryDigest::Drop (Ptr<const Packet> p)
+{
+  g_dropped++;
+}
+
+/**
+ * \returns a payload carrying the current time, to end a probe with
+ */
+Ptr<Packet>
+CreateSendStamp (void)
+{
+  uint8_t stamp[SEND_STAMP_SIZE];
+  std::copy (SEND_STAMP_MAGIC, SEND_STAMP_MAGIC + 4, stamp);
+  uint64_t now = Simulator::Now ().GetTimeStep ();
+  for (uint32_t k = 0; k < 8; k++)
+    {
+      stamp[4 + k] = now >> (56 - 8 * k);
+    }
+  return Create<Packet> (stamp, sizeof (stamp));
+}
+
+/**
+ * \brief Record the RTT of a reply that ends with the send stamp of its probe.
+ *
+ * Echo replies carry the probe data back whole, and ICMPv6 errors quote
+ * the whole probe; ICMPv4 errors quote only 8 bytes past the IP header,
+ * so they carry no stamp and are not recorded.
+ *
+ * \param destination the probe destination
+ * \param p the reply, or any part of it that ends where it ends
+ */
+template <typename A>
+void
+RecordRtt (A const &destination, Ptr<const Packet> p)
+{
+  if (p->GetSize () < SEND_STAMP_SIZE)
+    {
+      return;
+    }
+  uint8_t stamp[SEND_STAMP_SIZE];
+  p->CreateFragment (p->GetSize () - SEND_STAMP_SIZE, SEND_STAMP_SIZE)->CopyData (stamp, sizeof (stamp));
+  if (!std::equal (SEND_STAMP_MAGIC, SEND_STAMP_MAGIC + 4, stamp))
+    {
+      return;
+    }
+  uint64_t sent = 0;
+  for (uint32_t k = 0; k < 8; k++)
+    {
+      sent = (sent << 8) | stamp[4 + k];
+    }
+  std::ostringstream key;
+  key << destination;
+  g_rtt[key.str ()].Record (Simulator::Now () - TimeStep (sent));
+}
+
+} // anonymous namespace
+
 /**
  * \brief ICMP  Echo Reply Test
  */
@@ -36,6 +284,7 @@ public:
   void SendData (Ptr<Socket> socket, Ipv4Address dst);
   void DoSendData (Ptr<Socket> socket, Ipv4Address dst);
   void ReceivePkt (Ptr<Socket> socket);
+  void Probe (IcmpTopology &topology);
 
 public:
   virtual void DoRun (void);
@@ -65,6 +314,7 @@ IcmpEchoReplyTestCase::DoSendData (Ptr<Socket> socket, Ipv4Address dst)
   Icmpv4Echo echo;
   echo.SetSequenceNumber (1);
   echo.SetIdentifier (5);
+  echo.SetData (CreateSendStamp ());
   p->AddHeader (echo);
 
 
@@ -81,9 +331,7 @@ IcmpEchoReplyTestCase::DoSendData (Ptr<Socket> socket, Ipv4Address dst)
   }
 
 
-  printf("Pacote Enviado: \n");
-  p->Print(std::cout);
-  printf("\n\n");
+  TracePacket ("Pacote Enviado: \n", IcmpEventLog::SENT, 4, socket, p);
 
 }
 
@@ -93,6 +341,7 @@ IcmpEchoReplyTestCase::SendData (Ptr<Socket> socket, Ipv4Address dst)
 {
   Simulator::ScheduleWithContext (socket->GetNode ()->GetId (), Seconds (0),
                                   &IcmpEchoReplyTestCase::DoSendData, this, socket, dst);
+  DeliveryDigest digest;
   Simulator::Run ();
 }
 
@@ -102,12 +351,15 @@ IcmpEchoReplyTestCase::ReceivePkt (Ptr <Socket> socket)
   Address from;
   Ptr<Packet> p = socket->RecvFrom (0xffffffff, 0, from);
 
-  printf("Pacote Recebido: \n");
-  p->Print(std::cout);
-  printf("\n\n");
+  TracePacket ("Pacote Recebido: \n", IcmpEventLog::RECEIVED, 4, socket, p);
 
-  Ipv4Header ipv4;
-  p->RemoveHeader (ipv4);
+  uint8_t ipv4Bytes[Ipv4HeaderView::MAX_SIZE];
+  Ipv4HeaderView ipv4 (ipv4Bytes, p->CopyData (ipv4Bytes, sizeof (ipv4Bytes)));
+  if(!ipv4.IsValid ()){
+    printf("O pacote recebido não é um pacote IPv4 válido\n\n");
+    return;
+  }
+  p->RemoveAtStart (ipv4.GetHeaderSize ());
 
   if(ipv4.GetProtocol () != 1){
     printf("O pacote recebido não é um pacote ICMP\n\n");
@@ -118,7 +370,9 @@ IcmpEchoReplyTestCase::ReceivePkt (Ptr <Socket> socket)
 
   if(icmp.GetType () != Icmpv4Header::ICMPV4_ECHO_REPLY){
     printf("O pacote recebido não é um pacote ICMP Echo Reply\n\n");
+    return;
   }
+  RecordRtt (ipv4.GetSource (), p);
 }
 
 
@@ -126,31 +380,23 @@ void
 IcmpEchoReplyTestCase::DoRun ()
 {
   printf("Iniciando IcmpEchoReplyTestCase... \n\n");
-  NodeContainer n;
-  n.Create (2);
-
-  InternetStackHelper internet;
-  internet.Install (n);
+  IcmpTopology topology (IcmpTopology::CHAIN, 3);
+  topology.SetChannel (g_channel);
+  topology.Build ();
+  Probe (topology);
 
-  // link the two nodes
-  Ptr<SimpleNetDevice> txDev = CreateObject<SimpleNetDevice> ();
-  Ptr<SimpleNetDevice> rxDev = CreateObject<SimpleNetDevice> ();
-  n.Get (0)->AddDevice (txDev);
-  n.Get (1)->AddDevice (rxDev);
-  Ptr<SimpleChannel> channel1 = CreateObject<SimpleChannel> ();
-  rxDev->SetChannel (channel1);
-  txDev->SetChannel (channel1);
-  NetDeviceContainer d;
-  d.Add (txDev);
-  d.Add (rxDev);
+  printf("Finalizando IcmpEchoReplyTestCase!\n\n");
+  Simulator::Destroy ();
 
-  Ipv4AddressHelper ipv4;
+  printf("\n\n");
+}
 
-  ipv4.SetBase ("10.0.0.0", "255.255.255.252");
-  Ipv4InterfaceContainer i = ipv4.Assign (d);
 
+void
+IcmpEchoReplyTestCase::Probe (IcmpTopology &topology)
+{
   Ptr<Socket> socket;
-  socket = Socket::CreateSocket (n.Get (0), TypeId::LookupByName ("ns3::Ipv4RawSocketFactory"));
+  socket = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv4RawSocketFactory"));
   socket->SetAttribute ("Protocol", UintegerValue (1)); // ICMP protocol
   socket->SetRecvCallback (MakeCallback (&IcmpEchoReplyTestCase::ReceivePkt, this));
 
@@ -158,18 +404,11 @@ IcmpEchoReplyTestCase::DoRun ()
   
   if(socket->Bind (src) != 0){
     printf("Falha ao efetuar socket bind\n\n");
-    printf("Finalizando IcmpEchoReplyTestCase\n\n");
     return;
   }
 
   socket->SetIpTtl (1);
-  SendData (socket, i.GetAddress (1,0));
-
-
-  printf("Finalizando IcmpEchoReplyTestCase!\n\n");
-  Simulator::Destroy ();
-
-  printf("\n\n");
+  SendData (socket, topology.GetIpv4Address (0, 1));
 }
 
 
@@ -185,6 +424,7 @@ public:
   void SendData (Ptr<Socket> socket, Ipv4Address dst);
   void DoSendData (Ptr<Socket> socket, Ipv4Address dst);
   void ReceivePkt (Ptr<Socket> socket);
+  void Probe (IcmpTopology &topology);
 
 public:
   virtual void DoRun (void);
@@ -229,9 +469,7 @@ IcmpTimeExceedTestCase::DoSendData (Ptr<Socket> socket, Ipv4Address dst)
     return;
   }
 
-  printf("Pacote Enviado:\n");
-  p->Print(std::cout);
-  printf("\n\n");
+  TracePacket ("Pacote Enviado:\n", IcmpEventLog::SENT, 4, socket, p);
 
 }
 
@@ -242,6 +480,7 @@ IcmpTimeExceedTestCase::SendData (Ptr<Socket> socket, Ipv4Address dst)
   Simulator::ScheduleWithContext (socket->GetNode ()->GetId (), Seconds (0),
                                   &IcmpTimeExceedTestCase::DoSendData, this, socket, dst);
 
+  DeliveryDigest digest;
   Simulator::Run ();
 }
 
@@ -252,12 +491,15 @@ IcmpTimeExceedTestCase::ReceivePkt (Ptr<Socket> socket)
   Address from;
   Ptr<Packet> p = socket->RecvFrom (0xffffffff, 0, from);
   
-  printf("Pacote Recebido: \n");
-  p->Print(std::cout);
-  printf("\n \n");
+  TracePacket ("Pacote Recebido: \n", IcmpEventLog::RECEIVED, 4, socket, p);
 
-  Ipv4Header ipv4;
-  p->RemoveHeader (ipv4);
+  uint8_t ipv4Bytes[Ipv4HeaderView::MAX_SIZE];
+  Ipv4HeaderView ipv4 (ipv4Bytes, p->CopyData (ipv4Bytes, sizeof (ipv4Bytes)));
+  if(!ipv4.IsValid ()){
+    printf("O pacote recebido não é um pacote IPv4 válido\n\n");
+    return;
+  }
+  p->RemoveAtStart (ipv4.GetHeaderSize ());
   if(ipv4.GetProtocol () != 1){
     printf("O pacote recebido não é um pacote ICMP\n\n");
   }
@@ -277,41 +519,22 @@ void
 IcmpTimeExceedTestCase::DoRun ()
 {
   printf("Iniciando IcmpTimeExceedTestCase... \n\n");
-  NodeContainer n, n0n1,n1n2;
-  n.Create (3);
-  n0n1.Add (n.Get (0));
-  n0n1.Add (n.Get (1));
-  n1n2.Add (n.Get (1));
-  n1n2.Add (n.Get (2));
-
-  Ptr<SimpleChannel> channel = CreateObject <SimpleChannel> ();
-  Ptr<SimpleChannel> channel2 = CreateObject <SimpleChannel> ();
-
-  SimpleNetDeviceHelper simpleHelper;
-  simpleHelper.SetNetDevicePointToPointMode (true);
-
-  SimpleNetDeviceHelper simpleHelper2;
-  simpleHelper2.SetNetDevicePointToPointMode (true);
-
-  NetDeviceContainer devices;
-  devices = simpleHelper.Install (n0n1,channel);
-  NetDeviceContainer devices2;
-  devices2 = simpleHelper2.Install (n1n2,channel2);
+  IcmpTopology topology (IcmpTopology::CHAIN, 3);
+  topology.SetChannel (g_channel);
+  topology.Build ();
+  Probe (topology);
 
-  InternetStackHelper internet;
-  internet.Install (n);
-
-  Ipv4AddressHelper address;
-  address.SetBase ("10.0.0.0","255.255.255.255");
-  Ipv4InterfaceContainer i = address.Assign (devices);
-
-  address.SetBase ("10.0.1.0","255.255.255.255");
-  Ipv4InterfaceContainer i2 = address.Assign (devices2);
+  printf("Finalizando IcmpTimeExceedTestCase!\n");
+  Simulator::Destroy ();
+  printf("\n\n");
+}
 
-  Ipv4GlobalRoutingHelper::PopulateRoutingTables();
 
+void
+IcmpTimeExceedTestCase::Probe (IcmpTopology &topology)
+{
   Ptr<Socket> socket;
-  socket = Socket::CreateSocket (n.Get (0), TypeId::LookupByName ("ns3::Ipv4RawSocketFactory"));
+  socket = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv4RawSocketFactory"));
   socket->SetAttribute ("Protocol", UintegerValue (1)); // ICMP protocol
   socket->SetRecvCallback (MakeCallback (&IcmpTimeExceedTestCase::ReceivePkt, this));
 
@@ -319,18 +542,13 @@ IcmpTimeExceedTestCase::DoRun ()
   InetSocketAddress src = InetSocketAddress (Ipv4Address::GetAny (), 0);
   if(socket->Bind (src) != 0){
     printf("Falha ao efetuar socket bind\n\n");
-    printf("Finalizando IcmpTimeExceedTestCase!\n\n");
     return;
   }
 
 
   // O TTL deve ser pequeno o suficiente para causa uma resposta ICMP Time Exceeded
   socket->SetIpTtl (1);
-  SendData (socket, i2.GetAddress (1,0));
-
-  printf("Finalizando IcmpTimeExceedTestCase!\n");
-  Simulator::Destroy ();
-  printf("\n\n");
+  SendData (socket, topology.GetIpv4Address (1, 1));
 }
 
 
@@ -346,6 +564,7 @@ public:
   void SendData (Ptr<Socket> socket, Ipv6Address dst);
   void DoSendData (Ptr<Socket> socket, Ipv6Address dst);
   void ReceivePkt (Ptr<Socket> socket);
+  void Probe (IcmpTopology &topology);
 
 public:
   virtual void DoRun (void);
@@ -370,7 +589,7 @@ void
 IcmpV6EchoReplyTestCase::DoSendData (Ptr<Socket> socket, Ipv6Address dst)
 {
 
-  Ptr<Packet> p = Create<Packet> ();
+  Ptr<Packet> p = CreateSendStamp ();
   Icmpv6Echo echo (1);
   echo.SetSeq (1);
   echo.SetId (0XB1ED);
@@ -385,9 +604,7 @@ IcmpV6EchoReplyTestCase::DoSendData (Ptr<Socket> socket, Ipv6Address dst)
 
   socket->SendTo (p, 0, realTo);
 
-  printf("Pacote Enviado:\n");
-  p->Print(std::cout);
-  printf("\n\n");
+  TracePacket ("Pacote Enviado:\n", IcmpEventLog::SENT, 6, socket, p);
 
 }
 
@@ -397,6 +614,7 @@ IcmpV6EchoReplyTestCase::SendData (Ptr<Socket> socket, Ipv6Address dst)
 {
   Simulator::ScheduleWithContext (socket->GetNode ()->GetId (), Seconds (0),
                                   &IcmpV6EchoReplyTestCase::DoSendData, this, socket, dst);
+  DeliveryDigest digest;
   Simulator::Run ();
 }
 
@@ -406,15 +624,19 @@ IcmpV6EchoReplyTestCase::ReceivePkt (Ptr <Socket> socket)
   Address from;
   Ptr<Packet> p = socket->RecvFrom (from);
 
-  printf("Pacote recebido:\n");
-  p->Print(std::cout);
-  printf("\n\n");
+  TracePacket ("Pacote recebido:\n", IcmpEventLog::RECEIVED, 6, socket, p);
 
   if (Inet6SocketAddress::IsMatchingType (from))
     {
-      Ipv6Header ipv6;
-      p->RemoveHeader (ipv6);
-      if(ipv6.GetNextHeader () != Ipv6Header::IPV6_ICMPV6){
+      // the ICMPv6 header may sit behind extension headers
+      uint8_t ipv6Bytes[Ipv6ExtensionChain::WINDOW];
+      Ipv6ExtensionChain ipv6;
+      if (ipv6.Walk (ipv6Bytes, p->CopyData (ipv6Bytes, sizeof (ipv6Bytes))) != Ipv6ExtensionChain::CHAIN_OK){
+        printf("O pacote recebido não é um pacote IPv6 válido\n\n");
+        return;
+      }
+      p->RemoveAtStart (ipv6.GetUpperLayerOffset ());
+      if(ipv6.GetProtocol () != Ipv6Header::IPV6_ICMPV6){
         printf("O pacote recebido não é um pacote ICMPV6\n\n");
       }
 
@@ -431,7 +653,9 @@ IcmpV6EchoReplyTestCase::ReceivePkt (Ptr <Socket> socket)
 
           if((int) icmpv6.GetType () != Icmpv6Header::ICMPV6_ECHO_REPLY){
             printf("O pacote recebido não é um pacote ICMPV6 Echo Reply\n\n");
+            return;
           }
+          RecordRtt (Inet6SocketAddress::ConvertFrom (from).GetIpv6 (), p);
         }
 
     }
@@ -443,34 +667,21 @@ IcmpV6EchoReplyTestCase::DoRun ()
 {
 
   printf("Iniciando IcmpV6EchoReplyTestCase: \n\n");
-  NodeContainer n;
-  n.Create (2);
-
-  InternetStackHelper internet;
-  internet.Install (n);
-
-  // link the two nodes
-  Ptr<SimpleNetDevice> txDev = CreateObject<SimpleNetDevice> ();
-  Ptr<SimpleNetDevice> rxDev = CreateObject<SimpleNetDevice> ();
-  txDev->SetAddress (Mac48Address ("00:00:00:00:00:01"));
-  rxDev->SetAddress (Mac48Address ("00:00:00:00:00:02"));
-  n.Get (0)->AddDevice (txDev);
-  n.Get (1)->AddDevice (rxDev);
-
-  Ptr<SimpleChannel> channel1 = CreateObject<SimpleChannel> ();
-  rxDev->SetChannel (channel1);
-  txDev->SetChannel (channel1);
-  NetDeviceContainer d;
-  d.Add (txDev);
-  d.Add (rxDev);
+  IcmpTopology topology (IcmpTopology::CHAIN, 3);
+  topology.SetChannel (g_channel);
+  topology.Build ();
+  Probe (topology);
 
-  Ipv6AddressHelper ipv6;
+  printf("Finalizando IcmpV6EchoReplyTestCase!\n\n");
+  Simulator::Destroy ();
+}
 
-  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
-  Ipv6InterfaceContainer i = ipv6.Assign (d);
 
+void
+IcmpV6EchoReplyTestCase::Probe (IcmpTopology &topology)
+{
   Ptr<Socket> socket;
-  socket = Socket::CreateSocket (n.Get (0), TypeId::LookupByName ("ns3::Ipv6RawSocketFactory"));
+  socket = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv6RawSocketFactory"));
   socket->SetAttribute ("Protocol", UintegerValue (Ipv6Header::IPV6_ICMPV6));
   socket->SetRecvCallback (MakeCallback (&IcmpV6EchoReplyTestCase::ReceivePkt, this));
 
@@ -478,16 +689,12 @@ IcmpV6EchoReplyTestCase::DoRun ()
   
   if(socket->Bind (src) != 0){
     printf("Falha ao efetuar socket bind\n\n");
-    printf("Finalizando IcmpV6EchoReplyTestCase\n\n");
     return;
   }
 
   socket->SetIpTtl (1);
 
-  SendData (socket, i.GetAddress (1,1));
-
-  printf("Finalizando IcmpV6EchoReplyTestCase!\n\n");
-  Simulator::Destroy ();
+  SendData (socket, topology.GetIpv6Address (0, 1));
 }
 
 
@@ -503,6 +710,7 @@ public:
   void SendData (Ptr<Socket> socket, Ipv6Address dst);
   void DoSendData (Ptr<Socket> socket, Ipv6Address dst);
   void ReceivePkt (Ptr<Socket> socket);
+  void Probe (IcmpTopology &topology);
 
 public:
   virtual void DoRun (void);
@@ -526,7 +734,7 @@ IcmpV6TimeExceedTestCase::~IcmpV6TimeExceedTestCase ()
 void
 IcmpV6TimeExceedTestCase::DoSendData (Ptr<Socket> socket, Ipv6Address dst)
 {
-  Ptr<Packet> p = Create<Packet> ();
+  Ptr<Packet> p = CreateSendStamp ();
   Icmpv6Echo echo (1);
   echo.SetSeq (1);
   echo.SetId (0XB1ED);
@@ -541,9 +749,7 @@ IcmpV6TimeExceedTestCase::DoSendData (Ptr<Socket> socket, Ipv6Address dst)
 
   socket->SendTo (p, 0, realTo);
 
-  printf("Pacote Enviado: \n");
-  p->Print(std::cout);
-  printf("\n\n");
+  TracePacket ("Pacote Enviado: \n", IcmpEventLog::SENT, 6, socket, p);
 
 }
 
@@ -553,6 +759,7 @@ IcmpV6TimeExceedTestCase::SendData (Ptr<Socket> socket, Ipv6Address dst)
 {
   Simulator::ScheduleWithContext (socket->GetNode ()->GetId (), Seconds (0),
                                   &IcmpV6TimeExceedTestCase::DoSendData, this, socket, dst);
+  DeliveryDigest digest;
   Simulator::Run ();
 }
 
@@ -562,16 +769,20 @@ IcmpV6TimeExceedTestCase::ReceivePkt (Ptr <Socket> socket)
   Address from;
   Ptr<Packet> p = socket->RecvFrom (from);
 
-  printf("Pacote recebido:\n");
-  p->Print(std::cout);
-  printf("\n\n");
+  TracePacket ("Pacote recebido:\n", IcmpEventLog::RECEIVED, 6, socket, p);
 
   if (Inet6SocketAddress::IsMatchingType (from))
     {
 
-      Ipv6Header ipv6;
-      p->RemoveHeader (ipv6);
-      if(ipv6.GetNextHeader () != Ipv6Header::IPV6_ICMPV6){
+      // the ICMPv6 header may sit behind extension headers
+      uint8_t ipv6Bytes[Ipv6ExtensionChain::WINDOW];
+      Ipv6ExtensionChain ipv6;
+      if (ipv6.Walk (ipv6Bytes, p->CopyData (ipv6Bytes, sizeof (ipv6Bytes))) != Ipv6ExtensionChain::CHAIN_OK){
+        printf("O pacote recebido não é um pacote IPv6 válido\n\n");
+        return;
+      }
+      p->RemoveAtStart (ipv6.GetUpperLayerOffset ());
+      if(ipv6.GetProtocol () != Ipv6Header::IPV6_ICMPV6){
         printf("O pacote recebido não é um pacote ICMPV6\n\n");
       }
   
@@ -589,7 +800,18 @@ IcmpV6TimeExceedTestCase::ReceivePkt (Ptr <Socket> socket)
         {
           if((int) icmpv6.GetType () != Icmpv6Header::ICMPV6_ERROR_TIME_EXCEEDED){
             printf("O pacote recebido não é um pacote ICMPV6 Time Exceeded\n\n");
+            return;
           }
+          // o erro cita a sonda inteira, depois de 4 bytes não usados
+          uint8_t quoted[4 + Ipv6HeaderView::SIZE];
+          if (p->CopyData (quoted, sizeof (quoted)) == sizeof (quoted))
+            {
+              Ipv6HeaderView probe (quoted + 4, Ipv6HeaderView::SIZE);
+              if (probe.IsValid ())
+                {
+                  RecordRtt (probe.GetDestinationAddress (), p);
+                }
+            }
         }
     }
 }
@@ -598,64 +820,34 @@ void
 IcmpV6TimeExceedTestCase::DoRun ()
 {
 	printf("Iniciando IcmpV6TimeExceedTestCase: \n\n");
-  NodeContainer n, n0n1,n1n2;
-  n.Create (3);
-  n0n1.Add (n.Get (0));
-  n0n1.Add (n.Get (1));
-  n1n2.Add (n.Get (1));
-  n1n2.Add (n.Get (2));
-
-  Ptr<SimpleChannel> channel = CreateObject <SimpleChannel> ();
-  Ptr<SimpleChannel> channel2 = CreateObject <SimpleChannel> ();
-
-  SimpleNetDeviceHelper simpleHelper;
-  simpleHelper.SetNetDevicePointToPointMode (true);
-
-  SimpleNetDeviceHelper simpleHelper2;
-  simpleHelper2.SetNetDevicePointToPointMode (true);
-
-  NetDeviceContainer devices;
-  devices = simpleHelper.Install (n0n1,channel);
-
-  NetDeviceContainer devices2;
-  devices2 = simpleHelper2.Install (n1n2,channel2);
-
-  InternetStackHelper internet;
-  internet.Install (n);
-
-  Ipv6AddressHelper address;
-
-  address.NewNetwork ();
-  address.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  IcmpTopology topology (IcmpTopology::CHAIN, 3);
+  topology.SetChannel (g_channel);
+  topology.Build ();
+  Probe (topology);
 
-  Ipv6InterfaceContainer interfaces = address.Assign (devices);
-  interfaces.SetForwarding (1,true);
-  interfaces.SetDefaultRouteInAllNodes (1);
-  address.SetBase (Ipv6Address ("2001:2::"), Ipv6Prefix (64));
-  Ipv6InterfaceContainer interfaces2 = address.Assign (devices2);
+  printf("Finalizando IcmpV6TimeExceedTestCase!\n\n");
+  Simulator::Destroy ();
+}
 
-  interfaces2.SetForwarding (0,true);
-  interfaces2.SetDefaultRouteInAllNodes (0);
 
+void
+IcmpV6TimeExceedTestCase::Probe (IcmpTopology &topology)
+{
   Ptr<Socket> socket;
-  socket = Socket::CreateSocket (n.Get (0), TypeId::LookupByName ("ns3::Ipv6RawSocketFactory"));
+  socket = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv6RawSocketFactory"));
   socket->SetAttribute ("Protocol", UintegerValue (Ipv6Header::IPV6_ICMPV6));
   socket->SetRecvCallback (MakeCallback (&IcmpV6TimeExceedTestCase::ReceivePkt, this));
 
   Inet6SocketAddress src = Inet6SocketAddress (Ipv6Address::GetAny (), 0);
   if(socket->Bind (src) != 0){
     printf("Falha ao efetuar socket bind\n\n");
-    printf("Finalizando IcmpV6TimeExceedTestCase\n\n");
     return;
   }
 
   // O TTL (Hop Limit) deve ser pequeno o suficiente para causa uma resposta ICMPV6 Time Exceeded
   socket->SetIpv6HopLimit (1);
 
-  SendData (socket, interfaces2.GetAddress (1,1));
-
-  printf("Finalizando IcmpV6TimeExceedTestCase!\n\n");
-  Simulator::Destroy ();
+  SendData (socket, topology.GetIpv6Address (1, 1));
 }
 
 /**
@@ -712,9 +904,7 @@ IcmpDestinationUnreachableTestCase::DoSendData (Ptr<Socket> socket, Ipv4Address
     return;
   }
 
-  printf("Pacote Enviado: \n");
-  p->Print(std::cout);
-  printf("\n \n");
+  TracePacket ("Pacote Enviado: \n", IcmpEventLog::SENT, 4, socket, p);
 
 }
 
@@ -725,6 +915,7 @@ IcmpDestinationUnreachableTestCase::SendData (Ptr<Socket> socket, Ipv4Address ds
   Simulator::ScheduleWithContext (socket->GetNode ()->GetId (), Seconds (0),
                                   &IcmpDestinationUnreachableTestCase::DoSendData, this, socket, dst);
 
+  DeliveryDigest digest;
   Simulator::Run ();
 }
 
@@ -735,12 +926,15 @@ IcmpDestinationUnreachableTestCase::ReceivePkt (Ptr<Socket> socket)
   Address from;
   Ptr<Packet> p = socket->RecvFrom (0xffffffff, 0, from);
 
-  printf("Pacote Recebido: \n");
-  p->Print(std::cout);
-  printf("\n\n");
+  TracePacket ("Pacote Recebido: \n", IcmpEventLog::RECEIVED, 4, socket, p);
 
-  Ipv4Header ipv4;
-  p->RemoveHeader (ipv4);
+  uint8_t ipv4Bytes[Ipv4HeaderView::MAX_SIZE];
+  Ipv4HeaderView ipv4 (ipv4Bytes, p->CopyData (ipv4Bytes, sizeof (ipv4Bytes)));
+  if(!ipv4.IsValid ()){
+    printf("O pacote recebido não é um pacote IPv4 válido\n\n");
+    return;
+  }
+  p->RemoveAtStart (ipv4.GetHeaderSize ());
   if(ipv4.GetProtocol () != 1){
     printf("O pacote recebido não é um pacote ICMP\n\n");
   }
@@ -764,8 +958,8 @@ IcmpDestinationUnreachableTestCase::DoRun ()
   n1n2.Add (n.Get (2));
   n1n2.Add (n.Get (3));
 
-  Ptr<SimpleChannel> channel = CreateObject <SimpleChannel> ();
-  Ptr<SimpleChannel> channel2 = CreateObject <SimpleChannel> ();
+  Ptr<SimpleChannel> channel = g_channel.Create<SimpleChannel> ();
+  Ptr<SimpleChannel> channel2 = g_channel.Create<SimpleChannel> ();
 
   SimpleNetDeviceHelper simpleHelper;
   simpleHelper.SetNetDevicePointToPointMode (true);
@@ -824,6 +1018,7 @@ public:
   void SendData (Ptr<Socket> socket, Ipv6Address dst);
   void DoSendData (Ptr<Socket> socket, Ipv6Address dst);
   void ReceivePkt (Ptr<Socket> socket);
+  void Probe (IcmpTopology &topology);
 
 public:
   virtual void DoRun (void);
@@ -847,7 +1042,7 @@ IcmpV6DestinationUnreachableTestCase::~IcmpV6DestinationUnreachableTestCase ()
 void
 IcmpV6DestinationUnreachableTestCase::DoSendData (Ptr<Socket> socket, Ipv6Address dst)
 {
-  Ptr<Packet> p = Create<Packet> ();
+  Ptr<Packet> p = CreateSendStamp ();
   Icmpv6Echo echo (1);
   echo.SetSeq (1);
   echo.SetId (0XB1ED);
@@ -862,9 +1057,7 @@ IcmpV6DestinationUnreachableTestCase::DoSendData (Ptr<Socket> socket, Ipv6Addres
 
   socket->SendTo (p, 0, realTo); 
 
-  printf("Pacote Enviado:\n");
-  p->Print(std::cout);
-  printf("\n\n");
+  TracePacket ("Pacote Enviado:\n", IcmpEventLog::SENT, 6, socket, p);
 
 }
 
@@ -874,6 +1067,7 @@ IcmpV6DestinationUnreachableTestCase::SendData (Ptr<Socket> socket, Ipv6Address
 {
   Simulator::ScheduleWithContext (socket->GetNode ()->GetId (), Seconds (0),
                                   &IcmpV6DestinationUnreachableTestCase::DoSendData, this, socket, dst);
+  DeliveryDigest digest;
   Simulator::Run ();
 }
 
@@ -883,18 +1077,22 @@ IcmpV6DestinationUnreachableTestCase::ReceivePkt (Ptr <Socket> socket)
   Address from;
   Ptr<Packet> p = socket->RecvFrom (from);
 
-  printf("Pacote recebido:\n");
-  p->Print(std::cout);
-  printf("\n\n");
+  TracePacket ("Pacote recebido:\n", IcmpEventLog::RECEIVED, 6, socket, p);
 
   if (Inet6SocketAddress::IsMatchingType (from))
     {
 
 
-      Ipv6Header ipv6;
-      p->RemoveHeader (ipv6);
+      // the ICMPv6 header may sit behind extension headers
+      uint8_t ipv6Bytes[Ipv6ExtensionChain::WINDOW];
+      Ipv6ExtensionChain ipv6;
+      if (ipv6.Walk (ipv6Bytes, p->CopyData (ipv6Bytes, sizeof (ipv6Bytes))) != Ipv6ExtensionChain::CHAIN_OK){
+        printf("O pacote recebido não é um pacote IPv6 válido\n\n");
+        return;
+      }
+      p->RemoveAtStart (ipv6.GetUpperLayerOffset ());
 
-      if(ipv6.GetNextHeader () != Ipv6Header::IPV6_ICMPV6){
+      if(ipv6.GetProtocol () != Ipv6Header::IPV6_ICMPV6){
         printf("O pacote recebido não é um pacote ICMPV6\n\n");
       }
 
@@ -911,7 +1109,18 @@ IcmpV6DestinationUnreachableTestCase::ReceivePkt (Ptr <Socket> socket)
         {  
           if((int) icmpv6.GetType () != Icmpv6Header::ICMPV6_ERROR_DESTINATION_UNREACHABLE){
             printf("O pacote recebido não é um pacote ICMPV6 Destination Unreachable\n\n");
+            return;
           }
+          // o erro cita a sonda inteira, depois de 4 bytes não usados
+          uint8_t quoted[4 + Ipv6HeaderView::SIZE];
+          if (p->CopyData (quoted, sizeof (quoted)) == sizeof (quoted))
+            {
+              Ipv6HeaderView probe (quoted + 4, Ipv6HeaderView::SIZE);
+              if (probe.IsValid ())
+                {
+                  RecordRtt (probe.GetDestinationAddress (), p);
+                }
+            }
         }
     }
 }
@@ -920,47 +1129,22 @@ void
 IcmpV6DestinationUnreachableTestCase::DoRun ()
 {
 	printf("Iniciando IcmpV6DestinationUnreachableTestCase: \n\n");
-  NodeContainer n, n0n1,n1n2;
-  n.Create (3);
-  n0n1.Add (n.Get (0));
-  n0n1.Add (n.Get (1));
-  n1n2.Add (n.Get (1));
-  n1n2.Add (n.Get (2));
-
-  Ptr<SimpleChannel> channel = CreateObject <SimpleChannel> ();
-  Ptr<SimpleChannel> channel2 = CreateObject <SimpleChannel> ();
-
-  SimpleNetDeviceHelper simpleHelper;
-  simpleHelper.SetNetDevicePointToPointMode (true);
-
-  SimpleNetDeviceHelper simpleHelper2;
-  simpleHelper2.SetNetDevicePointToPointMode (true);
-
-  NetDeviceContainer devices;
-  devices = simpleHelper.Install (n0n1,channel);
-
-  NetDeviceContainer devices2;
-  devices2 = simpleHelper2.Install (n1n2,channel2);
+  IcmpTopology topology (IcmpTopology::CHAIN, 3);
+  topology.SetChannel (g_channel);
+  topology.Build ();
+  Probe (topology);
 
-  InternetStackHelper internet;
-  internet.Install (n);
-
-  Ipv6AddressHelper address;
+  printf("Finalizando IcmpV6DestinationUnreachableTestCase!\n\n");
 
-  address.NewNetwork ();
+  Simulator::Destroy ();
+}
 
-  address.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
-  Ipv6InterfaceContainer interfaces = address.Assign (devices);
-  interfaces.SetForwarding (1,true);
-  interfaces.SetDefaultRouteInAllNodes (1);
-   
-  address.SetBase (Ipv6Address ("2001:2::"), Ipv6Prefix (64));
-  Ipv6InterfaceContainer interfaces2 = address.Assign (devices2);
-  interfaces2.SetForwarding (0,true);
-  interfaces2.SetDefaultRouteInAllNodes (0);
 
+void
+IcmpV6DestinationUnreachableTestCase::Probe (IcmpTopology &topology)
+{
   Ptr<Socket> socket;
-  socket = Socket::CreateSocket (n.Get (0), TypeId::LookupByName ("ns3::Ipv6RawSocketFactory"));
+  socket = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv6RawSocketFactory"));
   socket->SetAttribute ("Protocol", UintegerValue (Ipv6Header::IPV6_ICMPV6));
   socket->SetRecvCallback (MakeCallback (&IcmpV6DestinationUnreachableTestCase::ReceivePkt, this));
 
@@ -972,37 +1156,1385 @@ IcmpV6DestinationUnreachableTestCase::DoRun ()
 
   socket->SetIpv6HopLimit (64);
 
-  SendData (socket, Ipv6Address("2001:2::200:ff:fe00:5"));
-
-  printf("Finalizando IcmpV6DestinationUnreachableTestCase!\n\n");
-
-  Simulator::Destroy ();
+  // nenhum nó tem este endereço no segundo enlace
+  SendData (socket, topology.GetIpv6Host (1, 5));
 }
 
-int main (int argc, char *argv[])
+
+/**
+ * \brief ICMP and ICMPV6 traceroute test
+ *
+ * Traces the chain over IPv4 and IPv6, and the path towards an IPv6
+ * address nobody has, which ends in a Destination Unreachable. All the
+ * probes of a trace leave in one burst.
+ */
+class IcmpTracerouteTestCase : public TestCase
 {
-  printf("\n\t Início das simulações\n\n");
+public:
+  IcmpTracerouteTestCase ();
+  virtual ~IcmpTracerouteTestCase ();
 
-	Packet::EnablePrinting();
+  void Probe (IcmpTopology &topology);
 
-  IcmpEchoReplyTestCase icmp;
-  icmp.DoRun();
+public:
+  virtual void DoRun (void);
 
-  IcmpV6EchoReplyTestCase icmpv6;
-  icmpv6.DoRun();
+};
 
-  IcmpTimeExceedTestCase timeExceed;
-  timeExceed.DoRun();
 
-  IcmpV6TimeExceedTestCase timeExceedV6;
-  timeExceedV6.DoRun();
+IcmpTracerouteTestCase::IcmpTracerouteTestCase ()
+  : TestCase ("ICMP:Traceroute test case")
+{
 
-  IcmpDestinationUnreachableTestCase destinationUnreachable;
-  destinationUnreachable.DoRun();
+}
 
-  IcmpV6DestinationUnreachableTestCase destinationUnreachableV6;
-  destinationUnreachableV6.DoRun();
 
-  printf("\n\t Fim das simulações\n");
+IcmpTracerouteTestCase::~IcmpTracerouteTestCase ()
+{
+
+}
+
+
+void
+IcmpTracerouteTestCase::DoRun ()
+{
+  printf("Iniciando IcmpTracerouteTestCase... \n\n");
+  IcmpTopology topology (IcmpTopology::CHAIN, 3);
+  topology.SetChannel (g_channel);
+  topology.Build ();
+  Probe (topology);
+
+  printf("Finalizando IcmpTracerouteTestCase!\n");
+  Simulator::Destroy ();
+  printf("\n\n");
+}
+
+
+void
+IcmpTracerouteTestCase::Probe (IcmpTopology &topology)
+{
+  uint32_t last = topology.GetNLinks () - 1;
+  // cada rajada espera inteira pela resolução do primeiro vizinho
+  topology.SetPendingQueueSize (64);
+
+  Ptr<Socket> socket4 = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv4RawSocketFactory"));
+  socket4->SetAttribute ("Protocol", UintegerValue (1)); // ICMP protocol
+  Ptr<Socket> socket6 = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv6RawSocketFactory"));
+  socket6->SetAttribute ("Protocol", UintegerValue (Ipv6Header::IPV6_ICMPV6));
+  Ptr<Socket> unreachable6 = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv6RawSocketFactory"));
+  unreachable6->SetAttribute ("Protocol", UintegerValue (Ipv6Header::IPV6_ICMPV6));
+  if(socket4->Bind (InetSocketAddress (Ipv4Address::GetAny (), 0)) != 0
+     || socket6->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), 0)) != 0
+     || unreachable6->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), 0)) != 0){
+    printf("Falha ao efetuar socket bind\n\n");
+    return;
+  }
+
+  IcmpTraceroute trace4 (socket4, topology.GetIpv4Address (last, 1));
+  IcmpTraceroute trace6 (socket6, topology.GetIpv6Address (last, 1));
+  // nenhum nó tem este endereço no último enlace
+  IcmpTraceroute traceUnreachable6 (unreachable6, topology.GetIpv6Host (last, 5));
+  IcmpTraceroute *traces[] = { &trace4, &trace6, &traceUnreachable6 };
+  for (uint32_t k = 0; k < 3; k++)
+    {
+      // os sockets IPv6 recebem todas as mensagens ICMPV6
+      traces[k]->SetIdentifier (k + 1);
+      traces[k]->SetMaxTtl (last + 3);
+      traces[k]->Start ();
+    }
+  DeliveryDigest digest;
+  Simulator::Run ();
+
+  for (uint32_t k = 0; k < 3; k++)
+    {
+      traces[k]->Print (std::cout);
+      printf("\n");
+      if(traces[k]->GetPathLength () != last + 1){
+        printf("O traceroute deveria terminar no salto %u\n\n", last + 1);
+        continue;
+      }
+      for (uint32_t ttl = 1; ttl <= last + 1; ttl++)
+        {
+          IcmpTraceroute::Hop const &hop = traces[k]->GetHop (ttl);
+          // o roteador ttl responde pelo enlace à sua esquerda; o destino inalcançável, pelo último roteador
+          uint32_t link = std::min (ttl, last + (k < 2 ? 1 : 0)) - 1;
+          bool sourceOk = k == 0 ? hop.ipv4 == topology.GetIpv4Address (link, 1)
+                                 : hop.ipv6 == topology.GetIpv6Address (link, 1);
+          if(!sourceOk){
+            printf("O salto %u deveria vir do nó %u\n\n", ttl, link + 1);
+          }
+          if(hop.replies != 3){
+            printf("O salto %u respondeu a %u de 3 sondas\n\n", ttl, hop.replies);
+          }
+          IcmpTraceroute::Kind kind = ttl <= last ? IcmpTraceroute::TIME_EXCEEDED
+                                      : k < 2 ? IcmpTraceroute::ECHO_REPLY : IcmpTraceroute::UNREACHABLE;
+          if(hop.kind != kind){
+            printf("O salto %u respondeu com o tipo de mensagem errado\n\n", ttl);
+          }
+        }
+    }
+}
+
+/**
+ * \brief ICMP and ICMPV6 error rate limit test
+ *
+ * The router of the chain limits its errors to a burst of 3 per
+ * destination, earning a token every 100 ms. Two bursts of 10 probes
+ * that expire at the router, one second apart, must each get 3 Time
+ * Exceeded back, on IPv4 and on IPv6.
+ */
+class IcmpRateLimitTestCase : public TestCase
+{
+public:
+  IcmpRateLimitTestCase ();
+  virtual ~IcmpRateLimitTestCase ();
+
+  void SendBurst (Ptr<Socket> socket4, Ptr<Socket> socket6, Ipv4Address dst4, Ipv6Address dst6);
+  void ReceivePkt4 (Ptr<Socket> socket);
+  void ReceivePkt6 (Ptr<Socket> socket);
+  void Probe (IcmpTopology &topology);
+
+public:
+  virtual void DoRun (void);
+
+private:
+  static const uint32_t BURST = 10;     //!< probes per burst and family
+  static const uint32_t LIMIT = 3;      //!< errors the router sends per burst and family
+  IcmpRateLimit m_limit;                //!< the limit of the router, outlives the simulation
+  uint32_t m_timeExceeded4;             //!< ICMP Time Exceeded received
+  uint32_t m_timeExceeded6;             //!< ICMPv6 Time Exceeded received
+};
+
+
+IcmpRateLimitTestCase::IcmpRateLimitTestCase ()
+  : TestCase ("ICMP:RateLimit test case"),
+    m_limit (MilliSeconds (100), LIMIT),
+    m_timeExceeded4 (0),
+    m_timeExceeded6 (0)
+{
+
+}
+
+
+IcmpRateLimitTestCase::~IcmpRateLimitTestCase ()
+{
+
+}
+
+
+void
+IcmpRateLimitTestCase::SendBurst (Ptr<Socket> socket4, Ptr<Socket> socket6, Ipv4Address dst4, Ipv6Address dst6)
+{
+  for (uint32_t k = 0; k < BURST; k++)
+    {
+      Ptr<Packet> p = Create<Packet> ();
+      Icmpv4Echo echo;
+      echo.SetIdentifier (5);
+      echo.SetSequenceNumber (k);
+      p->AddHeader (echo);
+      Icmpv4Header header;
+      header.SetType (Icmpv4Header::ICMPV4_ECHO);
+      header.SetCode (0);
+      p->AddHeader (header);
+      if(socket4->SendTo (p, 0, InetSocketAddress (dst4, 0)) != (int) p->GetSize ()){
+        printf("Falha ao enviar Pacote ICMP Echo request\n\n");
+        return;
+      }
+      TracePacket ("Pacote Enviado: \n", IcmpEventLog::SENT, 4, socket4, p);
+
+      Ptr<Packet> p6 = Create<Packet> ();
+      Icmpv6Echo echo6 (1);
+      echo6.SetId (5);
+      echo6.SetSeq (k);
+      p6->AddHeader (echo6);
+      if(socket6->SendTo (p6, 0, Inet6SocketAddress (dst6, 0)) != (int) p6->GetSize ()){
+        printf("Falha ao enviar Pacote ICMPV6 Echo request\n\n");
+        return;
+      }
+      TracePacket ("Pacote Enviado: \n", IcmpEventLog::SENT, 6, socket6, p6);
+    }
+}
+
+
+void
+IcmpRateLimitTestCase::ReceivePkt4 (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()))
+    {
+      TracePacket ("Pacote Recebido: \n", IcmpEventLog::RECEIVED, 4, socket, p);
+      uint8_t bytes[Ipv4HeaderView::MAX_SIZE + 1];
+      uint32_t size = p->CopyData (bytes, sizeof (bytes));
+      Ipv4HeaderView ipv4 (bytes, size);
+      if(ipv4.IsValid () && ipv4.GetProtocol () == 1 && size > ipv4.GetHeaderSize ()
+         && bytes[ipv4.GetHeaderSize ()] == Icmpv4Header::ICMPV4_TIME_EXCEEDED){
+        m_timeExceeded4++;
+      }
+    }
+}
+
+
+void
+IcmpRateLimitTestCase::ReceivePkt6 (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()))
+    {
+      uint8_t bytes[Ipv6ExtensionChain::WINDOW];
+      uint32_t size = p->CopyData (bytes, sizeof (bytes));
+      Ipv6ExtensionChain ipv6;
+      // o socket IPv6 recebe também a descoberta de vizinhos
+      if(ipv6.Walk (bytes, size) == Ipv6ExtensionChain::CHAIN_OK && ipv6.GetProtocol () == Ipv6Header::IPV6_ICMPV6
+         && size > ipv6.GetUpperLayerOffset ()
+         && bytes[ipv6.GetUpperLayerOffset ()] == Icmpv6Header::ICMPV6_ERROR_TIME_EXCEEDED){
+        TracePacket ("Pacote Recebido: \n", IcmpEventLog::RECEIVED, 6, socket, p);
+        m_timeExceeded6++;
+      }
+    }
+}
+
+
+void
+IcmpRateLimitTestCase::DoRun ()
+{
+  printf("Iniciando IcmpRateLimitTestCase... \n\n");
+  IcmpTopology topology (IcmpTopology::CHAIN, 3);
+  topology.SetChannel (g_channel);
+  topology.Build ();
+  Probe (topology);
+
+  printf("Finalizando IcmpRateLimitTestCase!\n");
+  Simulator::Destroy ();
+  printf("\n\n");
+}
+
+
+void
+IcmpRateLimitTestCase::Probe (IcmpTopology &topology)
+{
+  uint32_t last = topology.GetNLinks () - 1;
+  // cada rajada espera inteira pela resolução do primeiro vizinho
+  topology.SetPendingQueueSize (2 * BURST);
+  m_limit.Install (topology.GetNode (1));
+
+  Ptr<Socket> socket4 = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv4RawSocketFactory"));
+  socket4->SetAttribute ("Protocol", UintegerValue (1)); // ICMP protocol
+  Ptr<Socket> socket6 = topology.CreateSocket (0, TypeId::LookupByName ("ns3::Ipv6RawSocketFactory"));
+  socket6->SetAttribute ("Protocol", UintegerValue (Ipv6Header::IPV6_ICMPV6));
+  if(socket4->Bind (InetSocketAddress (Ipv4Address::GetAny (), 0)) != 0
+     || socket6->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), 0)) != 0){
+    printf("Falha ao efetuar socket bind\n\n");
+    return;
+  }
+  socket4->SetRecvCallback (MakeCallback (&IcmpRateLimitTestCase::ReceivePkt4, this));
+  socket6->SetRecvCallback (MakeCallback (&IcmpRateLimitTestCase::ReceivePkt6, this));
+  // as sondas expiram no roteador, o nó 1
+  socket4->SetIpTtl (1);
+  socket6->SetIpv6HopLimit (1);
+
+  Ipv4Address dst4 = topology.GetIpv4Address (last, 1);
+  Ipv6Address dst6 = topology.GetIpv6Address (last, 1);
+  for (uint32_t burst = 0; burst < 2; burst++)
+    {
+      Simulator::ScheduleWithContext (socket4->GetNode ()->GetId (), Seconds (burst),
+                                      &IcmpRateLimitTestCase::SendBurst, this, socket4, socket6, dst4, dst6);
+    }
+  DeliveryDigest digest;
+  Simulator::Run ();
+
+  if(m_timeExceeded4 != 2 * LIMIT){
+    printf("Recebidas %u mensagens ICMP Time Exceeded, esperadas %u\n\n", m_timeExceeded4, 2 * LIMIT);
+  }
+  if(m_timeExceeded6 != 2 * LIMIT){
+    printf("Recebidas %u mensagens ICMPV6 Time Exceeded, esperadas %u\n\n", m_timeExceeded6, 2 * LIMIT);
+  }
+  if(m_limit.GetSuppressed () != 4 * (BURST - LIMIT)){
+    printf("O roteador suprimiu %u mensagens de erro, esperadas %u\n\n",
+           static_cast<uint32_t> (m_limit.GetSuppressed ()), 4 * (BURST - LIMIT));
+  }
+}
+
+namespace {
+
+/**
+ * \brief Run a test case with the global simulator.
+ * \tparam T the test case class
+ */
+template <typename T>
+void
+RunCaseOf (void)
+{
+  T testCase;
+  testCase.DoRun ();
+}
+
+/**
+ * \tparam T the test case class
+ * \returns the test case name
+ */
+template <typename T>
+std::string
+GetCaseNameOf (void)
+{
+  T testCase;
+  return testCase.GetName ();
+}
+
+/**
+ * \brief Run the probe of a test case against a shared topology.
+ * \tparam T the test case class
+ * \param topology the topology, reset by the caller
+ */
+template <typename T>
+void
+ProbeCaseOf (IcmpTopology &topology)
+{
+  T testCase;
+  testCase.Probe (topology);
+}
+
+/**
+ * \brief A test case main can run.
+ */
+struct Case
+{
+  void (*run) (void);                   //!< runs the case
+  std::string (*name) (void);           //!< returns the case name
+  void (*probe) (IcmpTopology &);       //!< runs the case on a 3-node chain, 0 if it needs its own topology
+};
+
+/// The test cases, in the order main always ran them.
+const Case CASES[] = {
+  { &RunCaseOf<IcmpEchoReplyTestCase>, &GetCaseNameOf<IcmpEchoReplyTestCase>,
+    &ProbeCaseOf<IcmpEchoReplyTestCase> },
+  { &RunCaseOf<IcmpV6EchoReplyTestCase>, &GetCaseNameOf<IcmpV6EchoReplyTestCase>,
+    &ProbeCaseOf<IcmpV6EchoReplyTestCase> },
+  { &RunCaseOf<IcmpTimeExceedTestCase>, &GetCaseNameOf<IcmpTimeExceedTestCase>,
+    &ProbeCaseOf<IcmpTimeExceedTestCase> },
+  { &RunCaseOf<IcmpV6TimeExceedTestCase>, &GetCaseNameOf<IcmpV6TimeExceedTestCase>,
+    &ProbeCaseOf<IcmpV6TimeExceedTestCase> },
+  // two disconnected links, not a chain
+  { &RunCaseOf<IcmpDestinationUnreachableTestCase>, &GetCaseNameOf<IcmpDestinationUnreachableTestCase>, 0 },
+  { &RunCaseOf<IcmpV6DestinationUnreachableTestCase>, &GetCaseNameOf<IcmpV6DestinationUnreachableTestCase>,
+    &ProbeCaseOf<IcmpV6DestinationUnreachableTestCase> },
+  { &RunCaseOf<IcmpTracerouteTestCase>, &GetCaseNameOf<IcmpTracerouteTestCase>,
+    &ProbeCaseOf<IcmpTracerouteTestCase> },
+  // limits the errors of the router for good, not on a shared chain
+  { &RunCaseOf<IcmpRateLimitTestCase>, &GetCaseNameOf<IcmpRateLimitTestCase>, 0 }
+};
+
+/**
+ * \brief Link parameters the cases run with.
+ */
+struct Link
+{
+  double loss;     //!< loss rate
+  uint32_t delay;  //!< delay in microseconds
+  uint32_t jitter; //!< largest jitter in microseconds
+};
+
+/// Link parameters of the matrix: every case runs with each of them.
+std::vector<Link> g_links;
+
+/**
+ * \brief Make the cases build their links with the given parameters.
+ *
+ * Links with no loss and no jitter are plain SimpleChannels, exactly as
+ * the cases always had them; the others are LossyChannels.
+ *
+ * \param link the link parameters
+ */
+void
+SelectLink (Link const &link)
+{
+  bool lossy = link.loss > 0 || link.jitter > 0;
+  g_channel = ObjectFactory (lossy ? "ns3::LossyChannel" : "ns3::SimpleChannel");
+  g_channel.Set ("Delay", TimeValue (MicroSeconds (link.delay)));
+  if (lossy)
+    {
+      g_channel.Set ("LossRate", DoubleValue (link.loss));
+      g_channel.Set ("Jitter", TimeValue (MicroSeconds (link.jitter)));
+    }
+}
+
+/**
+ * \param link link parameters
+ * \returns what tells a case run with them apart, empty for the default links
+ */
+std::string
+GetLinkName (Link const &link)
+{
+  if (link.loss == 0 && link.delay == 0 && link.jitter == 0)
+    {
+      return "";
+    }
+  std::ostringstream os;
+  os << " [loss " << link.loss << ", delay " << link.delay << " us, jitter " << link.jitter << " us]";
+  return os.str ();
+}
+
+/**
+ * \brief Parse a comma-separated list of non-negative numbers.
+ * \param text the list
+ * \param option the option it came from, for errors
+ * \returns the numbers
+ */
+std::vector<double>
+ParseList (std::string const &text, std::string const &option)
+{
+  std::vector<double> values;
+  std::istringstream is (text);
+  std::string item;
+  while (std::getline (is, item, ','))
+    {
+      std::istringstream field (item);
+      double value;
+      NS_ABORT_MSG_UNLESS ((field >> value) && value >= 0, "Bad --" << option << " value \"" << item << "\"");
+      values.push_back (value);
+    }
+  NS_ABORT_MSG_IF (values.empty (), "--" << option << " lists no value");
+  return values;
+}
+
+/**
+ * \brief Run one test case with the global simulator.
+ * \param index the index of the case in CASES
+ * \param run the RNG run number
+ * \param link the index of its link parameters in g_links
+ */
+void
+RunCase (uint32_t index, uint32_t run, uint32_t link)
+{
+  RngSeedManager::SetRun (run);
+  SelectLink (g_links[link]);
+  g_sent = 0;
+  g_received = 0;
+  g_dropped = 0;
+  CASES[index].run ();
+}
+
+/**
+ * \returns a monotonic timestamp in nanoseconds
+ */
+uint64_t
+NowNs (void)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+           (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+/// File the RTT histograms of every process are appended to, -1 if none.
+int g_histogramFd = -1;
+/// Whether SaveHistograms and SaveEvents write, false while a baseline matrix runs.
+bool g_saveRecords = true;
+
+/**
+ * \brief Append the RTT histograms of this process to the histogram file.
+ *
+ * Each process writes all its lines at once to a file opened with
+ * O_APPEND, so the lines of concurrent workers do not interleave.
+ */
+void
+SaveHistograms (void)
+{
+  std::ostringstream os;
+  for (std::map<std::string, LatencyHistogram>::const_iterator it = g_rtt.begin (); it != g_rtt.end (); it++)
+    {
+      os << it->first << " ";
+      it->second.Serialize (os);
+      os << "\n";
+    }
+  g_rtt.clear ();
+  std::string text = os.str ();
+  if (g_histogramFd < 0 || !g_saveRecords || text.empty ())
+    {
+      return;
+    }
+  if (write (g_histogramFd, text.data (), text.size ()) != static_cast<ssize_t> (text.size ()))
+    {
+      std::cerr << "Cannot save the RTT histograms" << std::endl;
+    }
+}
+
+/// Exit status of a worker whose trace digest is not the golden one.
+const int DIGEST_MISMATCH = 3;
+/// Exit status of a worker whose scenario has no golden digest to check.
+const int DIGEST_UNCHECKED = 4;
+/// Golden trace digests, by GetDigestKey.
+std::map<std::string, uint64_t> g_golden;
+/// File the digests are written to with --record, -1 when comparing.
+int g_goldenFd = -1;
+
+/**
+ * \param name what ran
+ * \param run the RNG run number
+ * \returns the key of its digest in the golden file
+ */
+std::string
+GetDigestKey (std::string const &name, uint32_t run)
+{
+  std::ostringstream key;
+  key << run << " " << name;
+  return key.str ();
+}
+
+/**
+ * \brief Load the golden digests.
+ * \param path the golden file, lines of "<digest> <run> <case name>"
+ */
+void
+LoadGolden (std::string const &path)
+{
+  std::ifstream is (path.c_str ());
+  if (!is)
+    {
+      std::cerr << "No golden file " << path << ": no trace digest will be checked,"
+                << " record one with --record" << std::endl;
+      return;
+    }
+  std::string line;
+  while (std::getline (is, line))
+    {
+      std::istringstream fields (line);
+      std::string digest;
+      uint32_t run;
+      std::string name;
+      if (!(fields >> digest >> run) || !std::getline (fields >> std::ws, name) || digest.size () != 16)
+        {
+          std::cerr << "Skipping the malformed golden line \"" << line << "\"" << std::endl;
+          continue;
+        }
+      g_golden[GetDigestKey (name, run)] = std::stoull (digest, 0, 16);
+    }
+}
+
+/**
+ * \brief Check the trace digest of what just ran against the golden one, and reset it.
+ *
+ * With --record the digest is written to the golden file instead, as
+ * the new golden value. A scenario with no golden digest is reported as
+ * unchecked, not as passing.
+ *
+ * \param name what ran
+ * \param run the RNG run number
+ * \returns 0 if the digest is the golden one or was recorded,
+ *          DIGEST_MISMATCH or DIGEST_UNCHECKED otherwise
+ */
+int
+CheckDigest (std::string const &name, uint32_t run)
+{
+  uint64_t digest = g_digest.GetDigest ();
+  uint64_t packets = g_digest.GetPackets ();
+  g_digest.Reset ();
+  std::string key = GetDigestKey (name, run);
+  std::cout << "trace digest " << TraceDigest::ToString (digest) << " over " << packets << " packets" << std::endl;
+  if (g_goldenFd >= 0)
+    {
+      std::string line = TraceDigest::ToString (digest) + " " + key + "\n";
+      if (g_saveRecords && write (g_goldenFd, line.data (), line.size ()) != static_cast<ssize_t> (line.size ()))
+        {
+          std::cerr << "Cannot record the digest of " << name << std::endl;
+        }
+      return 0;
+    }
+  std::map<std::string, uint64_t>::const_iterator it = g_golden.find (key);
+  if (it == g_golden.end ())
+    {
+      std::cout << "no golden digest for " << name << ", run " << run << ", not checked" << std::endl;
+      return DIGEST_UNCHECKED;
+    }
+  if (it->second != digest)
+    {
+      std::cout << "DIGEST MISMATCH for " << name << ", run " << run << ": golden "
+                << TraceDigest::ToString (it->second) << std::endl;
+      return DIGEST_MISMATCH;
+    }
   return 0;
 }
+
+/**
+ * \brief Say how many digests had no golden value, if any.
+ * \param unchecked number of digests without a golden value
+ */
+void
+PrintUnchecked (uint32_t unchecked)
+{
+  if (unchecked > 0)
+    {
+      std::cout << "NOT CHECKED: " << unchecked << " trace digests have no golden value,"
+                << " --record writes them to the golden file" << std::endl;
+    }
+}
+
+/**
+ * \param failed number of failed runs or digest mismatches
+ * \param unchecked number of digests without a golden value
+ * \returns the exit status of the runner: 1 if anything failed,
+ *          DIGEST_UNCHECKED if some digests were not checked, 0 otherwise
+ */
+int
+GetExitStatus (uint32_t failed, uint32_t unchecked)
+{
+  if (failed > 0)
+    {
+      return 1;
+    }
+  return unchecked > 0 ? DIGEST_UNCHECKED : 0;
+}
+
+/// File the event logs of every process are appended to in quiet mode, -1 if none.
+int g_eventsFd = -1;
+
+/**
+ * \brief Append the event log of this process to the event file, as one block.
+ * \param name what ran
+ * \param run the RNG run number
+ */
+void
+SaveEvents (std::string const &name, uint32_t run)
+{
+  if (g_events == 0)
+    {
+      return;
+    }
+  if (!g_saveRecords)
+    {
+      g_events->Clear ();
+      return;
+    }
+  if (g_events->GetRecorded () > g_events->GetStored ())
+    {
+      std::cerr << name << ": the event ring dropped its " << g_events->GetRecorded () - g_events->GetStored ()
+                << " oldest events, raise --eventCapacity" << std::endl;
+    }
+  if (!g_events->Flush (g_eventsFd, name, run))
+    {
+      std::cerr << "Cannot save the event log of " << name << std::endl;
+    }
+}
+
+/**
+ * \brief Merge the histograms of the histogram file per destination and print them.
+ */
+void
+PrintHistograms (void)
+{
+  std::string text;
+  char chunk[4096];
+  ssize_t n;
+  lseek (g_histogramFd, 0, SEEK_SET);
+  while ((n = read (g_histogramFd, chunk, sizeof (chunk))) > 0)
+    {
+      text.append (chunk, n);
+    }
+
+  std::map<std::string, LatencyHistogram> merged;
+  std::istringstream lines (text);
+  std::string line;
+  while (std::getline (lines, line))
+    {
+      std::istringstream is (line);
+      std::string destination;
+      LatencyHistogram histogram;
+      if (!(is >> destination) || !histogram.Deserialize (is))
+        {
+          std::cerr << "Skipping a malformed RTT histogram line" << std::endl;
+          continue;
+        }
+      merged[destination].Merge (histogram);
+    }
+  if (merged.empty ())
+    {
+      return;
+    }
+
+  std::cout << std::left << std::setw (28) << "RTT to" << std::right << std::setw (9) << "samples"
+            << std::setw (12) << "p50 us" << std::setw (12) << "p99 us" << std::setw (12) << "p99.9 us"
+            << std::setw (12) << "max us" << std::endl;
+  for (std::map<std::string, LatencyHistogram>::const_iterator it = merged.begin (); it != merged.end (); it++)
+    {
+      LatencyHistogram const &h = it->second;
+      std::cout << std::left << std::setw (28) << it->first << std::right << std::setw (9) << h.GetCount ()
+                << std::fixed << std::setprecision (3)
+                << std::setw (12) << h.GetPercentile (50).GetNanoSeconds () / 1e3
+                << std::setw (12) << h.GetPercentile (99).GetNanoSeconds () / 1e3
+                << std::setw (12) << h.GetPercentile (99.9).GetNanoSeconds () / 1e3
+                << std::setw (12) << h.GetMax ().GetNanoSeconds () / 1e3 << std::endl;
+    }
+}
+
+/**
+ * \brief One test case run, as a worker process.
+ */
+struct Job
+{
+  uint32_t index;    //!< case index
+  uint32_t run;      //!< RNG run number
+  uint32_t link;     //!< link parameters index
+  std::string name;  //!< case name, and link parameters
+  pid_t pid;         //!< worker process, 0 once reaped
+  FILE *output;      //!< what the worker printed
+  uint64_t start;    //!< fork time
+  uint64_t elapsed;  //!< worker wall time in nanoseconds
+  double cpu;        //!< worker CPU time in seconds
+  int status;        //!< worker wait status
+};
+
+/**
+ * \brief Run every job in a worker process, at most workers at a time.
+ *
+ * The simulator is a process-wide singleton, so the cases can't share a
+ * process the way threads would; each gets a fresh copy of this one. A
+ * worker's stdout and stderr go to a temporary file, read back in job
+ * order for the report instead of interleaving on the terminal.
+ *
+ * \param jobs the jobs, receiving their outcome
+ * \param workers largest number of workers running at once
+ * \returns the wall time of the whole matrix in nanoseconds
+ */
+uint64_t
+RunForked (std::vector<Job> &jobs, uint32_t workers)
+{
+  std::fflush (stdout);
+  std::cout.flush ();
+  uint64_t start = NowNs ();
+  uint32_t next = 0;
+  uint32_t running = 0;
+  while (next < jobs.size () || running > 0)
+    {
+      while (running < workers && next < jobs.size ())
+        {
+          Job &job = jobs[next++];
+          job.output = std::tmpfile ();
+          NS_ABORT_MSG_UNLESS (job.output != 0, "Cannot create the output file of " << job.name);
+          job.start = NowNs ();
+          job.pid = fork ();
+          NS_ABORT_MSG_IF (job.pid < 0, "Cannot fork the worker of " << job.name);
+          if (job.pid == 0)
+            {
+              dup2 (fileno (job.output), STDOUT_FILENO);
+              dup2 (fileno (job.output), STDERR_FILENO);
+              RunCase (job.index, job.run, job.link);
+              int golden = CheckDigest (job.name, job.run);
+              SaveHistograms ();
+              SaveEvents (job.name, job.run);
+              std::cout.flush ();
+              std::fflush (stdout);
+              _exit (golden);
+            }
+          running++;
+        }
+
+      int status;
+      struct rusage usage;
+      pid_t pid = wait4 (-1, &status, 0, &usage);
+      NS_ABORT_MSG_IF (pid < 0, "wait4 failed with workers still running");
+      for (uint32_t k = 0; k < next; k++)
+        {
+          Job &job = jobs[k];
+          if (job.pid == pid)
+            {
+              job.elapsed = NowNs () - job.start;
+              job.cpu = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+                + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+              job.status = status;
+              job.pid = 0;
+              running--;
+              break;
+            }
+        }
+    }
+  return NowNs () - start;
+}
+
+/**
+ * \param status a wait status
+ * \returns "ok", "unchecked" if it had no golden digest, or how the worker failed
+ */
+std::string
+GetStatusText (int status)
+{
+  std::ostringstream os;
+  if (WIFEXITED (status) && WEXITSTATUS (status) == 0)
+    {
+      os << "ok";
+    }
+  else if (WIFEXITED (status) && WEXITSTATUS (status) == DIGEST_MISMATCH)
+    {
+      os << "mismatch";
+    }
+  else if (WIFEXITED (status) && WEXITSTATUS (status) == DIGEST_UNCHECKED)
+    {
+      os << "unchecked";
+    }
+  else if (WIFEXITED (status))
+    {
+      os << "exit " << WEXITSTATUS (status);
+    }
+  else
+    {
+      os << "signal " << WTERMSIG (status);
+    }
+  return os.str ();
+}
+
+/**
+ * \brief Print the merged report of a matrix run.
+ * \param jobs the finished jobs
+ * \param logs whether to print what each case printed
+ * \param unchecked set to the number of jobs without a golden digest
+ * \returns the number of failed jobs
+ */
+uint32_t
+PrintReport (std::vector<Job> &jobs, bool logs, uint32_t &unchecked)
+{
+  uint32_t failed = 0;
+  unchecked = 0;
+  if (logs)
+    {
+      for (uint32_t k = 0; k < jobs.size (); k++)
+        {
+          std::cout << "==== " << jobs[k].name << ", run " << jobs[k].run << std::endl;
+          std::rewind (jobs[k].output);
+          char chunk[4096];
+          size_t n;
+          while ((n = std::fread (chunk, 1, sizeof (chunk), jobs[k].output)) > 0)
+            {
+              std::cout.write (chunk, n);
+            }
+        }
+    }
+  std::cout << std::left << std::setw (44) << "case" << std::right << std::setw (6) << "run"
+            << std::setw (12) << "status" << std::setw (12) << "wall ms" << std::setw (12) << "cpu ms" << std::endl;
+  for (uint32_t k = 0; k < jobs.size (); k++)
+    {
+      Job &job = jobs[k];
+      std::string status = GetStatusText (job.status);
+      unchecked += status == "unchecked";
+      failed += status != "ok" && status != "unchecked";
+      std::cout << std::left << std::setw (44) << job.name << std::right << std::setw (6) << job.run
+                << std::setw (12) << status << std::fixed << std::setprecision (1)
+                << std::setw (12) << job.elapsed / 1e6 << std::setw (12) << job.cpu * 1e3 << std::endl;
+      std::fclose (job.output);
+      job.output = 0;
+    }
+  return failed;
+}
+
+
+/**
+ * \brief Run the matrix in this process, probing one shared topology.
+ *
+ * The 3-node chain is built once and reset between probes; the cases
+ * that need another topology run afterwards with their own DoRun. The
+ * topology's random streams are drawn when it is built, so the matrix
+ * must hold a single RNG run and a single set of link parameters, as
+ * main enforces; the topology is built with those. The trace digests are kept apart from those of the
+ * forked cases: the probes share a topology, and the cases on their own
+ * topology follow others in this process, so they draw other random
+ * stream numbers and MAC addresses than in a fresh one.
+ *
+ * \param jobs the jobs
+ * \param unchecked set to the number of digests without a golden value
+ * \returns the number of trace digest mismatches
+ */
+uint32_t
+RunShared (std::vector<Job> &jobs, uint32_t &unchecked)
+{
+  uint32_t mismatches = 0;
+  unchecked = 0;
+  RngSeedManager::SetRun (1);
+  SelectLink (g_links[0]);
+  IcmpTopology topology (IcmpTopology::CHAIN, 3);
+  topology.SetChannel (g_channel);
+  topology.Build ();
+  uint64_t probes = 0;
+  bool first = true;
+  for (uint32_t k = 0; k < jobs.size (); k++)
+    {
+      if (CASES[jobs[k].index].probe == 0)
+        {
+          continue;
+        }
+      uint64_t start = NowNs ();
+      if (!first)
+        {
+          topology.Reset ();
+        }
+      first = false;
+      CASES[jobs[k].index].probe (topology);
+      jobs[k].elapsed = NowNs () - start;
+      probes += jobs[k].elapsed;
+      int golden = CheckDigest ("shared " + jobs[k].name, jobs[k].run);
+      mismatches += golden == DIGEST_MISMATCH;
+      unchecked += golden == DIGEST_UNCHECKED;
+    }
+  Simulator::Destroy ();
+
+  uint64_t own = 0;
+  for (uint32_t k = 0; k < jobs.size (); k++)
+    {
+      if (CASES[jobs[k].index].probe == 0)
+        {
+          uint64_t start = NowNs ();
+          RunCase (jobs[k].index, jobs[k].run, jobs[k].link);
+          jobs[k].elapsed = NowNs () - start;
+          own += jobs[k].elapsed;
+          int golden = CheckDigest ("shared " + jobs[k].name, jobs[k].run);
+          mismatches += golden == DIGEST_MISMATCH;
+          unchecked += golden == DIGEST_UNCHECKED;
+        }
+    }
+
+  std::cout << std::left << std::setw (44) << "case" << std::right << std::setw (6) << "run"
+            << std::setw (16) << "topology" << std::setw (12) << "wall ms" << std::endl;
+  for (uint32_t k = 0; k < jobs.size (); k++)
+    {
+      std::cout << std::left << std::setw (44) << jobs[k].name << std::right << std::setw (6) << jobs[k].run
+                << std::setw (16) << (CASES[jobs[k].index].probe != 0 ? "shared" : "own")
+                << std::fixed << std::setprecision (1) << std::setw (12) << jobs[k].elapsed / 1e6 << std::endl;
+    }
+  std::cout << std::fixed << std::setprecision (1)
+            << "shared topology: setup " << topology.GetSetupSeconds () * 1e3 << " ms once, probes "
+            << probes / 1e6 << " ms; own topologies " << own / 1e6 << " ms, setup included" << std::endl;
+  return mismatches;
+}
+
+/**
+ * \brief Run a sweep job in a process of its own and append its result line.
+ *
+ * The case runs in a fork of the worker: ns-3 numbers the streams of its
+ * random variables from a process-wide counter, so a case gives the same
+ * results for the same run and link parameters only when it starts from
+ * a fresh process, whatever the worker ran before. The case sends its
+ * counters back through a pipe; the worker adds its exit status, wall
+ * and CPU time and appends the line to the result file with a single
+ * write, so the lines of concurrent workers do not interleave.
+ *
+ * \param job the job
+ * \param number the job number, first column of the line
+ * \param fd the result file, opened with O_APPEND
+ */
+void
+SweepJob (Job const &job, uint32_t number, int fd)
+{
+  int counters[2];
+  NS_ABORT_MSG_IF (pipe (counters) != 0, "Cannot create the counter pipe of " << job.name);
+  uint64_t start = NowNs ();
+  pid_t pid = fork ();
+  NS_ABORT_MSG_IF (pid < 0, "Cannot fork " << job.name);
+  if (pid == 0)
+    {
+      close (counters[0]);
+      RunCase (job.index, job.run, job.link);
+      uint64_t digest = g_digest.GetDigest ();
+      uint64_t delivered = g_digest.GetPackets ();
+      int golden = CheckDigest (job.name, job.run);
+      LatencyHistogram rtt;
+      for (std::map<std::string, LatencyHistogram>::const_iterator it = g_rtt.begin (); it != g_rtt.end (); it++)
+        {
+          rtt.Merge (it->second);
+        }
+      std::ostringstream os;
+      os << g_sent << " " << g_received << " " << delivered << " " << g_dropped << " " << rtt.GetCount ()
+         << std::fixed << std::setprecision (3) << " " << rtt.GetPercentile (50).GetNanoSeconds () / 1e3
+         << " " << rtt.GetMax ().GetNanoSeconds () / 1e3 << " " << TraceDigest::ToString (digest);
+      SaveHistograms ();
+      SaveEvents (job.name, job.run);
+      std::string text = os.str ();
+      if (write (counters[1], text.data (), text.size ()) != static_cast<ssize_t> (text.size ()))
+        {
+          std::cerr << "Cannot send the counters of " << job.name << std::endl;
+        }
+      std::cout.flush ();
+      std::fflush (stdout);
+      _exit (golden);
+    }
+
+  close (counters[1]);
+  std::string counted;
+  char chunk[256];
+  ssize_t n;
+  while ((n = read (counters[0], chunk, sizeof (chunk))) > 0)
+    {
+      counted.append (chunk, n);
+    }
+  close (counters[0]);
+  int status;
+  struct rusage usage;
+  NS_ABORT_MSG_IF (wait4 (pid, &status, 0, &usage) != pid, "Lost the process of " << job.name);
+  if (counted.empty ())
+    {
+      // the case died before sending anything
+      counted = "0 0 0 0 0 0.000 0.000 -";
+    }
+  std::string statusText = GetStatusText (status);
+  std::replace (statusText.begin (), statusText.end (), ' ', '_');
+  double cpu = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+    + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+
+  Link const &link = g_links[job.link];
+  std::ostringstream line;
+  line << number << " " << job.run << " " << link.loss << " " << link.delay << " " << link.jitter
+       << " " << statusText << " " << counted << std::fixed << std::setprecision (3)
+       << " " << (NowNs () - start) / 1e6 << " " << cpu * 1e3 << " " << CASES[job.index].name () << "\n";
+  std::string text = line.str ();
+  if (write (fd, text.data (), text.size ()) != static_cast<ssize_t> (text.size ()))
+    {
+      std::cerr << "Cannot append the result of " << job.name << std::endl;
+    }
+}
+
+/**
+ * \brief Run every job on a pool of worker processes sharing a JobQueue.
+ *
+ * One worker is forked per core asked for; each takes jobs from the
+ * queue, stealing from the others once its own block is done, and runs
+ * them with SweepJob until none is left. What the cases print is
+ * discarded, their results are the lines of the result file.
+ *
+ * \param jobs the jobs
+ * \param workers number of worker processes
+ * \param fd the result file, opened with O_APPEND
+ * \param steals set to the number of steals
+ * \returns the wall time of the sweep in nanoseconds
+ */
+uint64_t
+RunSweep (std::vector<Job> const &jobs, uint32_t workers, int fd, uint64_t &steals)
+{
+  std::fflush (stdout);
+  std::cout.flush ();
+  uint64_t start = NowNs ();
+  JobQueue queue (jobs.size (), workers);
+  for (uint32_t w = 0; w < workers; w++)
+    {
+      pid_t pid = fork ();
+      NS_ABORT_MSG_IF (pid < 0, "Cannot fork sweep worker " << w);
+      if (pid == 0)
+        {
+          int null = open ("/dev/null", O_WRONLY);
+          dup2 (null, STDOUT_FILENO);
+          close (null);
+          uint32_t k;
+          while (queue.Take (w, k))
+            {
+              SweepJob (jobs[k], k, fd);
+            }
+          _exit (0);
+        }
+    }
+  int status;
+  while (wait (&status) > 0)
+    {
+      if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+        {
+          std::cerr << "A sweep worker failed (" << GetStatusText (status) << "), its jobs may lack results"
+                    << std::endl;
+        }
+    }
+  steals = queue.GetSteals ();
+  return NowNs () - start;
+}
+
+/**
+ * \brief Aggregate the result file of a sweep per case and link parameters, and print it.
+ * \param fd the result file
+ * \param unchecked set to the number of runs without a golden digest
+ * \returns the number of failed runs
+ */
+uint32_t
+PrintSweep (int fd, uint32_t &unchecked)
+{
+  std::string text;
+  char chunk[4096];
+  ssize_t n;
+  lseek (fd, 0, SEEK_SET);
+  while ((n = read (fd, chunk, sizeof (chunk))) > 0)
+    {
+      text.append (chunk, n);
+    }
+
+  /// Totals of the runs of a case with some link parameters.
+  struct Summary
+  {
+    uint32_t runs;     //!< runs
+    uint32_t failed;   //!< runs that failed, a missing golden digest aside
+    uint64_t sent;     //!< packets the case sockets sent
+    uint64_t received; //!< packets the case sockets received
+    uint64_t dropped;  //!< packets the links dropped
+    uint32_t timed;    //!< runs with RTT samples
+    double p50;        //!< sum of the median RTTs of those runs, in us
+    double max;        //!< largest RTT, in us
+    double wall;       //!< sum of the run wall times, in ms
+  };
+  std::map<std::pair<std::string, std::string>, Summary> summaries;
+  std::istringstream lines (text);
+  std::string line;
+  uint32_t failed = 0;
+  unchecked = 0;
+  while (std::getline (lines, line))
+    {
+      if (line.empty () || line[0] == '#')
+        {
+          continue;
+        }
+      std::istringstream is (line);
+      uint32_t job, run, samples;
+      std::string loss, delay, jitter, status, digest, name;
+      uint64_t sent, received, delivered, dropped;
+      double p50, max, wall, cpu;
+      if (!(is >> job >> run >> loss >> delay >> jitter >> status >> sent >> received >> delivered >> dropped
+               >> samples >> p50 >> max >> digest >> wall >> cpu) || !std::getline (is >> std::ws, name))
+        {
+          std::cerr << "Skipping the malformed result line \"" << line << "\"" << std::endl;
+          continue;
+        }
+      std::map<std::pair<std::string, std::string>, Summary>::iterator it =
+        summaries.insert (std::make_pair (std::make_pair (name, loss + " " + delay + " " + jitter), Summary ())).first;
+      Summary &s = it->second;
+      s.runs++;
+      bool ok = status == "ok" || status == "unchecked";
+      s.failed += !ok;
+      failed += !ok;
+      unchecked += status == "unchecked";
+      s.sent += sent;
+      s.received += received;
+      s.dropped += dropped;
+      if (samples > 0)
+        {
+          s.timed++;
+          s.p50 += p50;
+          s.max = std::max (s.max, max);
+        }
+      s.wall += wall;
+    }
+
+  std::cout << std::left << std::setw (44) << "case" << std::right << std::setw (8) << "loss"
+            << std::setw (10) << "delay us" << std::setw (11) << "jitter us" << std::setw (6) << "runs"
+            << std::setw (8) << "failed" << std::setw (11) << "recv/sent" << std::setw (11) << "drops/run"
+            << std::setw (12) << "p50 us" << std::setw (12) << "max us" << std::setw (12) << "wall ms" << std::endl;
+  for (std::map<std::pair<std::string, std::string>, Summary>::const_iterator it = summaries.begin ();
+       it != summaries.end (); it++)
+    {
+      Summary const &s = it->second;
+      std::istringstream link (it->first.second);
+      std::string loss, delay, jitter;
+      link >> loss >> delay >> jitter;
+      std::cout << std::left << std::setw (44) << it->first.first << std::right << std::setw (8) << loss
+                << std::setw (10) << delay << std::setw (11) << jitter << std::setw (6) << s.runs
+                << std::setw (8) << s.failed << std::fixed << std::setprecision (3)
+                << std::setw (11) << (s.sent > 0 ? static_cast<double> (s.received) / s.sent : 0)
+                << std::setw (11) << static_cast<double> (s.dropped) / s.runs
+                << std::setw (12) << (s.timed > 0 ? s.p50 / s.timed : 0) << std::setw (12) << s.max
+                << std::setprecision (1) << std::setw (12) << s.wall / s.runs << std::endl;
+    }
+  return failed;
+}
+
+} // anonymous namespace
+
+int main (int argc, char *argv[])
+{
+  uint32_t jobs = sysconf (_SC_NPROCESSORS_ONLN);
+  uint32_t runs = 1;
+  std::string filter;
+  bool logs = true;
+  bool compare = false;
+  bool shared = false;
+  std::string histograms;
+  bool quiet = false;
+  std::string events = "icmp-events.bin";
+  uint32_t eventCapacity = 65536;
+  std::string golden = "scratch/icmp-test.golden";
+  bool record = false;
+  std::string loss = "0";
+  std::string delay = "0";
+  std::string jitter = "0";
+  std::string results;
+
+  CommandLine cmd;
+  cmd.AddValue ("jobs", "Worker processes running at once, 0 to run the cases in this process", jobs);
+  cmd.AddValue ("runs", "RNG runs of each case, each one a separate job", runs);
+  cmd.AddValue ("case", "Run only the cases whose name contains this text", filter);
+  cmd.AddValue ("logs", "Print what each case printed in the report", logs);
+  cmd.AddValue ("compare", "Also run the matrix with a single worker and report the measured speedup", compare);
+  cmd.AddValue ("shared", "Run the matrix in this process against one shared topology", shared);
+  cmd.AddValue ("histograms", "File the RTT histograms are appended to and merged from, across invocations", histograms);
+  cmd.AddValue ("quiet", "Log the packets in binary to the events file instead of printing them", quiet);
+  cmd.AddValue ("events", "Event log of quiet mode, read back by icmp-event-decode", events);
+  cmd.AddValue ("golden", "Golden trace digests, one \"<digest> <run> <case>\" line each; a digest missing from it makes the run exit with status 4", golden);
+  cmd.AddValue ("record", "Write the trace digests to the golden file instead of checking them", record);
+  cmd.AddValue ("eventCapacity", "Events each process keeps in quiet mode, the oldest ones are dropped past it", eventCapacity);
+  cmd.AddValue ("loss", "Comma-separated link loss rates, every case runs with each", loss);
+  cmd.AddValue ("delay", "Comma-separated link delays in microseconds, every case runs with each", delay);
+  cmd.AddValue ("jitter", "Comma-separated largest link jitters in microseconds, every case runs with each", jitter);
+  cmd.AddValue ("results", "Sweep the matrix on a work-stealing worker pool, one result line per run in this file", results);
+  cmd.Parse (argc, argv);
+
+  std::vector<double> losses = ParseList (loss, "loss");
+  std::vector<double> delays = ParseList (delay, "delay");
+  std::vector<double> jitters = ParseList (jitter, "jitter");
+  for (uint32_t l = 0; l < losses.size (); l++)
+    {
+      NS_ABORT_MSG_UNLESS (losses[l] <= 1, "A loss rate of " << losses[l]);
+      for (uint32_t d = 0; d < delays.size (); d++)
+        {
+          for (uint32_t j = 0; j < jitters.size (); j++)
+            {
+              Link link = { losses[l], static_cast<uint32_t> (delays[d]), static_cast<uint32_t> (jitters[j]) };
+              g_links.push_back (link);
+            }
+        }
+    }
+  NS_ABORT_MSG_IF (shared && g_links.size () > 1, "The shared topology runs with a single set of link parameters");
+  NS_ABORT_MSG_IF (shared && runs > 1, "The shared topology is built once, with RNG run 1");
+
+  printf("\n\t Início das simulações\n\n");
+
+  if (quiet)
+    {
+      // no printing metadata: the packets are logged as bytes and decoded later
+      g_events = new IcmpEventLog (eventCapacity);
+      g_eventsFd = open (events.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+      NS_ABORT_MSG_IF (g_eventsFd < 0, "Cannot open the event log " << events);
+    }
+  else
+    {
+      Packet::EnablePrinting();
+    }
+
+  if (histograms.empty ())
+    {
+      FILE *scratch = std::tmpfile ();
+      g_histogramFd = scratch ? fileno (scratch) : -1;
+    }
+  else
+    {
+      g_histogramFd = open (histograms.c_str (), O_RDWR | O_CREAT, 0644);
+    }
+  NS_ABORT_MSG_IF (g_histogramFd < 0, "Cannot open the RTT histogram file " << histograms);
+  fcntl (g_histogramFd, F_SETFL, O_APPEND);
+
+  if (record)
+    {
+      g_goldenFd = open (golden.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+      NS_ABORT_MSG_IF (g_goldenFd < 0, "Cannot write the golden file " << golden);
+    }
+  else
+    {
+      LoadGolden (golden);
+    }
+
+  std::vector<Job> matrix;
+  for (uint32_t index = 0; index < sizeof (CASES) / sizeof (CASES[0]); index++)
+    {
+      std::string name = CASES[index].name ();
+      if (name.find (filter) == std::string::npos)
+        {
+          continue;
+        }
+      for (uint32_t link = 0; link < g_links.size (); link++)
+        {
+          for (uint32_t run = 1; run <= runs; run++)
+            {
+              Job job = { index, run, link, name + GetLinkName (g_links[link]), 0, 0, 0, 0, 0, 0 };
+              matrix.push_back (job);
+            }
+        }
+    }
+
+  if (shared)
+    {
+      uint32_t unchecked;
+      uint32_t mismatches = RunShared (matrix, unchecked);
+      SaveHistograms ();
+      SaveEvents ("shared", 0);
+      PrintHistograms ();
+      PrintUnchecked (unchecked);
+      printf("\n\t Fim das simulações\n");
+      return GetExitStatus (mismatches, unchecked);
+    }
+  if (!results.empty ())
+    {
+      int fd = open (results.c_str (), O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0644);
+      NS_ABORT_MSG_IF (fd < 0, "Cannot open the result file " << results);
+      std::string header = "# job run loss delay_us jitter_us status sent received delivered dropped"
+        " rtt_samples rtt_p50_us rtt_max_us digest wall_ms cpu_ms case\n";
+      NS_ABORT_MSG_IF (write (fd, header.data (), header.size ()) != static_cast<ssize_t> (header.size ()),
+                       "Cannot write the result file " << results);
+      uint32_t workers = std::max<uint32_t> (jobs, 1);
+      uint64_t steals;
+      uint64_t wall = RunSweep (matrix, workers, fd, steals);
+      uint32_t unchecked;
+      uint32_t failed = PrintSweep (fd, unchecked);
+      close (fd);
+      PrintHistograms ();
+      PrintUnchecked (unchecked);
+      std::cout << std::fixed << std::setprecision (1)
+                << matrix.size () << " runs, " << failed << " failed, " << workers << " workers, "
+                << steals << " steals: " << wall / 1e6 << " ms wall, " << std::setprecision (0)
+                << matrix.size () / (wall / 1e9) << " runs/s; results in " << results << std::endl;
+      printf("\n\t Fim das simulações\n");
+      return GetExitStatus (failed, unchecked);
+    }
+  if (jobs == 0)
+    {
+      // the cases after the first draw other random stream numbers and MAC
+      // addresses than in a fresh process: key their digests apart, as in
+      // shared mode
+      uint32_t mismatches = 0;
+      uint32_t unchecked = 0;
+      for (uint32_t k = 0; k < matrix.size (); k++)
+        {
+          RunCase (matrix[k].index, matrix[k].run, matrix[k].link);
+          int golden = CheckDigest ("serial " + matrix[k].name, matrix[k].run);
+          mismatches += golden == DIGEST_MISMATCH;
+          unchecked += golden == DIGEST_UNCHECKED;
+          SaveEvents (matrix[k].name, matrix[k].run);
+        }
+      SaveHistograms ();
+      PrintHistograms ();
+      PrintUnchecked (unchecked);
+      printf("\n\t Fim das simulações\n");
+      return GetExitStatus (mismatches, unchecked);
+    }
+
+  uint64_t serial = 0;
+  if (compare)
+    {
+      std::vector<Job> baseline = matrix;
+      g_saveRecords = false;
+      serial = RunForked (baseline, 1);
+      g_saveRecords = true;
+      for (uint32_t k = 0; k < baseline.size (); k++)
+        {
+          std::fclose (baseline[k].output);
+        }
+    }
+  uint64_t wall = RunForked (matrix, jobs);
+  uint32_t unchecked;
+  uint32_t failed = PrintReport (matrix, logs, unchecked);
+  PrintHistograms ();
+  PrintUnchecked (unchecked);
+
+  uint64_t workers = 0;
+  double cpu = 0;
+  for (uint32_t k = 0; k < matrix.size (); k++)
+    {
+      workers += matrix[k].elapsed;
+      cpu += matrix[k].cpu;
+    }
+  std::cout << std::fixed << std::setprecision (1)
+            << matrix.size () << " jobs, " << failed << " failed, " << jobs << " workers: "
+            << wall / 1e6 << " ms wall, " << workers / 1e6 << " ms summed over workers, "
+            << cpu * 1e3 << " ms cpu, " << std::setprecision (2)
+            << static_cast<double> (workers) / wall << "x concurrency" << std::endl;
+  if (compare)
+    {
+      std::cout << "single worker " << std::setprecision (1) << serial / 1e6 << " ms wall, speedup "
+                << std::setprecision (2) << static_cast<double> (serial) / wall << "x" << std::endl;
+    }
+
+  printf("\n\t Fim das simulações\n");
+  return GetExitStatus (failed, unchecked);
+}